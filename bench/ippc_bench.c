@@ -0,0 +1,530 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <dirent.h>
+#include <jxl/decode.h>
+
+#include "config_loader.h"
+#include "config_codec.h"
+#include "corpus.h"
+#include "ippc_params.h"
+#include "metadata.pb-c.h"
+#include "png_encode.h"
+
+/*
+ * Micro benchmarks of the CPU side of ippc and ippb: YAML loading,
+ * protobuf packing, brotli compression, metadata unpacking, JXL decoding
+ * and PNG encoding.
+ *
+ * Inputs are generated in memory so the numbers exclude disk and link.
+ * Every result is one line "<name> <bytes> <iterations> <ns/op> <MB/s>",
+ * where bytes is the uncompressed size handled by one operation. With
+ * --csv the same columns are printed comma separated after a header.
+ *
+ * With --corpus, the ring entries of a directory written by ippc_corpus
+ * are also unpacked and decoded as ippb does.
+ *
+ * Usage: ippc_bench [--csv] [--corpus DIR] [iterations]
+ */
+
+#define CORPUS_ENTRIES_MAX 256
+
+typedef int (*bench_fn_t)(void *ctx);
+
+typedef struct
+{
+	const char *yaml;
+	size_t size;
+	const char *schema;
+	int module;
+} yaml_bench_t;
+
+typedef struct
+{
+	PipelineDefinition pipeline;
+	ModuleConfig module_config;
+	uint8_t *packed;
+	size_t packed_size;
+	uint8_t *out;
+	size_t out_size;
+} config_bench_t;
+
+typedef struct
+{
+	uint8_t *jxl;
+	size_t jxl_size;
+	uint8_t *pixels;
+	int width;
+	int height;
+	int channels;
+} image_bench_t;
+
+typedef struct
+{
+	image_bench_t images[CORPUS_ENTRIES_MAX];
+	config_bench_t metadata[CORPUS_ENTRIES_MAX];
+	uint8_t *entries[CORPUS_ENTRIES_MAX];
+	int count;
+	size_t metadata_bytes;
+	size_t pixel_bytes;
+} corpus_bench_t;
+
+static int csv = 0;
+
+static int bench_yaml(void *ctx)
+{
+	yaml_bench_t *bench = ctx;
+	config_arena_t *arena = config_arena_create();
+	if (arena == NULL)
+		return -1;
+
+	int ret;
+	if (bench->module)
+	{
+		ModuleConfig module_config = MODULE_CONFIG__INIT;
+		ret = config_load_module_string(bench->yaml, bench->size, arena, &module_config, bench->schema);
+	}
+	else
+	{
+		PipelineDefinition pipeline = PIPELINE_DEFINITION__INIT;
+		ret = config_load_pipeline_string(bench->yaml, bench->size, arena, &pipeline);
+	}
+	config_arena_destroy(arena);
+	return ret;
+}
+
+static int bench_pipeline_pack(void *ctx)
+{
+	config_bench_t *bench = ctx;
+	return pipeline_definition__pack(&bench->pipeline, bench->packed) == bench->packed_size ? 0 : -1;
+}
+
+static int bench_module_pack(void *ctx)
+{
+	config_bench_t *bench = ctx;
+	return module_config__pack(&bench->module_config, bench->packed) == bench->packed_size ? 0 : -1;
+}
+
+static int bench_compress(void *ctx)
+{
+	config_bench_t *bench = ctx;
+	size_t out_size = bench->out_size;
+	return config_encode_payload(bench->packed, bench->packed_size, 0, bench->out, &out_size);
+}
+
+static int bench_metadata_unpack(void *ctx)
+{
+	config_bench_t *bench = ctx;
+	Metadata *meta = metadata__unpack(NULL, bench->packed_size, bench->packed);
+	if (meta == NULL)
+		return -1;
+	metadata__free_unpacked(meta, NULL);
+	return 0;
+}
+
+static int bench_jxl_decode(void *ctx)
+{
+	image_bench_t *bench = ctx;
+	JxlDecoder *decoder = JxlDecoderCreate(NULL);
+	JxlPixelFormat format = {bench->channels, JXL_TYPE_UINT8, JXL_NATIVE_ENDIAN, 0};
+	size_t size = (size_t)bench->width * bench->height * bench->channels;
+	int ret = -1;
+
+	if (decoder == NULL || JxlDecoderSubscribeEvents(decoder, JXL_DEC_FULL_IMAGE) != JXL_DEC_SUCCESS ||
+		JxlDecoderSetInput(decoder, bench->jxl, bench->jxl_size) != JXL_DEC_SUCCESS)
+	{
+		JxlDecoderDestroy(decoder);
+		return -1;
+	}
+	while (1)
+	{
+		JxlDecoderStatus status = JxlDecoderProcessInput(decoder);
+		if (status == JXL_DEC_NEED_IMAGE_OUT_BUFFER)
+		{
+			if (JxlDecoderSetImageOutBuffer(decoder, &format, bench->pixels, size) != JXL_DEC_SUCCESS)
+				break;
+		}
+		else
+		{
+			ret = status == JXL_DEC_FULL_IMAGE || status == JXL_DEC_SUCCESS ? 0 : -1;
+			break;
+		}
+	}
+	JxlDecoderDestroy(decoder);
+	return ret;
+}
+
+static int bench_png_encode(void *ctx)
+{
+	image_bench_t *bench = ctx;
+	int png_size = 0;
+	uint8_t *png = png_encode(bench->pixels, bench->width, bench->height, bench->channels, &png_size);
+	free(png);
+	return png != NULL ? 0 : -1;
+}
+
+static char *generate_pipeline(int modules)
+{
+	size_t cap = 64 * (size_t)modules + 1;
+	char *yaml = malloc(cap);
+	size_t len = 0;
+	for (int i = 0; i < modules; i++)
+		len += snprintf(yaml + len, cap - len, "- order: %d\n  name: module_%d\n  param_id: %d\n", i + 1, i, i % MAX_MODULES + 1);
+	return yaml;
+}
+
+static char *generate_module(int params)
+{
+	size_t cap = 96 * (size_t)params + 1;
+	char *yaml = malloc(cap);
+	size_t len = 0;
+	for (int i = 0; i < params; i++)
+	{
+		switch (i % 4)
+		{
+			case 0:
+				len += snprintf(yaml + len, cap - len, "- key: flag_%d\n  type: 2\n  value: true\n", i);
+				break;
+			case 1:
+				len += snprintf(yaml + len, cap - len, "- key: count_%d\n  type: 3\n  value: %d\n", i, i * 7);
+				break;
+			case 2:
+				len += snprintf(yaml + len, cap - len, "- key: gain_%d\n  type: 4\n  value: %d.25\n", i, i);
+				break;
+			default:
+				len += snprintf(yaml + len, cap - len, "- key: label_%d\n  type: 5\n  value: channel_%d\n", i, i);
+				break;
+		}
+	}
+	return yaml;
+}
+
+/* Packed metadata of a jxl observation with a few custom items */
+static uint8_t *generate_metadata(size_t *size)
+{
+	MetadataItem enc = METADATA_ITEM__INIT;
+	enc.key = "enc";
+	enc.value_case = METADATA_ITEM__VALUE_STRING_VALUE;
+	enc.string_value = "jxl";
+	MetadataItem exposure = METADATA_ITEM__INIT;
+	exposure.key = "exposure_us";
+	exposure.value_case = METADATA_ITEM__VALUE_INT_VALUE;
+	exposure.int_value = 12000;
+	MetadataItem gain = METADATA_ITEM__INIT;
+	gain.key = "gain";
+	gain.value_case = METADATA_ITEM__VALUE_FLOAT_VALUE;
+	gain.float_value = 1.5f;
+	MetadataItem *items[] = {&enc, &exposure, &gain};
+
+	Metadata meta = METADATA__INIT;
+	meta.size = 1843200;
+	meta.width = 1280;
+	meta.height = 960;
+	meta.channels = 3;
+	meta.timestamp = 1700000000;
+	meta.bits_pixel = 8;
+	meta.camera = "vis";
+	meta.n_items = 3;
+	meta.items = items;
+
+	*size = metadata__get_packed_size(&meta);
+	uint8_t *packed = malloc(*size);
+	if (packed != NULL)
+		metadata__pack(&meta, packed);
+	return packed;
+}
+
+static double now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int run(const char *name, bench_fn_t fn, void *ctx, size_t bytes, int iterations)
+{
+	double start = now_ns();
+	for (int i = 0; i < iterations; i++)
+	{
+		if (fn(ctx) < 0)
+		{
+			printf(csv ? "%s,failed\n" : "%-24s failed\n", name);
+			return -1;
+		}
+	}
+	double elapsed = now_ns() - start;
+	double ns_op = elapsed / iterations;
+	double mb_s = bytes * (double)iterations / (elapsed / 1e9) / 1e6;
+
+	if (csv)
+		printf("%s,%zu,%d,%.0f,%.1f\n", name, bytes, iterations, ns_op, mb_s);
+	else
+		printf("%-24s %10zu %8d %14.0f %10.1f\n", name, bytes, iterations, ns_op, mb_s);
+	return 0;
+}
+
+static int run_yaml(const char *name, const char *yaml, int module, const char *schema, int iterations)
+{
+	yaml_bench_t bench = {.yaml = yaml, .size = strlen(yaml), .schema = schema, .module = module};
+	return run(name, bench_yaml, &bench, bench.size, iterations);
+}
+
+/* Pack and compress benchmarks of a pipeline or module configuration */
+static int run_config(const char *name, const char *yaml, int module, const char *schema, int iterations)
+{
+	config_bench_t bench = {.pipeline = PIPELINE_DEFINITION__INIT, .module_config = MODULE_CONFIG__INIT};
+	config_arena_t *arena = config_arena_create();
+	int ret = -1;
+	if (arena == NULL)
+		return -1;
+
+	if (module)
+	{
+		if (config_load_module_string(yaml, strlen(yaml), arena, &bench.module_config, schema) < 0)
+			goto out;
+		bench.packed_size = module_config__get_packed_size(&bench.module_config);
+	}
+	else
+	{
+		if (config_load_pipeline_string(yaml, strlen(yaml), arena, &bench.pipeline) < 0)
+			goto out;
+		bench.packed_size = pipeline_definition__get_packed_size(&bench.pipeline);
+	}
+	bench.out_size = config_encode_bound(bench.packed_size);
+	bench.packed = malloc(bench.packed_size);
+	bench.out = malloc(bench.out_size);
+	if (bench.packed == NULL || bench.out == NULL)
+		goto out;
+
+	char label[64];
+	snprintf(label, sizeof(label), "pack/%s", name);
+	ret = run(label, module ? bench_module_pack : bench_pipeline_pack, &bench, bench.packed_size, iterations);
+	snprintf(label, sizeof(label), "brotli/%s", name);
+	ret |= run(label, bench_compress, &bench, bench.packed_size, iterations / 10 + 1);
+
+out:
+	free(bench.packed);
+	free(bench.out);
+	config_arena_destroy(arena);
+	return ret;
+}
+
+static int run_image(int width, int height, int channels, int iterations)
+{
+	image_bench_t bench = {.width = width, .height = height, .channels = channels};
+	corpus_spec_t spec = {.width = width, .height = height, .channels = channels, .bits_pixel = 8, .distance = 1.0f};
+	size_t size;
+	uint8_t *source = corpus_pixels(&spec, 1, &size);
+	bench.jxl = source != NULL ? corpus_encode_jxl(source, &spec, &bench.jxl_size) : NULL;
+	bench.pixels = malloc(size);
+
+	int ret = -1;
+	if (bench.jxl != NULL && bench.pixels != NULL)
+	{
+		char label[64];
+		snprintf(label, sizeof(label), "jxl_decode/%dx%dx%d", width, height, channels);
+		ret = run(label, bench_jxl_decode, &bench, size, iterations);
+		memcpy(bench.pixels, source, size);
+		snprintf(label, sizeof(label), "png_encode/%dx%dx%d", width, height, channels);
+		ret |= run(label, bench_png_encode, &bench, size, iterations);
+	}
+	else
+		printf("Error: Could not generate %dx%dx%d image\n", width, height, channels);
+
+	free(source);
+	free(bench.jxl);
+	free(bench.pixels);
+	return ret;
+}
+
+static int bench_corpus_unpack(void *ctx)
+{
+	corpus_bench_t *bench = ctx;
+	for (int i = 0; i < bench->count; i++)
+	{
+		if (bench_metadata_unpack(&bench->metadata[i]) < 0)
+			return -1;
+	}
+	return 0;
+}
+
+static int bench_corpus_decode(void *ctx)
+{
+	corpus_bench_t *bench = ctx;
+	for (int i = 0; i < bench->count; i++)
+	{
+		if (bench->images[i].jxl != NULL && bench_jxl_decode(&bench->images[i]) < 0)
+			return -1;
+	}
+	return 0;
+}
+
+static int compare_names(const void *a, const void *b)
+{
+	return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+/* Read a ring entry and point the benchmarks at its metadata and JXL payload */
+static int load_corpus_entry(corpus_bench_t *bench, const char *path)
+{
+	FILE *fh = fopen(path, "rb");
+	if (fh == NULL)
+		return -1;
+	fseek(fh, 0, SEEK_END);
+	long size = ftell(fh);
+	fseek(fh, 0, SEEK_SET);
+	uint8_t *entry = size > (long)sizeof(uint32_t) ? malloc(size) : NULL;
+	int ok = entry != NULL && fread(entry, 1, size, fh) == (size_t)size;
+	fclose(fh);
+
+	uint32_t metadata_size = 0;
+	if (ok)
+		memcpy(&metadata_size, entry, sizeof(uint32_t));
+	Metadata *meta = ok && metadata_size <= size - sizeof(uint32_t) ? metadata__unpack(NULL, metadata_size, entry + sizeof(uint32_t)) : NULL;
+	if (meta == NULL || meta->size > size - sizeof(uint32_t) - metadata_size)
+	{
+		fprintf(stderr, "Error: %s is not a ring entry\n", path);
+		if (meta != NULL)
+			metadata__free_unpacked(meta, NULL);
+		free(entry);
+		return -1;
+	}
+
+	int i = bench->count++;
+	bench->entries[i] = entry;
+	bench->metadata[i].packed = entry + sizeof(uint32_t);
+	bench->metadata[i].packed_size = metadata_size;
+	bench->metadata_bytes += metadata_size;
+	for (size_t j = 0; j < meta->n_items; j++)
+	{
+		MetadataItem *item = meta->items[j];
+		if (strcmp(item->key, "enc") != 0 || item->value_case != METADATA_ITEM__VALUE_STRING_VALUE || strcmp(item->string_value, "jxl") != 0)
+			continue;
+		image_bench_t *image = &bench->images[i];
+		image->jxl = entry + sizeof(uint32_t) + metadata_size;
+		image->jxl_size = meta->size;
+		image->width = meta->width;
+		image->height = meta->height;
+		image->channels = meta->channels;
+		image->pixels = malloc((size_t)meta->width * meta->height * meta->channels);
+		bench->pixel_bytes += (size_t)meta->width * meta->height * meta->channels;
+	}
+	metadata__free_unpacked(meta, NULL);
+	return 0;
+}
+
+static int run_corpus(const char *dir, int iterations)
+{
+	DIR *dh = opendir(dir);
+	if (dh == NULL)
+	{
+		fprintf(stderr, "Error: Could not open corpus directory %s\n", dir);
+		return -1;
+	}
+	char *names[CORPUS_ENTRIES_MAX];
+	int name_count = 0;
+	struct dirent *dirent;
+	while ((dirent = readdir(dh)) != NULL && name_count < CORPUS_ENTRIES_MAX)
+	{
+		size_t len = strlen(dirent->d_name);
+		if (len > 6 && strcmp(dirent->d_name + len - 6, ".entry") == 0)
+			names[name_count++] = strdup(dirent->d_name);
+	}
+	closedir(dh);
+	qsort(names, name_count, sizeof(char *), compare_names);
+
+	corpus_bench_t *bench = calloc(1, sizeof(corpus_bench_t));
+	int ret = bench != NULL && name_count > 0 ? 0 : -1;
+	for (int i = 0; ret == 0 && i < name_count; i++)
+	{
+		char path[strlen(dir) + strlen(names[i]) + 2];
+		sprintf(path, "%s/%s", dir, names[i]);
+		ret = load_corpus_entry(bench, path);
+	}
+	if (ret == 0)
+	{
+		ret = run("corpus/metadata_unpack", bench_corpus_unpack, bench, bench->metadata_bytes, iterations);
+		if (bench->pixel_bytes > 0)
+			ret |= run("corpus/jxl_decode", bench_corpus_decode, bench, bench->pixel_bytes, iterations / 100 + 1);
+	}
+	else
+		fprintf(stderr, "Error: No usable entries in %s\n", dir);
+
+	for (int i = 0; i < name_count; i++)
+		free(names[i]);
+	for (int i = 0; bench != NULL && i < bench->count; i++)
+	{
+		free(bench->entries[i]);
+		free(bench->images[i].pixels);
+	}
+	free(bench);
+	return ret;
+}
+
+int main(int argc, char **argv)
+{
+	int argi = 1;
+	const char *corpus = NULL;
+	while (argi < argc && strncmp(argv[argi], "--", 2) == 0)
+	{
+		if (strcmp(argv[argi], "--csv") == 0)
+			csv = 1;
+		else if (strcmp(argv[argi], "--corpus") == 0 && argi + 1 < argc)
+			corpus = argv[++argi];
+		else
+			break;
+		argi++;
+	}
+	int iterations = argi < argc ? atoi(argv[argi]) : 2000;
+	if (iterations <= 0 || argi + 1 < argc)
+	{
+		printf("Usage: %s [--csv] [--corpus DIR] [iterations]\n", argv[0]);
+		return 1;
+	}
+
+	char *pipeline_small = generate_pipeline(8);
+	char *pipeline_large = generate_pipeline(2000);
+	char *module_small = generate_module(16);
+	char *module_large = generate_module(4000);
+	const char *module_encode = "- key: distance\n  value: 1.0\n- key: effort\n  value: 7\n- key: resampling\n  value: 1\n";
+	size_t metadata_size;
+	uint8_t *metadata = generate_metadata(&metadata_size);
+
+	if (csv)
+		printf("name,bytes,iterations,ns_per_op,mb_per_s\n");
+	else
+		printf("%-24s %10s %8s %14s %10s\n", "name", "bytes", "iters", "ns/op", "MB/s");
+
+	int ret = 0;
+	ret |= run_yaml("yaml/pipeline/8", pipeline_small, 0, NULL, iterations);
+	ret |= run_yaml("yaml/pipeline/2000", pipeline_large, 0, NULL, iterations / 100 + 1);
+	ret |= run_yaml("yaml/module/16", module_small, 1, NULL, iterations);
+	ret |= run_yaml("yaml/module/4000", module_large, 1, NULL, iterations / 100 + 1);
+	ret |= run_yaml("yaml/module/schema", module_encode, 1, "encode", iterations);
+
+	ret |= run_config("pipeline/8", pipeline_small, 0, NULL, iterations);
+	ret |= run_config("module/16", module_small, 1, NULL, iterations);
+	ret |= run_config("module/encode", module_encode, 1, "encode", iterations);
+
+	config_bench_t meta_bench = {.packed = metadata, .packed_size = metadata_size};
+	ret |= metadata != NULL ? run("metadata_unpack", bench_metadata_unpack, &meta_bench, metadata_size, iterations * 10) : -1;
+
+	static const int images[][3] = {{256, 256, 1}, {256, 256, 3}, {1024, 1024, 1}, {1024, 1024, 3}};
+	for (size_t i = 0; i < sizeof(images) / sizeof(images[0]); i++)
+	{
+		int pixels = images[i][0] * images[i][1];
+		ret |= run_image(images[i][0], images[i][1], images[i][2], iterations * 256 * 256 / pixels / 100 + 1);
+	}
+
+	if (corpus != NULL)
+		ret |= run_corpus(corpus, iterations);
+
+	free(pipeline_small);
+	free(pipeline_large);
+	free(module_small);
+	free(module_large);
+	free(metadata);
+	return ret < 0 ? 1 : 0;
+}
@@ -0,0 +1,112 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "config_bundle.h"
+#include "config_codec.h"
+
+static const uint8_t bundle_magic[4] = {'I', 'P', 'P', 'B'};
+
+int config_bundle_write(const char *filename, const config_bundle_entry_t *entries, int count)
+{
+	if (count > CONFIG_BUNDLE_MAX_ENTRIES)
+	{
+		fprintf(stderr, "Error: Bundle can hold at most %d entries\n", CONFIG_BUNDLE_MAX_ENTRIES);
+		return -1;
+	}
+
+	FILE *fh = fopen(filename, "wb");
+	if (fh == NULL)
+	{
+		fprintf(stderr, "Error: Failed to open %s for writing\n", filename);
+		return -1;
+	}
+
+	uint8_t header[6];
+	memcpy(header, bundle_magic, sizeof(bundle_magic));
+	header[4] = CONFIG_BUNDLE_VERSION;
+	header[5] = count;
+	int ok = fwrite(header, sizeof(header), 1, fh) == 1;
+
+	for (int i = 0; ok && i < count; i++)
+	{
+		const config_bundle_entry_t *entry = &entries[i];
+		uint32_t crc = config_crc32(entry->data, entry->length);
+		uint8_t entry_header[7] = {
+			entry->param_id, entry->param_id >> 8, entry->length,
+			crc, crc >> 8, crc >> 16, crc >> 24,
+		};
+		ok = fwrite(entry_header, sizeof(entry_header), 1, fh) == 1;
+		if (ok && entry->length > 0)
+			ok = fwrite(entry->data, entry->length, 1, fh) == 1;
+	}
+
+	if (fclose(fh) != 0)
+		ok = 0;
+	if (!ok)
+	{
+		fprintf(stderr, "Error: Failed to write %s\n", filename);
+		return -1;
+	}
+	return 0;
+}
+
+int config_bundle_read(const char *filename, config_bundle_entry_t *entries, int max_entries)
+{
+	FILE *fh = fopen(filename, "rb");
+	if (fh == NULL)
+	{
+		fprintf(stderr, "Error: Failed to open %s\n", filename);
+		return -1;
+	}
+
+	uint8_t header[6];
+	if (fread(header, sizeof(header), 1, fh) != 1 || memcmp(header, bundle_magic, sizeof(bundle_magic)) != 0)
+	{
+		fprintf(stderr, "Error: %s is not a configuration bundle\n", filename);
+		fclose(fh);
+		return -1;
+	}
+	if (header[4] != CONFIG_BUNDLE_VERSION)
+	{
+		fprintf(stderr, "Error: Bundle version %d is not supported\n", header[4]);
+		fclose(fh);
+		return -1;
+	}
+
+	int count = header[5];
+	if (count > max_entries)
+	{
+		fprintf(stderr, "Error: Bundle has %d entries, at most %d are supported\n", count, max_entries);
+		fclose(fh);
+		return -1;
+	}
+
+	for (int i = 0; i < count; i++)
+	{
+		config_bundle_entry_t *entry = &entries[i];
+		uint8_t entry_header[7];
+		if (fread(entry_header, sizeof(entry_header), 1, fh) != 1)
+			goto truncated;
+
+		entry->param_id = entry_header[0] | entry_header[1] << 8;
+		entry->length = entry_header[2];
+		uint32_t crc = entry_header[3] | entry_header[4] << 8 | entry_header[5] << 16 | (uint32_t)entry_header[6] << 24;
+		if (entry->length > 0 && fread(entry->data, entry->length, 1, fh) != 1)
+			goto truncated;
+
+		if (config_crc32(entry->data, entry->length) != crc)
+		{
+			fprintf(stderr, "Error: Checksum mismatch for parameter %d in %s\n", entry->param_id, filename);
+			fclose(fh);
+			return -1;
+		}
+	}
+
+	fclose(fh);
+	return count;
+
+truncated:
+	fprintf(stderr, "Error: %s is truncated\n", filename);
+	fclose(fh);
+	return -1;
+}
@@ -0,0 +1,298 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <time.h>
+#include <dirent.h>
+#include <utime.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "config_cache.h"
+#include "config_codec.h"
+#include "module_schema.h"
+
+#define CACHE_DEFAULT_MAX 64
+#define CACHE_SUFFIX ".ippc"
+
+/* Bump when parsing or packing of configurations changes the compiled buffers */
+#define CACHE_VERSION 2
+
+/* Longest report line kept with an entry */
+#define CACHE_REPORT_MAX 256
+
+static unsigned int cache_hits = 0;
+static unsigned int cache_misses = 0;
+
+static int cache_max_entries(void)
+{
+	const char *max = getenv("IPPC_CACHE_MAX");
+	if (max == NULL)
+		return CACHE_DEFAULT_MAX;
+	return atoi(max);
+}
+
+/* Join dir and name, returns -1 if the path does not fit */
+static int join_path(char *path, size_t size, const char *dir, const char *name)
+{
+	int length = snprintf(path, size, "%s/%s", dir, name);
+	return length < 0 || (size_t)length >= size ? -1 : 0;
+}
+
+/* Resolve and create the cache directory, returns -1 if unavailable */
+static int cache_dir(char *path, size_t size)
+{
+	const char *dir = getenv("IPPC_CACHE_DIR");
+	if (dir != NULL)
+	{
+		if (snprintf(path, size, "%s", dir) >= (int)size)
+			return -1;
+	}
+	else
+	{
+		const char *home = getenv("HOME");
+		if (home == NULL || join_path(path, size, home, ".cache") < 0)
+			return -1;
+		if (mkdir(path, 0755) < 0 && errno != EEXIST)
+			return -1;
+		if (join_path(path, size, home, ".cache/ippc") < 0)
+			return -1;
+	}
+	if (mkdir(path, 0755) < 0 && errno != EEXIST)
+		return -1;
+	return 0;
+}
+
+static int cache_path(uint64_t key, char *path, size_t size)
+{
+	char dir[PATH_MAX], name[32];
+	if (cache_dir(dir, sizeof(dir)) < 0)
+		return -1;
+	snprintf(name, sizeof(name), "%016llx" CACHE_SUFFIX, (unsigned long long)key);
+	return join_path(path, size, dir, name);
+}
+
+static int is_cache_entry(const char *name)
+{
+	size_t len = strlen(name);
+	return len >= strlen(CACHE_SUFFIX) && strcmp(name + len - strlen(CACHE_SUFFIX), CACHE_SUFFIX) == 0;
+}
+
+static uint64_t fnv1a(uint64_t hash, const uint8_t *data, size_t length)
+{
+	for (size_t i = 0; i < length; i++)
+	{
+		hash ^= data[i];
+		hash *= 0x100000001b3ULL;
+	}
+	return hash;
+}
+
+int config_cache_key(const char *filename, const char *settings, uint64_t *key)
+{
+	FILE *fh = fopen(filename, "rb");
+	if (fh == NULL)
+		return -1;
+
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	uint8_t chunk[4096];
+	size_t n;
+	while ((n = fread(chunk, 1, sizeof(chunk), fh)) > 0)
+		hash = fnv1a(hash, chunk, n);
+	int failed = ferror(fh);
+	fclose(fh);
+	if (failed)
+		return -1;
+
+	/* Separate content from settings so they cannot run into each other */
+	hash = fnv1a(hash, (const uint8_t *)"\0", 1);
+	hash = fnv1a(hash, (const uint8_t *)settings, strlen(settings));
+
+	/* Compilations of other builds may differ, so codec, dictionary and schema tables are part of the key */
+	uint64_t version[2] = {CACHE_VERSION, config_codec_version()};
+	size_t dict_size;
+	const uint8_t *dict = config_dictionary(&dict_size);
+	const char *schemas = module_schema_table();
+	hash = fnv1a(hash, (const uint8_t *)version, sizeof(version));
+	hash = fnv1a(hash, dict, dict_size);
+	*key = fnv1a(hash, (const uint8_t *)schemas, strlen(schemas));
+	return 0;
+}
+
+/* Cached bytes must form exactly one configuration buffer in an encoding that can be decoded */
+static int valid_entry(const uint8_t *buffer, size_t length)
+{
+	if (config_buffer_size(buffer, length) != length)
+		return 0;
+	if (buffer[0] < CONFIG_HEADER_TAGGED)
+		return 1;
+	int encoding = buffer[0] & CONFIG_HEADER_TAG_MASK;
+	return encoding == CONFIG_ENCODING_RAW || encoding == CONFIG_ENCODING_BROTLI || encoding == CONFIG_ENCODING_BROTLI_DICT;
+}
+
+int config_cache_get(uint64_t key, uint8_t *buffer, size_t size, char *report, size_t report_size)
+{
+	char path[PATH_MAX];
+	if (cache_max_entries() <= 0 || cache_path(key, path, sizeof(path)) < 0)
+		return -1;
+
+	FILE *fh = fopen(path, "rb");
+	if (fh == NULL)
+	{
+		cache_misses++;
+		return -1;
+	}
+
+	/* Entries start with the report line, followed by the buffer */
+	char line[CACHE_REPORT_MAX + 2];
+	int reported = fgets(line, sizeof(line), fh) != NULL && strchr(line, '\n') != NULL;
+	size_t length = reported ? fread(buffer, 1, size, fh) : 0;
+	int truncated = !feof(fh) && fgetc(fh) != EOF;
+	fclose(fh);
+	if (length == 0 || truncated || !valid_entry(buffer, length))
+	{
+		/* Stale, foreign or corrupt entries are never pushed */
+		remove(path);
+		cache_misses++;
+		return -1;
+	}
+	if (report != NULL && report_size > 0)
+	{
+		line[strcspn(line, "\n")] = '\0';
+		snprintf(report, report_size, "%s", line);
+	}
+
+	/* Mark entry as recently used */
+	utime(path, NULL);
+	cache_hits++;
+	return length;
+}
+
+/* Remove the least recently used entries until there is room for one more */
+static void cache_evict(const char *dir, int max_entries)
+{
+	while (1)
+	{
+		DIR *d = opendir(dir);
+		if (d == NULL)
+			return;
+
+		int count = 0;
+		struct timespec oldest_time = {0};
+		char oldest[PATH_MAX] = "";
+		struct dirent *ent;
+		while ((ent = readdir(d)) != NULL)
+		{
+			char path[PATH_MAX];
+			struct stat st;
+			if (!is_cache_entry(ent->d_name) || join_path(path, sizeof(path), dir, ent->d_name) < 0 || stat(path, &st) < 0)
+				continue;
+
+			/* Sub-second times, or entries used within the same second tie */
+			if (count == 0 || st.st_mtim.tv_sec < oldest_time.tv_sec ||
+				(st.st_mtim.tv_sec == oldest_time.tv_sec && st.st_mtim.tv_nsec < oldest_time.tv_nsec))
+			{
+				oldest_time = st.st_mtim;
+				memcpy(oldest, path, sizeof(oldest));
+			}
+			count++;
+		}
+		closedir(d);
+
+		if (count < max_entries || oldest[0] == '\0' || remove(oldest) < 0)
+			return;
+	}
+}
+
+int config_cache_put(uint64_t key, const uint8_t *buffer, size_t length, const char *report)
+{
+	if (report == NULL)
+		report = "";
+	if (strlen(report) > CACHE_REPORT_MAX || strchr(report, '\n') != NULL)
+		return -1;
+
+	int max_entries = cache_max_entries();
+	char dir[PATH_MAX], path[PATH_MAX], tmp_path[PATH_MAX];
+	if (max_entries <= 0 || cache_dir(dir, sizeof(dir)) < 0 || cache_path(key, path, sizeof(path)) < 0)
+		return -1;
+
+	/* Write to a temporary file first so readers never see partial entries */
+	if (snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path) >= (int)sizeof(tmp_path))
+		return -1;
+	if (access(path, F_OK) < 0)
+		cache_evict(dir, max_entries);
+
+	FILE *fh = fopen(tmp_path, "wb");
+	if (fh == NULL)
+		return -1;
+	int ok = fprintf(fh, "%s\n", report) > 0 && fwrite(buffer, 1, length, fh) == length;
+	if (fclose(fh) != 0 || !ok || rename(tmp_path, path) < 0)
+	{
+		remove(tmp_path);
+		return -1;
+	}
+	return 0;
+}
+
+void config_cache_list(void)
+{
+	char dir[PATH_MAX];
+	if (cache_dir(dir, sizeof(dir)) < 0)
+	{
+		printf("Cache directory unavailable\n");
+		return;
+	}
+	printf("Cache %s, max %d entries\n", dir, cache_max_entries());
+
+	DIR *d = opendir(dir);
+	if (d == NULL)
+		return;
+	time_t now = time(NULL);
+	int count = 0;
+	struct dirent *ent;
+	while ((ent = readdir(d)) != NULL)
+	{
+		char path[PATH_MAX];
+		struct stat st;
+		if (!is_cache_entry(ent->d_name) || join_path(path, sizeof(path), dir, ent->d_name) < 0 || stat(path, &st) < 0)
+			continue;
+		size_t len = strlen(ent->d_name);
+		printf("  %.*s  %4lld bytes  used %llds ago\n", (int)(len - strlen(CACHE_SUFFIX)), ent->d_name, (long long)st.st_size, (long long)(now - st.st_mtime));
+		count++;
+	}
+	closedir(d);
+
+	unsigned int lookups = cache_hits + cache_misses;
+	printf("%d entries, %u hits and %u misses this session", count, cache_hits, cache_misses);
+	if (lookups > 0)
+		printf(" (%.0f%% hit rate)", 100.0 * cache_hits / lookups);
+	printf("\n");
+}
+
+int config_cache_clear(void)
+{
+	char dir[PATH_MAX];
+	if (cache_dir(dir, sizeof(dir)) < 0)
+		return -1;
+
+	DIR *d = opendir(dir);
+	if (d == NULL)
+		return -1;
+	int removed = 0;
+	struct dirent *ent;
+	while ((ent = readdir(d)) != NULL)
+	{
+		char path[PATH_MAX];
+		if (is_cache_entry(ent->d_name) && join_path(path, sizeof(path), dir, ent->d_name) == 0 && remove(path) == 0)
+			removed++;
+	}
+	closedir(d);
+	return removed;
+}
+
+void config_cache_stats(unsigned int *hits, unsigned int *misses)
+{
+	*hits = cache_hits;
+	*misses = cache_misses;
+}
@@ -0,0 +1,328 @@
+#include <stdio.h>
+#include <string.h>
+#include <brotli/encode.h>
+#include <brotli/decode.h>
+
+#include "config_codec.h"
+#include "module_config.pb-c.h"
+
+/* Bump when the layout of encoded buffers changes */
+#define CONFIG_CODEC_FORMAT 1
+
+/*
+ * Vocabulary of configuration strings likely to appear in packed configs.
+ * The pipeline must use a byte identical dictionary to decode.
+ */
+static const char config_vocabulary[] =
+	"demosaic"
+#define MODULE_SCHEMA(module) #module
+#define SCHEMA_KEY(module, id, key, type) #key
+#include "module_schemas.def"
+#undef MODULE_SCHEMA
+#undef SCHEMA_KEY
+	;
+
+const uint8_t *config_dictionary(size_t *size)
+{
+	*size = sizeof(config_vocabulary) - 1;
+	return (const uint8_t *)config_vocabulary;
+}
+
+uint64_t config_codec_version(void)
+{
+	uint64_t version = (uint64_t)CONFIG_CODEC_FORMAT << 33 | (uint64_t)BrotliEncoderVersion() << 1;
+#ifdef IPPC_BROTLI_SHARED_DICT
+	version |= 1;
+#endif
+	return version;
+}
+
+const char *config_encoding_name(int encoding)
+{
+	switch (encoding)
+	{
+		case CONFIG_ENCODING_RAW:
+			return "raw";
+		case CONFIG_ENCODING_BROTLI:
+			return "brotli";
+		case CONFIG_ENCODING_BROTLI_DICT:
+			return "brotli-dict";
+		case CONFIG_ENCODING_VMEM:
+			return "vmem";
+		default:
+			return "unknown";
+	}
+}
+
+static int brotli_encode(const uint8_t *in, size_t in_size, int use_dictionary, uint8_t *out, size_t *out_size)
+{
+	BrotliEncoderState *state = BrotliEncoderCreateInstance(NULL, NULL, NULL);
+	if (state == NULL)
+		return -1;
+
+	BrotliEncoderSetParameter(state, BROTLI_PARAM_QUALITY, BROTLI_MAX_QUALITY);
+	BrotliEncoderSetParameter(state, BROTLI_PARAM_LGWIN, BROTLI_MIN_WINDOW_BITS);
+	BrotliEncoderSetParameter(state, BROTLI_PARAM_SIZE_HINT, in_size);
+
+#ifdef IPPC_BROTLI_SHARED_DICT
+	BrotliEncoderPreparedDictionary *dictionary = NULL;
+	if (use_dictionary)
+	{
+		size_t dict_size;
+		const uint8_t *dict = config_dictionary(&dict_size);
+		dictionary = BrotliEncoderPrepareDictionary(BROTLI_SHARED_DICTIONARY_RAW, dict_size, dict, BROTLI_MAX_QUALITY, NULL, NULL, NULL);
+		if (dictionary == NULL || !BrotliEncoderAttachPreparedDictionary(state, dictionary))
+		{
+			BrotliEncoderDestroyPreparedDictionary(dictionary);
+			BrotliEncoderDestroyInstance(state);
+			return -1;
+		}
+	}
+#else
+	if (use_dictionary)
+	{
+		// Shared dictionaries need brotli >= 1.1.0
+		BrotliEncoderDestroyInstance(state);
+		return -1;
+	}
+#endif
+
+	size_t available_in = in_size;
+	const uint8_t *next_in = in;
+	size_t available_out = *out_size;
+	uint8_t *next_out = out;
+	int ret = 0;
+	if (!BrotliEncoderCompressStream(state, BROTLI_OPERATION_FINISH, &available_in, &next_in, &available_out, &next_out, NULL) || !BrotliEncoderIsFinished(state))
+		ret = -1;
+	*out_size -= available_out;
+
+	BrotliEncoderDestroyInstance(state);
+#ifdef IPPC_BROTLI_SHARED_DICT
+	BrotliEncoderDestroyPreparedDictionary(dictionary);
+#endif
+	return ret;
+}
+
+size_t config_encode_bound(size_t packed_size)
+{
+	size_t bound = BrotliEncoderMaxCompressedSize(packed_size);
+	if (bound < packed_size)
+		bound = packed_size;
+	return bound + 2;
+}
+
+int config_encode_payload(const uint8_t *packed, size_t packed_size, int best, uint8_t *out, size_t *out_size)
+{
+	if (!best)
+	{
+		if (BrotliEncoderCompress(BROTLI_DEFAULT_QUALITY, BROTLI_DEFAULT_WINDOW, BROTLI_DEFAULT_MODE, packed_size, packed, out_size, out) == BROTLI_FALSE)
+		{
+			fprintf(stderr, "Brotli compression failed\n");
+			return -1;
+		}
+		return CONFIG_ENCODING_BROTLI;
+	}
+
+	/* Try every encoding and keep the smallest */
+	int encoding_best = -1;
+	size_t best_size = 0;
+	uint8_t candidate[*out_size];
+	for (int encoding = CONFIG_ENCODING_RAW; encoding <= CONFIG_ENCODING_BROTLI_DICT; encoding++)
+	{
+		size_t size = sizeof(candidate);
+		if (encoding == CONFIG_ENCODING_RAW)
+		{
+			if (packed_size > size)
+				continue;
+			memcpy(candidate, packed, packed_size);
+			size = packed_size;
+		}
+		else if (brotli_encode(packed, packed_size, encoding == CONFIG_ENCODING_BROTLI_DICT, candidate, &size) < 0)
+		{
+			continue;
+		}
+
+		if (encoding_best < 0 || size < best_size)
+		{
+			encoding_best = encoding;
+			best_size = size;
+			memcpy(out, candidate, size);
+		}
+	}
+
+	if (encoding_best < 0)
+	{
+		fprintf(stderr, "Error: No encoding fits the output buffer\n");
+		return -1;
+	}
+	*out_size = best_size;
+	return encoding_best;
+}
+
+int config_encode(const uint8_t *packed, size_t packed_size, int tagged, uint8_t *out, size_t *out_size)
+{
+	size_t header_size = tagged ? 2 : 1;
+	if (*out_size < header_size)
+		return -1;
+
+	size_t payload_size = *out_size - header_size;
+	int encoding = config_encode_payload(packed, packed_size, tagged, out + header_size, &payload_size);
+	if (encoding < 0)
+		return -1;
+
+	*out_size = payload_size + header_size;
+	if (payload_size >= (tagged ? UINT8_MAX + 1 : CONFIG_HEADER_TAGGED))
+		return -1;
+
+	if (tagged)
+	{
+		out[0] = CONFIG_HEADER_TAGGED | encoding;
+		out[1] = payload_size;
+	}
+	else
+	{
+		out[0] = payload_size;
+	}
+	return encoding;
+}
+
+static int brotli_decode(const uint8_t *in, size_t in_size, int use_dictionary, uint8_t *out, size_t *out_size)
+{
+	BrotliDecoderState *state = BrotliDecoderCreateInstance(NULL, NULL, NULL);
+	if (state == NULL)
+		return -1;
+
+#ifdef IPPC_BROTLI_SHARED_DICT
+	if (use_dictionary)
+	{
+		size_t dict_size;
+		const uint8_t *dict = config_dictionary(&dict_size);
+		if (!BrotliDecoderAttachDictionary(state, BROTLI_SHARED_DICTIONARY_RAW, dict_size, dict))
+		{
+			BrotliDecoderDestroyInstance(state);
+			return -1;
+		}
+	}
+#else
+	if (use_dictionary)
+	{
+		BrotliDecoderDestroyInstance(state);
+		return -1;
+	}
+#endif
+
+	size_t available_in = in_size;
+	const uint8_t *next_in = in;
+	size_t available_out = *out_size;
+	uint8_t *next_out = out;
+	BrotliDecoderResult result = BrotliDecoderDecompressStream(state, &available_in, &next_in, &available_out, &next_out, NULL);
+	BrotliDecoderDestroyInstance(state);
+	if (result != BROTLI_DECODER_RESULT_SUCCESS)
+		return -1;
+
+	*out_size -= available_out;
+	return 0;
+}
+
+int config_decode(const uint8_t *buffer, size_t size, uint8_t *out, size_t *out_size)
+{
+	if (size < 1)
+		return -1;
+
+	int encoding;
+	size_t payload_size;
+	const uint8_t *payload;
+	if (buffer[0] < CONFIG_HEADER_TAGGED)
+	{
+		encoding = CONFIG_ENCODING_BROTLI;
+		payload_size = buffer[0];
+		payload = buffer + 1;
+	}
+	else
+	{
+		if (size < 2)
+			return -1;
+		encoding = buffer[0] & CONFIG_HEADER_TAG_MASK;
+		payload_size = buffer[1];
+		payload = buffer + 2;
+	}
+	if (payload + payload_size > buffer + size)
+		return -1;
+
+	switch (encoding)
+	{
+		case CONFIG_ENCODING_RAW:
+			if (payload_size > *out_size)
+				return -1;
+			memcpy(out, payload, payload_size);
+			*out_size = payload_size;
+			return encoding;
+		case CONFIG_ENCODING_BROTLI:
+		case CONFIG_ENCODING_BROTLI_DICT:
+			if (brotli_decode(payload, payload_size, encoding == CONFIG_ENCODING_BROTLI_DICT, out, out_size) < 0)
+				return -1;
+			return encoding;
+		default:
+			return -1;
+	}
+}
+
+size_t config_buffer_size(const uint8_t *buffer, size_t size)
+{
+	if (size < 2 || buffer[0] == 0)
+		return 0;
+
+	size_t used;
+	if (buffer[0] < CONFIG_HEADER_TAGGED)
+		used = buffer[0] + 1;
+	else
+		used = buffer[1] + 2;
+	return used <= size ? used : 0;
+}
+
+static void put_le32(uint8_t *out, uint32_t value)
+{
+	out[0] = value;
+	out[1] = value >> 8;
+	out[2] = value >> 16;
+	out[3] = value >> 24;
+}
+
+void config_encode_vmem_descriptor(int encoding, uint32_t address, uint32_t length, uint32_t crc, uint8_t *out)
+{
+	out[0] = CONFIG_HEADER_TAGGED | CONFIG_ENCODING_VMEM;
+	out[1] = CONFIG_VMEM_DESCRIPTOR_SIZE - 2;
+	out[2] = encoding;
+	put_le32(out + 3, address);
+	put_le32(out + 7, length);
+	put_le32(out + 11, crc);
+}
+
+static uint32_t get_le32(const uint8_t *in)
+{
+	return in[0] | in[1] << 8 | in[2] << 16 | (uint32_t)in[3] << 24;
+}
+
+int config_decode_vmem_descriptor(const uint8_t *buffer, size_t size, config_vmem_descriptor_t *descriptor)
+{
+	if (size < CONFIG_VMEM_DESCRIPTOR_SIZE || buffer[0] != (CONFIG_HEADER_TAGGED | CONFIG_ENCODING_VMEM) || buffer[1] != CONFIG_VMEM_DESCRIPTOR_SIZE - 2)
+		return -1;
+
+	descriptor->encoding = buffer[2];
+	descriptor->address = get_le32(buffer + 3);
+	descriptor->length = get_le32(buffer + 7);
+	descriptor->crc = get_le32(buffer + 11);
+	return 0;
+}
+
+uint32_t config_crc32(const uint8_t *data, size_t length)
+{
+	uint32_t crc = 0xFFFFFFFF;
+	for (size_t i = 0; i < length; i++)
+	{
+		crc ^= data[i];
+		for (int bit = 0; bit < 8; bit++)
+			crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+	}
+	return ~crc;
+}
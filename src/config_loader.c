@@ -0,0 +1,865 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <math.h>
+#include <yaml.h>
+
+#include "config_loader.h"
+#include "module_schema.h"
+#include "ippc_params.h"
+
+/* Arena */
+
+#define ARENA_CHUNK_SIZE 16384
+#define ARENA_ALIGN 16
+
+typedef struct arena_chunk
+{
+	struct arena_chunk *next;
+	size_t used;
+	size_t size;
+	_Alignas(ARENA_ALIGN) unsigned char data[];
+} arena_chunk_t;
+
+struct config_arena
+{
+	arena_chunk_t *chunks;
+};
+
+config_arena_t *config_arena_create(void)
+{
+	return calloc(1, sizeof(config_arena_t));
+}
+
+void config_arena_destroy(config_arena_t *arena)
+{
+	if (arena == NULL)
+		return;
+	arena_chunk_t *chunk = arena->chunks;
+	while (chunk != NULL)
+	{
+		arena_chunk_t *next = chunk->next;
+		free(chunk);
+		chunk = next;
+	}
+	free(arena);
+}
+
+void *config_arena_alloc(config_arena_t *arena, size_t size)
+{
+	size = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+
+	arena_chunk_t *chunk = arena->chunks;
+	if (chunk == NULL || chunk->size - chunk->used < size)
+	{
+		size_t chunk_size = size > ARENA_CHUNK_SIZE ? size : ARENA_CHUNK_SIZE;
+		chunk = malloc(sizeof(arena_chunk_t) + chunk_size);
+		if (chunk == NULL)
+		{
+			fprintf(stderr, "Error: Failed to allocate memory during parsing\n");
+			return NULL;
+		}
+		chunk->used = 0;
+		chunk->size = chunk_size;
+		chunk->next = arena->chunks;
+		arena->chunks = chunk;
+	}
+
+	void *ptr = chunk->data + chunk->used;
+	chunk->used += size;
+	return ptr;
+}
+
+char *config_arena_strdup(config_arena_t *arena, const char *str)
+{
+	size_t len = strlen(str) + 1;
+	char *copy = config_arena_alloc(arena, len);
+	if (copy != NULL)
+		memcpy(copy, str, len);
+	return copy;
+}
+
+/* Value conversion */
+
+static int safe_atof(const char *in, float *out)
+{
+	errno = 0; // To detect overflow or underflow
+	char *endptr;
+	float val = strtof(in, &endptr);
+
+	if (endptr == in)
+	{
+		fprintf(stderr, "Error: Value \"%s\" could not be parsed to a floating-point number.\n", in);
+		return -1;
+	}
+	else if (*endptr != '\0')
+	{
+		fprintf(stderr, "Error: Extra characters after number: \"%s\"\n", endptr);
+		return -1;
+	}
+	else if ((val == HUGE_VALF || val == -HUGE_VALF) && errno == ERANGE)
+	{
+		// Note: Checking against HUGE_VALF for float-specific overflow/underflow
+		fprintf(stderr, "Error: Value \"%s\" is out of range.\n", in);
+		return -1;
+	}
+
+	*out = val;
+	return 0;
+}
+
+static int safe_atoi(const char *in, int *out)
+{
+	errno = 0; // To detect overflow
+	char *endptr;
+	long val = strtol(in, &endptr, 10); // Base 10 for decimal conversion
+
+	if (endptr == in)
+	{
+		fprintf(stderr, "Error: No digits were found in token %s\n", in);
+		return -1;
+	}
+	if (*endptr != '\0')
+	{
+		fprintf(stderr, "Error: Extra characters after number: %s in token %s\n", endptr, in);
+		return -1;
+	}
+	if ((val == LONG_MIN || val == LONG_MAX) && errno == ERANGE)
+	{
+		fprintf(stderr, "Error: Value out of long int range for token %s\n", in);
+		return -1;
+	}
+	if (val < INT_MIN || val > INT_MAX)
+	{
+		fprintf(stderr, "Error: Value out of int range for token %s\n", in);
+		return -1;
+	}
+
+	*out = (int)val;
+	return 0;
+}
+
+/* Key dispatch */
+
+typedef enum
+{
+	KEY_ORDER,
+	KEY_NAME,
+	KEY_PARAM_ID,
+	KEY_KEY,
+	KEY_TYPE,
+	KEY_VALUE,
+	KEY_PIPELINE,
+	KEY_MODULE,
+	KEY_FILE,
+	KEY_SCHEMA,
+	KEY_MODULES,
+	KEY_PARAMETERS,
+	KEY_COUNT,
+} loader_key_t;
+
+/*
+ * Perfect hash over the first character, last character and length of every
+ * known key. A key colliding with another overrides its initializer, which
+ * the build turns into an error.
+ */
+#define KEY_HASH_SIZE 32
+#define KEY_HASH(first, last, len) ((3 * (first) + 8 * (last) + (len)) & (KEY_HASH_SIZE - 1))
+
+static const struct
+{
+	const char *name;
+	loader_key_t key;
+} key_table[KEY_HASH_SIZE] = {
+	[KEY_HASH('o', 'r', 5)] = {"order", KEY_ORDER},
+	[KEY_HASH('n', 'e', 4)] = {"name", KEY_NAME},
+	[KEY_HASH('p', 'd', 8)] = {"param_id", KEY_PARAM_ID},
+	[KEY_HASH('k', 'y', 3)] = {"key", KEY_KEY},
+	[KEY_HASH('t', 'e', 4)] = {"type", KEY_TYPE},
+	[KEY_HASH('v', 'e', 5)] = {"value", KEY_VALUE},
+	[KEY_HASH('p', 'e', 8)] = {"pipeline", KEY_PIPELINE},
+	[KEY_HASH('m', 'e', 6)] = {"module", KEY_MODULE},
+	[KEY_HASH('f', 'e', 4)] = {"file", KEY_FILE},
+	[KEY_HASH('s', 'a', 6)] = {"schema", KEY_SCHEMA},
+	[KEY_HASH('m', 's', 7)] = {"modules", KEY_MODULES},
+	[KEY_HASH('p', 's', 10)] = {"parameters", KEY_PARAMETERS},
+};
+
+static int lookup_key(const char *str, size_t len)
+{
+	if (len == 0)
+		return -1;
+	unsigned int slot = KEY_HASH((unsigned char)str[0], (unsigned char)str[len - 1], len);
+	if (key_table[slot].name == NULL || strcmp(key_table[slot].name, str) != 0)
+		return -1;
+	return key_table[slot].key;
+}
+
+/* Schemas */
+
+typedef struct
+{
+	config_arena_t *arena;
+	const char *filename; // for relative paths in manifests
+	const char *module_schema;
+	int defer_finish; // finish items once the enclosing mapping is complete
+} loader_ctx_t;
+
+typedef int (*field_setter_t)(loader_ctx_t *ctx, void *item, const char *value);
+typedef int (*sequence_loader_t)(yaml_parser_t *parser, loader_ctx_t *ctx, void *item);
+
+typedef struct
+{
+	size_t item_size;
+	const char *allowed; // allowed keys, for error messages
+	void (*init)(loader_ctx_t *ctx, void *item);
+	int (*finish)(loader_ctx_t *ctx, void *item);
+	field_setter_t fields[KEY_COUNT];
+	sequence_loader_t sequences[KEY_COUNT]; // keys holding a nested sequence
+} loader_schema_t;
+
+/* Collected items, in file order */
+typedef struct loader_item
+{
+	struct loader_item *next;
+	_Alignas(ARENA_ALIGN) unsigned char data[];
+} loader_item_t;
+
+typedef struct
+{
+	loader_item_t *head;
+	loader_item_t **tail;
+	size_t count;
+} loader_list_t;
+
+static int load_sequence(yaml_parser_t *parser, const loader_schema_t *schema, loader_ctx_t *ctx, loader_list_t *list);
+static void **list_to_array(loader_ctx_t *ctx, loader_list_t *list);
+
+static void pipeline_init(loader_ctx_t *ctx, void *item)
+{
+	ModuleDefinition module = MODULE_DEFINITION__INIT;
+	*(ModuleDefinition *)item = module;
+}
+
+static int pipeline_set_order(loader_ctx_t *ctx, void *item, const char *value)
+{
+	return safe_atoi(value, &((ModuleDefinition *)item)->order);
+}
+
+static int pipeline_set_name(loader_ctx_t *ctx, void *item, const char *value)
+{
+	ModuleDefinition *module = item;
+	module->name = config_arena_strdup(ctx->arena, value);
+	return module->name != NULL ? 0 : -1;
+}
+
+static int pipeline_set_param_id(loader_ctx_t *ctx, void *item, const char *value)
+{
+	ModuleDefinition *module = item;
+	if (safe_atoi(value, &module->param_id) < 0)
+		return -1;
+	if (module->param_id < 1 || module->param_id > MAX_MODULES)
+	{
+		fprintf(stderr, "Error: Param_id is invalid. Range is 1-%d\n", MAX_MODULES);
+		return -1;
+	}
+	return 0;
+}
+
+static const loader_schema_t pipeline_schema = {
+	.item_size = sizeof(ModuleDefinition),
+	.allowed = "order, name, param_id",
+	.init = pipeline_init,
+	.fields = {
+		[KEY_ORDER] = pipeline_set_order,
+		[KEY_NAME] = pipeline_set_name,
+		[KEY_PARAM_ID] = pipeline_set_param_id,
+	},
+};
+
+/* Module parameter with its value, converted once the type is known */
+typedef struct
+{
+	ConfigParameter param;
+	const char *value;
+} module_item_t;
+
+static void module_init(loader_ctx_t *ctx, void *item)
+{
+	module_item_t *module_item = item;
+	ConfigParameter param = CONFIG_PARAMETER__INIT;
+	module_item->param = param;
+	module_item->value = NULL;
+}
+
+static int module_set_key(loader_ctx_t *ctx, void *item, const char *value)
+{
+	ConfigParameter *param = item;
+	param->key = config_arena_strdup(ctx->arena, value);
+	return param->key != NULL ? 0 : -1;
+}
+
+static int module_set_type(loader_ctx_t *ctx, void *item, const char *value)
+{
+	return safe_atoi(value, (int *)&((ConfigParameter *)item)->value_case);
+}
+
+static int module_set_value(loader_ctx_t *ctx, void *item, const char *value)
+{
+	module_item_t *module_item = item;
+	module_item->value = config_arena_strdup(ctx->arena, value);
+	return module_item->value != NULL ? 0 : -1;
+}
+
+static int module_finish(loader_ctx_t *ctx, void *item)
+{
+	ConfigParameter *param = item;
+
+	/* Infer or check the value type from the module schema */
+	const module_schema_key_t *entry = NULL;
+	if (ctx->module_schema != NULL)
+		entry = module_schema_lookup(ctx->module_schema, param->key);
+	if (entry != NULL && param->value_case == CONFIG_PARAMETER__VALUE__NOT_SET)
+	{
+		param->value_case = entry->type;
+	}
+	else if (entry != NULL && param->value_case != entry->type)
+	{
+		fprintf(stderr, "Error: Key \"%s\" has type %d but schema %s requires type %d\n", entry->key, param->value_case, ctx->module_schema, entry->type);
+		return -1;
+	}
+
+	const char *value = ((module_item_t *)item)->value;
+	if (value == NULL)
+	{
+		fprintf(stderr, "Error: Key \"%s\" has no value\n", param->key);
+		return -1;
+	}
+
+	switch (param->value_case)
+	{
+		case CONFIG_PARAMETER__VALUE_BOOL_VALUE:
+			if (strcmp(value, "true") == 0)
+			{
+				param->bool_value = 1;
+			}
+			else if (strcmp(value, "false") == 0)
+			{
+				param->bool_value = 0;
+			}
+			else
+			{
+				fprintf(stderr, "Error: Could not parse %s to boolean value\nAllowed values are: true, false\n", value);
+				return -1;
+			}
+			return 0;
+		case CONFIG_PARAMETER__VALUE_INT_VALUE:
+			return safe_atoi(value, &param->int_value);
+		case CONFIG_PARAMETER__VALUE_FLOAT_VALUE:
+			return safe_atof(value, &param->float_value);
+		case CONFIG_PARAMETER__VALUE_STRING_VALUE:
+			param->string_value = (char *)value;
+			return 0;
+		default:
+			fprintf(stderr, "Error: Value case %d unknown.\n", param->value_case);
+			return -1;
+	}
+}
+
+static const loader_schema_t module_schema = {
+	.item_size = sizeof(module_item_t),
+	.allowed = "key, type, value",
+	.init = module_init,
+	.finish = module_finish,
+	.fields = {
+		[KEY_KEY] = module_set_key,
+		[KEY_TYPE] = module_set_type,
+		[KEY_VALUE] = module_set_value,
+	},
+};
+
+static int finish_pipeline(PipelineDefinition *pipeline, void **items, size_t count)
+{
+	pipeline->n_modules = count;
+	pipeline->modules = (ModuleDefinition **)items;
+
+	// Ensure module orders are unique
+	unsigned char orders[count > 0 ? count : 1];
+	memset(orders, 0, sizeof(orders));
+	for (size_t i = 0; i < count; i++)
+	{
+		int order = pipeline->modules[i]->order;
+		if (order > (int)count || order < 1 || orders[order - 1])
+		{
+			fprintf(stderr, "Error: Order values are out of bounds or not sequential, bad value: %d\n", order);
+			return -1;
+		}
+		orders[order - 1] = 1;
+	}
+	return 0;
+}
+
+static void finish_module(ModuleConfig *module_config, void **items, size_t count)
+{
+	module_config->n_parameters = count;
+	module_config->parameters = (ConfigParameter **)items;
+}
+
+static void manifest_init(loader_ctx_t *ctx, void *item)
+{
+	memset(item, 0, sizeof(config_manifest_entry_t));
+}
+
+static int manifest_set_pipeline(loader_ctx_t *ctx, void *item, const char *value)
+{
+	config_manifest_entry_t *entry = item;
+	if (safe_atoi(value, &entry->pipeline_id) < 0)
+		return -1;
+	if (entry->pipeline_id < 1 || entry->pipeline_id > MAX_PIPELINES)
+	{
+		fprintf(stderr, "Error: Pipeline index %d is invalid. Range is 1-%d\n", entry->pipeline_id, MAX_PIPELINES);
+		return -1;
+	}
+	return 0;
+}
+
+static int manifest_set_module(loader_ctx_t *ctx, void *item, const char *value)
+{
+	config_manifest_entry_t *entry = item;
+	if (safe_atoi(value, &entry->module_id) < 0)
+		return -1;
+	if (entry->module_id < 1 || entry->module_id > MAX_MODULES)
+	{
+		fprintf(stderr, "Error: Module index %d is invalid. Range is 1-%d\n", entry->module_id, MAX_MODULES);
+		return -1;
+	}
+	return 0;
+}
+
+static int manifest_set_file(loader_ctx_t *ctx, void *item, const char *value)
+{
+	config_manifest_entry_t *entry = item;
+
+	/* Config file paths are relative to the manifest */
+	const char *slash_pos = ctx->filename != NULL ? strrchr(ctx->filename, '/') : NULL;
+	int dir_len = slash_pos != NULL && value[0] != '/' ? slash_pos - ctx->filename + 1 : 0;
+	entry->file = config_arena_alloc(ctx->arena, dir_len + strlen(value) + 1);
+	if (entry->file == NULL)
+		return -1;
+	sprintf(entry->file, "%.*s%s", dir_len, dir_len > 0 ? ctx->filename : "", value);
+	return 0;
+}
+
+static int manifest_set_schema(loader_ctx_t *ctx, void *item, const char *value)
+{
+	config_manifest_entry_t *entry = item;
+	if (!module_schema_exists(value))
+	{
+		fprintf(stderr, "Error: Unknown module schema %s\n", value);
+		return -1;
+	}
+	entry->schema = config_arena_strdup(ctx->arena, value);
+	return entry->schema != NULL ? 0 : -1;
+}
+
+static int manifest_load_modules(yaml_parser_t *parser, loader_ctx_t *ctx, void *item)
+{
+	config_manifest_entry_t *entry = item;
+	loader_list_t list = {.tail = &list.head};
+	if (entry->pipeline != NULL || load_sequence(parser, &pipeline_schema, ctx, &list) < 0)
+		return -1;
+
+	entry->pipeline = config_arena_alloc(ctx->arena, sizeof(PipelineDefinition));
+	void **items = list_to_array(ctx, &list);
+	if (entry->pipeline == NULL || items == NULL)
+		return -1;
+	PipelineDefinition pipeline = PIPELINE_DEFINITION__INIT;
+	*entry->pipeline = pipeline;
+	return finish_pipeline(entry->pipeline, items, list.count);
+}
+
+static int manifest_load_parameters(yaml_parser_t *parser, loader_ctx_t *ctx, void *item)
+{
+	config_manifest_entry_t *entry = item;
+	loader_list_t list = {.tail = &list.head};
+
+	/* The schema may follow the parameters, types are resolved when the entry is complete */
+	ctx->defer_finish = 1;
+	int ret = entry->module_config != NULL ? -1 : load_sequence(parser, &module_schema, ctx, &list);
+	ctx->defer_finish = 0;
+	if (ret < 0)
+		return -1;
+
+	entry->module_config = config_arena_alloc(ctx->arena, sizeof(ModuleConfig));
+	void **items = list_to_array(ctx, &list);
+	if (entry->module_config == NULL || items == NULL)
+		return -1;
+	ModuleConfig module_config = MODULE_CONFIG__INIT;
+	*entry->module_config = module_config;
+	finish_module(entry->module_config, items, list.count);
+	return 0;
+}
+
+static int manifest_finish(loader_ctx_t *ctx, void *item)
+{
+	config_manifest_entry_t *entry = item;
+	int has_file = entry->file != NULL;
+	int has_inline = entry->pipeline != NULL || entry->module_config != NULL;
+	if (has_file == has_inline || (entry->pipeline_id == 0) == (entry->module_id == 0))
+	{
+		fprintf(stderr, "Error: Manifest entries need either a pipeline or a module id, and either a file or an inline configuration\n");
+		return -1;
+	}
+	if ((entry->pipeline != NULL && entry->pipeline_id == 0) || (entry->module_config != NULL && entry->module_id == 0))
+	{
+		fprintf(stderr, "Error: Inline modules belong to a pipeline and inline parameters to a module\n");
+		return -1;
+	}
+
+	if (entry->module_config != NULL)
+	{
+		ctx->module_schema = entry->schema;
+		for (size_t i = 0; i < entry->module_config->n_parameters; i++)
+		{
+			if (module_finish(ctx, entry->module_config->parameters[i]) < 0)
+				return -1;
+		}
+		ctx->module_schema = NULL;
+	}
+	return 0;
+}
+
+static const loader_schema_t manifest_schema = {
+	.item_size = sizeof(config_manifest_entry_t),
+	.allowed = "pipeline, module, file, schema, modules, parameters",
+	.init = manifest_init,
+	.finish = manifest_finish,
+	.fields = {
+		[KEY_PIPELINE] = manifest_set_pipeline,
+		[KEY_MODULE] = manifest_set_module,
+		[KEY_FILE] = manifest_set_file,
+		[KEY_SCHEMA] = manifest_set_schema,
+	},
+	.sequences = {
+		[KEY_MODULES] = manifest_load_modules,
+		[KEY_PARAMETERS] = manifest_load_parameters,
+	},
+};
+
+/* Event loop */
+
+static int parse_event(yaml_parser_t *parser, yaml_event_t *event)
+{
+	if (!yaml_parser_parse(parser, event))
+	{
+		fprintf(stderr, "Error: Parser error %d at line %zu: %s\n", parser->error, parser->problem_mark.line + 1, parser->problem != NULL ? parser->problem : "");
+		return -1;
+	}
+	return 0;
+}
+
+/*
+ * Load one mapping into a new item appended to the list.
+ * The MAPPING_START event must already be consumed.
+ */
+static int load_mapping(yaml_parser_t *parser, const loader_schema_t *schema, loader_ctx_t *ctx, loader_list_t *list)
+{
+	loader_item_t *item = config_arena_alloc(ctx->arena, sizeof(loader_item_t) + schema->item_size);
+	if (item == NULL)
+		return -1;
+	item->next = NULL;
+	schema->init(ctx, item->data);
+
+	int key = -1;
+	while (1)
+	{
+		yaml_event_t event;
+		if (parse_event(parser, &event) < 0)
+			return -1;
+
+		int ret = 0;
+		int done = 0;
+		switch (event.type)
+		{
+			case YAML_MAPPING_END_EVENT:
+				done = 1;
+				break;
+			case YAML_SCALAR_EVENT:
+			{
+				const char *scalar = (const char *)event.data.scalar.value;
+				if (key < 0)
+				{
+					key = lookup_key(scalar, event.data.scalar.length);
+					if (key < 0 || (schema->fields[key] == NULL && schema->sequences[key] == NULL))
+					{
+						// Unexpected event type
+						fprintf(stderr, "Error: Unexpected YAML scalar value format: %s\nAllowed values are: %s\n", scalar, schema->allowed);
+						ret = -1;
+					}
+				}
+				else if (schema->fields[key] == NULL)
+				{
+					fprintf(stderr, "Error: Expected a sequence of mappings, got \"%s\"\n", scalar);
+					ret = -1;
+				}
+				else
+				{
+					ret = schema->fields[key](ctx, item->data, scalar);
+					key = -1;
+				}
+				break;
+			}
+			case YAML_SEQUENCE_START_EVENT:
+				if (key < 0 || schema->sequences[key] == NULL)
+				{
+					fprintf(stderr, "Error: Nested sequences are not allowed here\n");
+					ret = -1;
+				}
+				else
+				{
+					ret = schema->sequences[key](parser, ctx, item->data);
+					key = -1;
+				}
+				break;
+			case YAML_MAPPING_START_EVENT:
+			case YAML_ALIAS_EVENT:
+				fprintf(stderr, "Error: Nested mappings and aliases are not allowed here\n");
+				ret = -1;
+				break;
+			default:
+				break;
+		}
+		yaml_event_delete(&event);
+
+		if (ret < 0)
+			return -1;
+		if (done)
+			break;
+	}
+
+	if (schema->finish != NULL && !ctx->defer_finish && schema->finish(ctx, item->data) < 0)
+		return -1;
+
+	*list->tail = item;
+	list->tail = &item->next;
+	list->count++;
+	return 0;
+}
+
+/*
+ * Load a sequence of mappings, appending the items to the list.
+ * The SEQUENCE_START event must already be consumed.
+ */
+static int load_sequence(yaml_parser_t *parser, const loader_schema_t *schema, loader_ctx_t *ctx, loader_list_t *list)
+{
+	while (1)
+	{
+		yaml_event_t event;
+		if (parse_event(parser, &event) < 0)
+			return -1;
+
+		yaml_event_type_t type = event.type;
+		if (type == YAML_SCALAR_EVENT)
+			fprintf(stderr, "Error: Expected a mapping, got \"%s\"\n", (const char *)event.data.scalar.value);
+		yaml_event_delete(&event);
+
+		switch (type)
+		{
+			case YAML_MAPPING_START_EVENT:
+				if (load_mapping(parser, schema, ctx, list) < 0)
+					return -1;
+				break;
+			case YAML_SEQUENCE_END_EVENT:
+				return 0;
+			case YAML_SCALAR_EVENT:
+				return -1;
+			default:
+				fprintf(stderr, "Error: Nested sequences and aliases are not allowed here\n");
+				return -1;
+		}
+	}
+}
+
+static void **list_to_array(loader_ctx_t *ctx, loader_list_t *list)
+{
+	void **items = config_arena_alloc(ctx->arena, (list->count > 0 ? list->count : 1) * sizeof(void *));
+	if (items == NULL)
+		return NULL;
+	size_t i = 0;
+	for (loader_item_t *it = list->head; it != NULL; it = it->next)
+		items[i++] = it->data;
+	return items;
+}
+
+/*
+ * Load every document of a stream. A document is a sequence of mappings or,
+ * if the schema allows it, a single mapping.
+ */
+static int load_stream(yaml_parser_t *parser, const loader_schema_t *schema, int allow_mapping, loader_ctx_t *ctx, void ***items, size_t *count)
+{
+	loader_list_t list = {.tail = &list.head};
+	int documents = 0;
+
+	while (1)
+	{
+		yaml_event_t event;
+		if (parse_event(parser, &event) < 0)
+			return -1;
+
+		yaml_event_type_t type = event.type;
+		yaml_event_delete(&event);
+
+		int ret = 0;
+		switch (type)
+		{
+			case YAML_SEQUENCE_START_EVENT:
+				ret = load_sequence(parser, schema, ctx, &list);
+				break;
+			case YAML_MAPPING_START_EVENT:
+				if (!allow_mapping)
+				{
+					fprintf(stderr, "Error: Expected a sequence of mappings\n");
+					ret = -1;
+					break;
+				}
+				ret = load_mapping(parser, schema, ctx, &list);
+				break;
+			case YAML_DOCUMENT_START_EVENT:
+				if (++documents > 1 && !allow_mapping)
+				{
+					fprintf(stderr, "Error: Expected a single document\n");
+					ret = -1;
+				}
+				break;
+			case YAML_STREAM_START_EVENT:
+			case YAML_DOCUMENT_END_EVENT:
+				break;
+			case YAML_STREAM_END_EVENT:
+				*items = list_to_array(ctx, &list);
+				*count = list.count;
+				return *items != NULL ? 0 : -1;
+			default:
+				fprintf(stderr, "Error: Expected a sequence of mappings\n");
+				ret = -1;
+				break;
+		}
+		if (ret < 0)
+			return -1;
+	}
+}
+
+static int load_file(const char *filename, const loader_schema_t *schema, int allow_mapping, loader_ctx_t *ctx, void ***items, size_t *count)
+{
+	FILE *fh = fopen(filename, "r");
+	if (fh == NULL)
+	{
+		fprintf(stderr, "Error: Failed to open file %s!\n", filename);
+		return -1;
+	}
+
+	yaml_parser_t parser;
+	if (!yaml_parser_initialize(&parser))
+	{
+		fprintf(stderr, "Error: Failed to initialize parser!\n");
+		fclose(fh);
+		return -1;
+	}
+	yaml_parser_set_input_file(&parser, fh);
+
+	int ret = load_stream(&parser, schema, allow_mapping, ctx, items, count);
+
+	yaml_parser_delete(&parser);
+	fclose(fh);
+	return ret;
+}
+
+static int load_string(const char *yaml, size_t size, const loader_schema_t *schema, int allow_mapping, loader_ctx_t *ctx, void ***items, size_t *count)
+{
+	yaml_parser_t parser;
+	if (!yaml_parser_initialize(&parser))
+	{
+		fprintf(stderr, "Error: Failed to initialize parser!\n");
+		return -1;
+	}
+	yaml_parser_set_input_string(&parser, (const unsigned char *)yaml, size);
+
+	int ret = load_stream(&parser, schema, allow_mapping, ctx, items, count);
+
+	yaml_parser_delete(&parser);
+	return ret;
+}
+
+/* Results */
+
+int config_load_pipeline(const char *filename, config_arena_t *arena, PipelineDefinition *pipeline)
+{
+	loader_ctx_t ctx = {.arena = arena, .filename = filename};
+	void **items;
+	size_t count;
+	if (load_file(filename, &pipeline_schema, 0, &ctx, &items, &count) < 0)
+		return -1;
+	return finish_pipeline(pipeline, items, count);
+}
+
+int config_load_pipeline_string(const char *yaml, size_t size, config_arena_t *arena, PipelineDefinition *pipeline)
+{
+	loader_ctx_t ctx = {.arena = arena};
+	void **items;
+	size_t count;
+	if (load_string(yaml, size, &pipeline_schema, 0, &ctx, &items, &count) < 0)
+		return -1;
+	return finish_pipeline(pipeline, items, count);
+}
+
+int config_load_module(const char *filename, config_arena_t *arena, ModuleConfig *module_config, const char *schema)
+{
+	loader_ctx_t ctx = {.arena = arena, .filename = filename, .module_schema = schema};
+	void **items;
+	size_t count;
+	if (load_file(filename, &module_schema, 0, &ctx, &items, &count) < 0)
+		return -1;
+	finish_module(module_config, items, count);
+	return 0;
+}
+
+int config_load_module_string(const char *yaml, size_t size, config_arena_t *arena, ModuleConfig *module_config, const char *schema)
+{
+	loader_ctx_t ctx = {.arena = arena, .module_schema = schema};
+	void **items;
+	size_t count;
+	if (load_string(yaml, size, &module_schema, 0, &ctx, &items, &count) < 0)
+		return -1;
+	finish_module(module_config, items, count);
+	return 0;
+}
+
+static int copy_manifest(config_arena_t *arena, void **items, size_t count, config_manifest_entry_t **entries)
+{
+	/* Copy into a contiguous array */
+	*entries = config_arena_alloc(arena, (count > 0 ? count : 1) * sizeof(config_manifest_entry_t));
+	if (*entries == NULL)
+		return -1;
+	for (size_t i = 0; i < count; i++)
+		(*entries)[i] = *(config_manifest_entry_t *)items[i];
+	return 0;
+}
+
+int config_load_manifest(const char *filename, config_arena_t *arena, config_manifest_entry_t **entries, size_t *count)
+{
+	loader_ctx_t ctx = {.arena = arena, .filename = filename};
+	void **items;
+	if (load_file(filename, &manifest_schema, 1, &ctx, &items, count) < 0)
+		return -1;
+	return copy_manifest(arena, items, *count, entries);
+}
+
+int config_load_manifest_string(const char *yaml, size_t size, config_arena_t *arena, config_manifest_entry_t **entries, size_t *count)
+{
+	loader_ctx_t ctx = {.arena = arena};
+	void **items;
+	if (load_string(yaml, size, &manifest_schema, 1, &ctx, &items, count) < 0)
+		return -1;
+	return copy_manifest(arena, items, *count, entries);
+}
@@ -0,0 +1,123 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "fleet.h"
+#include "profile.h"
+#include "link_stats.h"
+
+typedef struct
+{
+	fleet_task_t task;
+	void *arg;
+	unsigned int retries;
+	fleet_result_t *result;
+} fleet_worker_t;
+
+int fleet_parse_nodes(const char *list, unsigned int nodes[FLEET_MAX_NODES])
+{
+	int count = 0;
+	const char *pos = list;
+	while (*pos != '\0')
+	{
+		char *endptr;
+		errno = 0;
+		unsigned long node = strtoul(pos, &endptr, 0);
+		if (endptr == pos || errno == ERANGE || node > 0x3FFF || (*endptr != ',' && *endptr != '\0'))
+		{
+			fprintf(stderr, "Error: Invalid node list \"%s\"\n", list);
+			return -1;
+		}
+		if (count >= FLEET_MAX_NODES)
+		{
+			fprintf(stderr, "Error: Node list has more than %d nodes\n", FLEET_MAX_NODES);
+			return -1;
+		}
+		nodes[count++] = node;
+		pos = *endptr == ',' ? endptr + 1 : endptr;
+	}
+	if (count == 0)
+	{
+		fprintf(stderr, "Error: Empty node list\n");
+		return -1;
+	}
+	return count;
+}
+
+static double elapsed_ms(const struct timespec *start)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - start->tv_sec) * 1e3 + (now.tv_nsec - start->tv_nsec) / 1e6;
+}
+
+static void *fleet_worker(void *arg)
+{
+	fleet_worker_t *worker = arg;
+	fleet_result_t *result = worker->result;
+
+	profile_set_node(result->node);
+	link_stats_last_failure();
+	do
+	{
+		struct timespec start;
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		result->result = worker->task(result->node, worker->arg);
+		result->latency_ms = elapsed_ms(&start);
+		result->attempts++;
+
+		/* A retry counts against the transfer that failed the attempt */
+		int failure = link_stats_last_failure();
+		if (result->result < 0 && result->attempts <= worker->retries && failure >= 0)
+			link_stats_retry(failure, result->node);
+	} while (result->result < 0 && result->attempts <= worker->retries);
+	profile_set_node(0);
+
+	return NULL;
+}
+
+int fleet_run(const unsigned int *nodes, int count, unsigned int retries, fleet_task_t task, void *arg, fleet_result_t *results)
+{
+	pthread_t threads[count];
+	fleet_worker_t workers[count];
+	int started[count];
+
+	for (int i = 0; i < count; i++)
+	{
+		results[i].node = nodes[i];
+		results[i].result = -1;
+		results[i].attempts = 0;
+		results[i].latency_ms = 0;
+		workers[i].task = task;
+		workers[i].arg = arg;
+		workers[i].retries = retries;
+		workers[i].result = &results[i];
+
+		/* A single node needs no thread */
+		started[i] = count > 1 && pthread_create(&threads[i], NULL, fleet_worker, &workers[i]) == 0;
+		if (!started[i])
+			fleet_worker(&workers[i]);
+	}
+
+	int failed = 0;
+	for (int i = 0; i < count; i++)
+	{
+		if (started[i])
+			pthread_join(threads[i], NULL);
+		if (results[i].result < 0)
+			failed++;
+	}
+	return failed;
+}
+
+void fleet_print_results(const fleet_result_t *results, int count)
+{
+	printf("%-8s %-10s %-9s %s\n", "Node", "Result", "Attempts", "Latency");
+	for (int i = 0; i < count; i++)
+	{
+		const char *status = results[i].result == FLEET_PUSHED ? "pushed" : results[i].result == FLEET_UNCHANGED ? "unchanged" : "failed";
+		printf("%-8u %-10s %-9d %.1f ms\n", results[i].node, status, results[i].attempts, results[i].latency_ms);
+	}
+}
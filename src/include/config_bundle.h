@@ -0,0 +1,36 @@
+#ifndef CONFIG_BUNDLE_H
+#define CONFIG_BUNDLE_H
+
+#include <stdint.h>
+
+/*
+ * Binary bundle of configuration parameter buffers.
+ *
+ * Header:
+ *   [0..3]  magic "IPPB"
+ *   [4]     format version
+ *   [5]     number of entries
+ * Entry:
+ *   [0..1]  parameter id, little endian
+ *   [2]     length of data
+ *   [3..6]  crc32 of data, little endian
+ *   [7..]   data, the configuration buffer without zero padding
+ */
+#define CONFIG_BUNDLE_VERSION 1
+#define CONFIG_BUNDLE_MAX_ENTRIES 255
+#define CONFIG_BUNDLE_DATA_MAX 255
+
+typedef struct
+{
+	uint16_t param_id;
+	uint8_t length;
+	uint8_t data[CONFIG_BUNDLE_DATA_MAX];
+} config_bundle_entry_t;
+
+/* Returns 0 on success, -1 on failure */
+int config_bundle_write(const char *filename, const config_bundle_entry_t *entries, int count);
+
+/* Returns the number of entries read, -1 on failure or checksum mismatch */
+int config_bundle_read(const char *filename, config_bundle_entry_t *entries, int max_entries);
+
+#endif
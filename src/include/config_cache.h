@@ -0,0 +1,44 @@
+#ifndef CONFIG_CACHE_H
+#define CONFIG_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Cache of encoded configuration buffers keyed by a hash of the
+ * configuration file content and the settings used to compile it.
+ *
+ * The cache lives in $IPPC_CACHE_DIR, or $HOME/.cache/ippc by default, and
+ * holds at most $IPPC_CACHE_MAX entries (default 64). The least recently
+ * used entries are evicted first. IPPC_CACHE_MAX=0 disables the cache.
+ */
+
+/*
+ * Compute cache key of a file and compile settings, returns -1 if the file
+ * cannot be read. The key also covers the codec version, the shared
+ * dictionary and the module schema tables, so entries of other builds miss.
+ */
+int config_cache_key(const char *filename, const char *settings, uint64_t *key);
+
+/*
+ * Copy cached buffer into buffer and the report stored with it into report,
+ * returns its length or -1 on a miss. Entries that are not a well formed
+ * configuration buffer are removed and count as a miss. report may be NULL.
+ */
+int config_cache_get(uint64_t key, uint8_t *buffer, size_t size, char *report, size_t report_size);
+
+/*
+ * Store buffer under key together with the one line report printed while
+ * compiling it, evicting old entries if the cache is full. report may be NULL.
+ */
+int config_cache_put(uint64_t key, const uint8_t *buffer, size_t length, const char *report);
+
+/* Print cache location, entries and hit rate of this session */
+void config_cache_list(void);
+
+/* Remove every cache entry, returns the number removed or -1 */
+int config_cache_clear(void);
+
+void config_cache_stats(unsigned int *hits, unsigned int *misses);
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef CONFIG_CODEC_H
+#define CONFIG_CODEC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Length prefixed configuration buffers.
+ *
+ * Untagged (legacy) buffer:
+ *   [0]    length of brotli stream (< DATA_PARAM_SIZE)
+ *   [1..]  brotli compressed protobuf
+ *
+ * Tagged buffer:
+ *   [0]    CONFIG_HEADER_TAGGED | encoding
+ *   [1]    length of payload
+ *   [2..]  payload in the given encoding
+ *
+ * Tagged header bytes are larger than any legacy length, so both formats can
+ * be told apart from the first byte.
+ *
+ * Configurations too large for a data parameter are uploaded to vmem and
+ * referenced by a tagged CONFIG_ENCODING_VMEM descriptor with the payload:
+ *   [0]      encoding of the uploaded data
+ *   [1..4]   vmem address, little endian
+ *   [5..8]   length of the uploaded data, little endian
+ *   [9..12]  crc32 of the uploaded data, little endian
+ */
+#define CONFIG_HEADER_TAGGED 0xF0
+#define CONFIG_HEADER_TAG_MASK 0x0F
+#define CONFIG_VMEM_DESCRIPTOR_SIZE (2 + 13)
+
+typedef enum
+{
+	CONFIG_ENCODING_RAW = 0,		 // packed protobuf as is
+	CONFIG_ENCODING_BROTLI = 1,		 // brotli, max quality and smallest window
+	CONFIG_ENCODING_BROTLI_DICT = 2, // as above with the config vocabulary dictionary
+	CONFIG_ENCODING_VMEM = 15,		 // descriptor of a configuration uploaded to vmem
+} config_encoding_e;
+
+/* Upper bound of the encoded size of packed_size bytes, including header */
+size_t config_encode_bound(size_t packed_size);
+
+/*
+ * Encode packed protobuf into a payload without header.
+ * If best is zero brotli with default settings is used, otherwise every
+ * available encoding is tried and the smallest result is kept.
+ * out_size holds the capacity of out on input and the used size on return.
+ * Returns the encoding used or -1 on failure.
+ */
+int config_encode_payload(const uint8_t *packed, size_t packed_size, int best, uint8_t *out, size_t *out_size);
+
+/*
+ * Encode packed protobuf into a configuration buffer with header.
+ * If tagged is zero the legacy brotli format is produced, otherwise the
+ * smallest encoding is sent in the tagged format.
+ * Returns the encoding used or -1 on failure, in which case out_size holds
+ * the size the buffer would have needed.
+ */
+int config_encode(const uint8_t *packed, size_t packed_size, int tagged, uint8_t *out, size_t *out_size);
+
+/*
+ * Decode a configuration buffer in any of the formats above into packed
+ * protobuf. Descriptors of vmem uploads cannot be decoded from the buffer
+ * alone and are rejected. out_size holds the capacity of out on input and
+ * the used size on return. Returns the encoding of the buffer or -1.
+ */
+int config_decode(const uint8_t *buffer, size_t size, uint8_t *out, size_t *out_size);
+
+/* Number of bytes used by the configuration buffer, 0 if it is empty or malformed */
+size_t config_buffer_size(const uint8_t *buffer, size_t size);
+
+typedef struct
+{
+	int encoding; // of the uploaded data
+	uint32_t address;
+	uint32_t length;
+	uint32_t crc;
+} config_vmem_descriptor_t;
+
+/* Write a vmem descriptor buffer of CONFIG_VMEM_DESCRIPTOR_SIZE bytes */
+void config_encode_vmem_descriptor(int encoding, uint32_t address, uint32_t length, uint32_t crc, uint8_t *out);
+
+/* Read a vmem descriptor buffer, returns -1 if the buffer is not a descriptor */
+int config_decode_vmem_descriptor(const uint8_t *buffer, size_t size, config_vmem_descriptor_t *descriptor);
+
+const char *config_encoding_name(int encoding);
+
+/* Changes whenever the same input may encode differently: buffer format, brotli version or dictionary support */
+uint64_t config_codec_version(void);
+
+/* Shared dictionary built from module names and schema keys */
+const uint8_t *config_dictionary(size_t *size);
+
+/* CRC32 (IEEE 802.3) */
+uint32_t config_crc32(const uint8_t *data, size_t length);
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef CONFIG_LOADER_H
+#define CONFIG_LOADER_H
+
+#include <stddef.h>
+
+#include "pipeline_config.pb-c.h"
+#include "module_config.pb-c.h"
+
+/*
+ * YAML configuration loader.
+ *
+ * Pipeline, module and manifest files are parsed in a single pass with one
+ * shared table-driven loader. Everything the loader allocates, including the
+ * protobuf messages and their strings, lives in an arena that is released in
+ * one call, also after errors.
+ */
+typedef struct config_arena config_arena_t;
+
+config_arena_t *config_arena_create(void);
+void config_arena_destroy(config_arena_t *arena);
+void *config_arena_alloc(config_arena_t *arena, size_t size);
+char *config_arena_strdup(config_arena_t *arena, const char *str);
+
+/*
+ * Entry of an ippc apply manifest. The configuration is either read from a
+ * file or given inline under modules (pipelines) or parameters (modules).
+ */
+typedef struct
+{
+	int pipeline_id; // set for pipeline entries
+	int module_id;	 // set for module entries
+	char *file;		 // resolved relative to the manifest
+	char *schema;
+	PipelineDefinition *pipeline; // inline pipeline configuration
+	ModuleConfig *module_config;  // inline module configuration
+} config_manifest_entry_t;
+
+/* Load files, returns 0 on success and -1 after printing the reason */
+int config_load_pipeline(const char *filename, config_arena_t *arena, PipelineDefinition *pipeline);
+int config_load_module(const char *filename, config_arena_t *arena, ModuleConfig *module_config, const char *schema);
+
+/*
+ * Manifests are a sequence of entries, a stream of documents with one entry
+ * each, or any mix of both. The whole file is parsed once, including inline
+ * configurations.
+ */
+int config_load_manifest(const char *filename, config_arena_t *arena, config_manifest_entry_t **entries, size_t *count);
+
+/* Load from memory */
+int config_load_pipeline_string(const char *yaml, size_t size, config_arena_t *arena, PipelineDefinition *pipeline);
+int config_load_module_string(const char *yaml, size_t size, config_arena_t *arena, ModuleConfig *module_config, const char *schema);
+int config_load_manifest_string(const char *yaml, size_t size, config_arena_t *arena, config_manifest_entry_t **entries, size_t *count);
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef FLEET_H
+#define FLEET_H
+
+/*
+ * Run the same task against several nodes concurrently, one thread per
+ * node, retrying failed attempts and timing each node.
+ */
+#define FLEET_MAX_NODES 32
+
+/* Task result, negative on failure */
+#define FLEET_PUSHED 0
+#define FLEET_UNCHANGED 1
+
+typedef int (*fleet_task_t)(unsigned int node, void *arg);
+
+typedef struct
+{
+	unsigned int node;
+	int result;
+	int attempts;
+	double latency_ms; // of the last attempt
+} fleet_result_t;
+
+/* Parse a comma separated node list such as "162,163,170", returns the count or -1 */
+int fleet_parse_nodes(const char *list, unsigned int nodes[FLEET_MAX_NODES]);
+
+/* Run task for every node, returns the number of nodes that failed */
+int fleet_run(const unsigned int *nodes, int count, unsigned int retries, fleet_task_t task, void *arg, fleet_result_t *results);
+
+void fleet_print_results(const fleet_result_t *results, int count);
+
+#endif
@@ -0,0 +1,174 @@
+#ifndef IPPC_H
+#define IPPC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "metadata.pb-c.h"
+#include "ippc_params.h"
+#include "ring_scheduler.h"
+
+/*
+ * Core of the ippc and ippb commands, without the slash shell.
+ *
+ * The slash commands are a thin adapter over these functions, and services
+ * link the library directly to configure pipelines and download observations
+ * from a long-lived process. CSP and the param client must be initialized by
+ * the caller. Functions print progress and the reason of failures, and
+ * return IPPC_OK or one of the errors below.
+ */
+#define IPPC_OK 0
+#define IPPC_EINVAL -1 // invalid arguments, configurations or entries
+#define IPPC_EIO -2	   // a node did not respond or a file could not be written
+#define IPPC_ENOMEM -3
+
+#define IPPC_MAX_RINGS 8
+
+/* How compiled configurations are pushed to nodes */
+typedef struct
+{
+	unsigned int timeout;
+	unsigned int paramver; // parameter system version, 2 unless the node is older
+	int ack_with_pull;
+	int diff;			  // pull the current configuration and only push if it differs
+	unsigned int retries; // per node
+} ippc_push_opts_t;
+
+/* How configuration files are compiled into parameter buffers */
+typedef struct
+{
+	const char *schema; // module schema, NULL for none
+	int compact;		// replace keys known by the schema with their id
+	int tagged;			// smallest of all encodings, tagged
+	const char *upload; // vmem address for configurations too large for a parameter, NULL for none
+} ippc_compile_opts_t;
+
+/* Progress of a download, updated while it runs */
+typedef struct
+{
+	int total;			 // entries to download
+	int finished;		 // entries downloaded or failed
+	uint64_t bytes;		 // downloaded so far
+	volatile int cancel; // set to stop starting downloads, those in flight finish
+} ippc_progress_t;
+
+/* How ring buffer entries are downloaded and exported */
+typedef struct
+{
+	unsigned int timeout;
+	const char *rings; // comma separated ring buffers, NULL for images
+	const char *where; // metadata filter expression, NULL for all entries
+	int save_png;
+	unsigned int per_node; // concurrent transfers per node
+	unsigned int per_link; // concurrent transfers in total
+	ippc_progress_t *progress; // optional
+	ring_download_t download;  // optional, entries are downloaded from vmem unless set
+} ippc_download_opts_t;
+
+/*
+ * Context of the core, for a process running several commands. It keeps
+ * the download buffers from one command to the next. Jobs queued with it
+ * must have finished before ippc_cleanup.
+ */
+typedef struct ippc_context ippc_t;
+
+ippc_t *ippc_init(void);
+void ippc_cleanup(ippc_t *ippc);
+
+/* Start a command with fresh phase timings, and report, trace and persist statistics when it ends */
+void ippc_begin(void);
+void ippc_end(void);
+
+/*
+ * Node list of a command, the single node unless a comma separated list is
+ * given. A list and an explicitly given node are rejected. Returns the count
+ * or -1.
+ */
+int ippc_resolve_nodes(const char *list, unsigned int node, int node_given, unsigned int *nodes);
+
+/* Compile a configuration file once and push it to every node */
+int ippc_configure_pipeline(int pipeline_id, const char *filename, const ippc_compile_opts_t *compile, const ippc_push_opts_t *push, const unsigned int *nodes, int node_count);
+int ippc_configure_module(int module_id, const char *filename, const ippc_compile_opts_t *compile, const ippc_push_opts_t *push, const unsigned int *nodes, int node_count);
+
+/* Compile every configuration of a manifest and push them to every node in as few packets as possible */
+int ippc_apply(const char *manifest, const ippc_compile_opts_t *compile, const ippc_push_opts_t *push, const unsigned int *nodes, int node_count);
+
+/* Print the pipeline and module configurations of a node */
+int ippc_status(unsigned int node, unsigned int timeout, unsigned int paramver);
+
+/*
+ * Save the configurations of a node to a bundle, or restore them. A restore
+ * clears the parameters the bundle does not hold, so the node ends up as
+ * saved. Configurations uploaded to vmem cannot be saved.
+ */
+int ippc_save(const char *bundle, unsigned int node, unsigned int timeout, unsigned int paramver);
+int ippc_restore(const char *bundle, unsigned int node, const ippc_push_opts_t *push);
+
+/* Push the configurations of an artifact to a node, leaving the other parameters as they are */
+int ippc_push_bin(const char *artifact, unsigned int node, const ippc_push_opts_t *push);
+
+/*
+ * Compile configurations into an artifact without contacting a node. With a
+ * pipeline or module index the file is a configuration of it, otherwise a
+ * manifest.
+ */
+int ippc_compile(const char *filename, const char *artifact, int pipeline_id, int module_id, const ippc_compile_opts_t *compile);
+
+/*
+ * Download count consecutive entries from offset, of every node and ring.
+ * Front counts from the newest entry. Without a context, buffers are
+ * allocated for this download only.
+ */
+int ippc_buffer_get(ippc_t *ippc, int offset, int front, unsigned int count, const unsigned int *nodes, int node_count, const ippc_download_opts_t *opts);
+
+/*
+ * Queue ippc_buffer_get on the background workers and return at once, with
+ * the id of the job or -1. The arguments are copied.
+ */
+int ippc_buffer_get_async(ippc_t *ippc, const char *description, int offset, int front, unsigned int count, const unsigned int *nodes, int node_count, const ippc_download_opts_t *opts);
+
+/*
+ * Download the entries added since the last sync, checking count entries of
+ * every node and ring at a time from the newest back to the cursor. Cursors
+ * only move past saved entries.
+ */
+int ippc_buffer_sync(ippc_t *ippc, const char *cursor_file, unsigned int count, const unsigned int *nodes, int node_count, const ippc_download_opts_t *opts);
+
+/* Print, or with clear delete, the transfer statistics kept across sessions. Node 0 prints every node */
+int ippc_link_stats(unsigned int node, int json, int clear);
+
+/*
+ * Background jobs, run by IPPC_JOB_WORKERS threads in the order queued.
+ * Finished jobs stay listed until IPPC_JOB_MAX newer jobs replace them.
+ */
+#define IPPC_JOB_WORKERS 2
+#define IPPC_JOB_MAX 32
+
+typedef int (*ippc_job_fn_t)(ippc_progress_t *progress, void *arg);
+
+/* Queue a job, release frees arg once the job finished or was cancelled. Returns the job id or -1 */
+int ippc_job_submit(const char *description, ippc_job_fn_t run, void *arg, void (*release)(void *arg));
+
+/* Cancel a queued or running job */
+int ippc_job_cancel(int id);
+
+/* Print the state, progress, rate and estimated time left of every job */
+void ippc_jobs_print(void);
+
+/* Update progress, safe while the jobs are printed */
+void ippc_progress_begin(ippc_progress_t *progress, int total);
+void ippc_progress_update(ippc_progress_t *progress, int finished, uint64_t bytes);
+
+/* String value of a custom metadata item, NULL if missing */
+char *ippc_metadata_string(Metadata *meta, const char *key);
+
+/*
+ * Pixels of an observation, decoded if the payload is JXL. Sets *pixels to
+ * the payload itself for raw entries, otherwise to a buffer the caller frees.
+ */
+int ippc_decode_observation(Metadata *meta, uint8_t *payload, uint8_t **pixels);
+
+/* Write decoded pixels of an observation as a PNG file */
+int ippc_export_png(Metadata *meta, const uint8_t *pixels, const char *filename);
+
+#endif
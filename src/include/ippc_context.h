@@ -0,0 +1,14 @@
+#ifndef IPPC_CONTEXT_H
+#define IPPC_CONTEXT_H
+
+#include "ippc.h"
+#include "ring_scheduler.h"
+
+/* State of the core kept from ippc_init to ippc_cleanup, across commands */
+struct ippc_context
+{
+	/* Download buffers, reused by the next download */
+	ring_buffer_pool_t buffers;
+};
+
+#endif
@@ -0,0 +1,11 @@
+#ifndef IPPC_PARAMS_H
+#define IPPC_PARAMS_H
+
+/* Parameter layout of the DIPP pipeline server */
+#define MAX_MODULES 20
+#define MAX_PIPELINES 6
+#define PIPELINE_PARAMID_OFFSET 10
+#define MODULE_PARAMID_OFFSET 30
+#define DATA_PARAM_SIZE 188
+
+#endif
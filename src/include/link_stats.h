@@ -0,0 +1,94 @@
+#ifndef LINK_STATS_H
+#define LINK_STATS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Transfer statistics per node, kept across sessions.
+ *
+ * Ring downloads, parameter pushes and vmem uploads record their latency,
+ * bytes and failures in memory while a command runs. link_stats_flush adds
+ * them to the statistics file (IPPC_STATS, default ippc_stats.txt), which
+ * holds one "<node> <kind> <counters...>" line per node and kind of
+ * transfer. Updates take a lock on "<file>.lock", so concurrent commands
+ * do not overwrite each other.
+ */
+#define LINK_STATS_MAX_NODES 64
+#define LINK_STATS_BUCKETS 13
+#define LINK_STATS_FILE "ippc_stats.txt"
+#define LINK_STATS_WEIGHT 0.3
+
+typedef enum
+{
+	LINK_DOWNLOAD,
+	LINK_PUSH,
+	LINK_UPLOAD,
+	LINK_KIND_COUNT,
+} link_kind_t;
+
+typedef struct
+{
+	unsigned long long count;
+	unsigned long long failures;
+	unsigned long long retries;
+	unsigned long long bytes;
+	unsigned long long ns;
+	/* Bytes per second, averaged over sessions with weight LINK_STATS_WEIGHT on the newest */
+	double rate;
+	/* Unix time of the last session with transfers */
+	long long last;
+	/* Latencies of successful transfers, bucket i is up to link_stats_bounds[i] ms */
+	unsigned long long hist[LINK_STATS_BUCKETS];
+} link_counter_t;
+
+typedef struct
+{
+	unsigned int node;
+	link_counter_t kinds[LINK_KIND_COUNT];
+} link_stats_t;
+
+typedef struct
+{
+	link_stats_t nodes[LINK_STATS_MAX_NODES];
+	int count;
+} link_stats_set_t;
+
+/* Upper bounds of the latency buckets in ms, the last bucket is unbounded */
+extern const unsigned int link_stats_bounds[LINK_STATS_BUCKETS - 1];
+
+/* Monotonic time in ns, for measuring transfers */
+uint64_t link_stats_now(void);
+
+/* Record a transfer of the current session, safe to call from several threads */
+void link_stats_record(link_kind_t kind, unsigned int node, uint64_t ns, size_t bytes, int failed);
+void link_stats_retry(link_kind_t kind, unsigned int node);
+
+/* Kind of the last failed transfer recorded by the calling thread since the previous call, -1 if none */
+int link_stats_last_failure(void);
+
+/* Statistics file from IPPC_STATS, or LINK_STATS_FILE */
+const char *link_stats_file(void);
+
+/* Load statistics, a missing file gives an empty set. Returns -1 on malformed files */
+int link_stats_load(const char *path, link_stats_set_t *set);
+
+/* Write statistics through a temporary file */
+int link_stats_save(const char *path, const link_stats_set_t *set);
+
+/* Delete the statistics file */
+int link_stats_clear(const char *path);
+
+/* Add the current session to the statistics file and clear it. Does nothing without transfers */
+int link_stats_flush(void);
+
+/* Statistics of a node, adding an empty entry if missing. NULL when full */
+link_stats_t *link_stats_get(link_stats_set_t *set, unsigned int node);
+
+/* Latency in ms below which the given fraction of transfers completed, estimated from the histogram */
+double link_stats_percentile(const link_counter_t *counter, double fraction);
+
+/* Print a table, or JSON when json is set, of every node or only the given node when non-zero */
+void link_stats_print(const link_stats_set_t *set, unsigned int node, int json);
+
+#endif
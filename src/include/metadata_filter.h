@@ -0,0 +1,34 @@
+#ifndef METADATA_FILTER_H
+#define METADATA_FILTER_H
+
+#include "metadata.pb-c.h"
+
+/*
+ * Filter expressions evaluated against observation metadata.
+ *
+ * Grammar:
+ *   expr    := and ( "||" and )*
+ *   and     := unary ( "&&" unary )*
+ *   unary   := "!" unary | "(" expr ")" | compare
+ *   compare := ident [ op literal ]
+ *   op      := "==" | "!=" | "<" | "<=" | ">" | ">="
+ *   literal := number | "string" | true | false
+ *
+ * Identifiers name a Metadata field (size, height, width, channels,
+ * timestamp, bits_pixel, camera) or the key of a custom MetadataItem.
+ * A bare identifier is true when the value exists and is non-zero/non-empty.
+ * Comparisons against missing items or mismatched types evaluate to false.
+ *
+ * Example: camera == "vis" && timestamp > 1700000000 && enc == "jxl"
+ */
+typedef struct metadata_filter metadata_filter_t;
+
+/* Compile expression, returns NULL and prints the reason on syntax errors */
+metadata_filter_t *metadata_filter_compile(const char *expr);
+
+/* Returns 1 if the metadata matches the filter, 0 otherwise */
+int metadata_filter_match(const metadata_filter_t *filter, const Metadata *meta);
+
+void metadata_filter_free(metadata_filter_t *filter);
+
+#endif
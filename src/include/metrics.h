@@ -0,0 +1,24 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+/*
+ * Prometheus text format export of the client counters, for the textfile
+ * collector of a node exporter.
+ *
+ * When IPPC_METRICS names a file, every ippc and ippb command rewrites it
+ * when it finishes. Transfer counters and latency histograms come from the
+ * statistics file (see link_stats.h). Phase counters and configuration
+ * cache hits are added to the totals already in the metrics file, so they
+ * keep growing across commands and sessions.
+ */
+
+/* Metrics file from IPPC_METRICS, NULL when the export is disabled */
+const char *metrics_file(void);
+
+/*
+ * Write the metrics to path through a temporary file. Writers take the lock
+ * file <path>.lock, so totals of concurrent commands are never lost.
+ */
+int metrics_write(const char *path);
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef MODULE_SCHEMA_H
+#define MODULE_SCHEMA_H
+
+#include "module_config.pb-c.h"
+
+/* Key entry of a module schema, see module_schemas.def */
+typedef struct
+{
+	const char *module;
+	int id;
+	const char *key;
+	ConfigParameter__ValueCase type;
+	const char *compact_key; // decimal id sent in place of the key
+} module_schema_key_t;
+
+/* Returns 1 if a schema exists for the module */
+int module_schema_exists(const char *module);
+
+/* Find schema entry by key name or by id, NULL if unknown */
+const module_schema_key_t *module_schema_lookup(const char *module, const char *key);
+const module_schema_key_t *module_schema_lookup_id(const char *module, int id);
+
+/* Text of the schema tables, changes whenever a module, key, id or type does */
+const char *module_schema_table(void);
+
+/* Print the known modules and their keys */
+void module_schema_print(void);
+
+/*
+ * Replace key strings of the module configuration with their decimal schema id.
+ * Keys not in the schema are left as is. Returns the number of keys replaced.
+ */
+int module_schema_compact(const char *module, ModuleConfig *module_config);
+
+#endif
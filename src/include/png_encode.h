@@ -0,0 +1,15 @@
+#ifndef PNG_ENCODE_H
+#define PNG_ENCODE_H
+
+#include <stdint.h>
+
+/*
+ * PNG encoding of decoded observations, in memory. This is the only
+ * translation unit holding the stb_image_write implementation, for ippb and
+ * the benchmark alike.
+ */
+
+/* Encode 8 bit interleaved pixels, returns a buffer to free or NULL */
+uint8_t *png_encode(const uint8_t *pixels, int width, int height, int channels, int *size);
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Per phase timing of ippc and ippb commands.
+ *
+ * Enabled by the --profile option of a command, or for every command when
+ * IPPC_PROFILE is set to a non-zero value. Phases record their duration and
+ * the bytes they processed, and may be recorded from several threads.
+ *
+ * The --trace option, or IPPC_TRACE set to a file name, additionally writes
+ * every phase as a Chrome trace event, with a process per node and a thread
+ * per worker, which opens in Perfetto or chrome://tracing.
+ */
+typedef enum
+{
+	PROFILE_PARSE,
+	PROFILE_PACK,
+	PROFILE_COMPRESS,
+	PROFILE_PULL,
+	PROFILE_PUSH,
+	PROFILE_DOWNLOAD,
+	PROFILE_UNPACK,
+	PROFILE_DECODE,
+	PROFILE_PNG_ENCODE,
+	PROFILE_WRITE,
+	PROFILE_WAIT,
+	PROFILE_PHASE_COUNT,
+} profile_phase_t;
+
+/* Clear all phases and enable profiling and tracing from the environment */
+void profile_reset(void);
+
+void profile_enable(void);
+int profile_enabled(void);
+
+/* Record trace events, written to filename by profile_trace_write */
+void profile_trace(const char *filename);
+
+/* Leave out the phases of the calling thread, such as background jobs outliving the command */
+void profile_mute(int muted);
+int profile_muted(void);
+
+/* Node the calling thread works on, 0 for local work */
+void profile_set_node(unsigned int node);
+
+/* Start time of a phase in ns, 0 when profiling is disabled */
+uint64_t profile_start(void);
+
+/* Record a phase started at start, ignored when start is 0 */
+void profile_end(profile_phase_t phase, uint64_t start, size_t bytes);
+
+/* Record phases without printing them, for exporters */
+void profile_collect(void);
+
+const char *profile_phase_name(profile_phase_t phase);
+
+/* Calls, time and bytes recorded for a phase since profile_reset */
+void profile_totals(profile_phase_t phase, unsigned int *calls, uint64_t *ns, uint64_t *bytes);
+
+/* Print calls, time, bytes and throughput of every phase that ran */
+void profile_report(void);
+
+/* Write the recorded trace events, if tracing is enabled, and free them */
+int profile_trace_write(void);
+
+#endif
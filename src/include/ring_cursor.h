@@ -0,0 +1,65 @@
+#ifndef RING_CURSOR_H
+#define RING_CURSOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Sync cursors of ring buffers, one per node and ring.
+ *
+ * A cursor holds the newest observation timestamp downloaded from the ring.
+ * Ring offsets shift as the ring wraps, timestamps do not. Timestamps have
+ * whole seconds, so the cursor also holds a hash of every entry downloaded
+ * at its timestamp, and entries of the same second that were not downloaded
+ * yet are told apart by their hash. Cursors are kept in a text file with one
+ * "<node> <ring> <timestamp> [<hash>,...]" line per cursor.
+ */
+#define RING_CURSOR_MAX 64
+#define RING_NAME_MAX 32
+
+/*
+ * Most entries of one second a mark tells apart. Entries past the limit are
+ * not added, so a later sync downloads them again rather than skipping them.
+ */
+#define RING_MARK_TIES 32
+
+/* Position in a ring, by timestamp and the hashes of the entries at that timestamp */
+typedef struct
+{
+	long long timestamp;
+	uint32_t ties[RING_MARK_TIES];
+	int tie_count;
+} ring_mark_t;
+
+typedef struct
+{
+	unsigned int node;
+	char ring[RING_NAME_MAX];
+	ring_mark_t mark;
+} ring_cursor_t;
+
+typedef struct
+{
+	ring_cursor_t cursors[RING_CURSOR_MAX];
+	int count;
+} ring_cursor_set_t;
+
+/* Load cursors, a missing file gives an empty set. Returns -1 on malformed files */
+int ring_cursor_load(const char *path, ring_cursor_set_t *set);
+
+/* Write cursors through a temporary file, so an interrupted sync keeps the old file */
+int ring_cursor_save(const char *path, const ring_cursor_set_t *set);
+
+/* Find the cursor of a node and ring, adding one at timestamp 0 if missing. NULL when full */
+ring_cursor_t *ring_cursor_get(ring_cursor_set_t *set, unsigned int node, const char *ring);
+
+/* Hash of the content of a ring entry (FNV-1a) */
+uint32_t ring_entry_hash(const uint8_t *data, size_t size);
+
+/* Returns 1 if the entry at timestamp with hash is one of the entries of mark */
+int ring_mark_has(const ring_mark_t *mark, long long timestamp, uint32_t hash);
+
+/* Add an entry to mark, restarting the mark if the entry has another timestamp */
+void ring_mark_add(ring_mark_t *mark, long long timestamp, uint32_t hash);
+
+#endif
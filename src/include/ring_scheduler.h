@@ -0,0 +1,91 @@
+#ifndef RING_SCHEDULER_H
+#define RING_SCHEDULER_H
+
+#include <stdint.h>
+#include <pthread.h>
+
+/*
+ * Concurrent ring buffer downloads from several nodes and rings.
+ *
+ * A fixed number of workers share the link, and each node serves at most a
+ * configured number of transfers at once. Whenever a worker is free it takes
+ * the next entry of the node with the most estimated bytes left, so nodes
+ * with large entries start early and all nodes finish close together. Entry
+ * sizes are estimated from the entries already downloaded from the same node
+ * and ring, since the ring has no header-only fetch.
+ *
+ * Pending jobs are queued per node and ring, so picking the next job costs
+ * a pass over the sources rather than over every job.
+ */
+#define RING_ENTRY_MAX 10000000
+
+/*
+ * Download buffers kept across schedules. The size of an entry is only known
+ * once it is downloaded, so every buffer holds RING_ENTRY_MAX bytes. Workers
+ * take a buffer when they start and give it back when they finish. A pool
+ * keeps as many buffers as the workers of the last schedule that gave one
+ * back, at most RING_BUFFERS_KEPT, so a session holds no more than one
+ * download needs at once.
+ */
+#define RING_BUFFERS_KEPT 16
+
+typedef struct
+{
+	pthread_mutex_t lock;
+	uint8_t *free[RING_BUFFERS_KEPT];
+	int count;
+} ring_buffer_pool_t;
+
+#define RING_BUFFER_POOL_INIT {PTHREAD_MUTEX_INITIALIZER, {0}, 0}
+
+/* Returns a kept buffer or a new one, NULL if out of memory */
+uint8_t *ring_buffer_take(ring_buffer_pool_t *pool);
+
+/* Give a buffer back, keeping at most keep buffers and freeing the others */
+void ring_buffer_give(ring_buffer_pool_t *pool, uint8_t *buffer, unsigned int keep);
+
+/* Free the kept buffers */
+void ring_buffer_pool_clear(ring_buffer_pool_t *pool);
+
+typedef struct
+{
+	unsigned int node;
+	const char *ring;
+	int offset;
+	int size; // set by the scheduler, -1 if the download failed
+} ring_job_t;
+
+/* Called from a worker thread for every downloaded entry, returns 0 on success */
+typedef int (*ring_entry_handler_t)(const ring_job_t *job, uint8_t *data, int size, void *arg);
+
+/* Called whenever a job finishes, with the jobs finished and bytes downloaded so far */
+typedef void (*ring_progress_t)(int finished, uint64_t bytes, void *arg);
+
+/* Download an entry into buffer, returns its size or -1. Defaults to vmem_ring_download */
+typedef int (*ring_download_t)(const ring_job_t *job, unsigned int timeout, uint8_t *buffer);
+
+typedef struct
+{
+	unsigned int per_node; // concurrent transfers per node
+	unsigned int per_link; // concurrent transfers in total
+	unsigned int timeout;
+	ring_entry_handler_t handler;
+	ring_progress_t progress; // optional
+	void *arg;
+	const volatile int *cancel; // optional, no more downloads are started once set
+	ring_buffer_pool_t *buffers; // optional, without it buffers are allocated per schedule
+	ring_download_t download;	 // optional
+} ring_scheduler_config_t;
+
+typedef struct
+{
+	int downloaded;
+	int failed;
+	uint64_t bytes;
+	double elapsed_ms;
+} ring_scheduler_stats_t;
+
+/* Download every job, returns the number of failed downloads or handlers */
+int ring_schedule(ring_job_t *jobs, int count, const ring_scheduler_config_t *config, ring_scheduler_stats_t *stats);
+
+#endif
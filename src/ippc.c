@@ -0,0 +1,88 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "ippc.h"
+#include "ippc_context.h"
+#include "fleet.h"
+#include "profile.h"
+#include "link_stats.h"
+#include "metrics.h"
+
+ippc_t *ippc_init(void)
+{
+	ippc_t *ippc = malloc(sizeof(ippc_t));
+	if (ippc == NULL)
+	{
+		fprintf(stderr, "Error: Failed to allocate memory for the ippc context\n");
+		return NULL;
+	}
+	*ippc = (ippc_t){.buffers = RING_BUFFER_POOL_INIT};
+	return ippc;
+}
+
+void ippc_cleanup(ippc_t *ippc)
+{
+	if (ippc == NULL)
+		return;
+	ring_buffer_pool_clear(&ippc->buffers);
+	pthread_mutex_destroy(&ippc->buffers.lock);
+	free(ippc);
+}
+
+void ippc_begin(void)
+{
+	profile_reset();
+	if (metrics_file() != NULL)
+		profile_collect();
+}
+
+void ippc_end(void)
+{
+	const char *metrics = metrics_file();
+	if (profile_enabled())
+		profile_report();
+	profile_trace_write();
+	link_stats_flush();
+	if (metrics != NULL)
+		metrics_write(metrics);
+}
+
+int ippc_resolve_nodes(const char *list, unsigned int node, int node_given, unsigned int *nodes)
+{
+	if (list != NULL && node_given)
+	{
+		fprintf(stderr, "Error: Give either --node or --nodes, not both\n");
+		return -1;
+	}
+	if (list == NULL)
+	{
+		nodes[0] = node;
+		return 1;
+	}
+	return fleet_parse_nodes(list, nodes);
+}
+
+int ippc_link_stats(unsigned int node, int json, int clear)
+{
+	const char *path = link_stats_file();
+	if (clear)
+	{
+		return link_stats_clear(path) < 0 ? IPPC_EIO : IPPC_OK;
+	}
+
+	link_stats_set_t *set = malloc(sizeof(link_stats_set_t));
+	if (set == NULL)
+	{
+		fprintf(stderr, "Error: Failed to allocate memory for statistics\n");
+		return IPPC_ENOMEM;
+	}
+	if (link_stats_load(path, set) < 0)
+	{
+		fprintf(stderr, "Error: Could not read statistics from %s\n", path);
+		free(set);
+		return IPPC_EIO;
+	}
+	link_stats_print(set, node, json);
+	free(set);
+	return IPPC_OK;
+}
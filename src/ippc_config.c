@@ -0,0 +1,1075 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <csp/csp.h>
+#include <param/param.h>
+#include <param/param_client.h>
+#include <param/param_queue.h>
+#include <param/param_server.h>
+#include <param/param_list.h>
+#include <vmem/vmem_client.h>
+
+#include "pipeline_config.pb-c.h"
+#include "module_config.pb-c.h"
+#include "ippc.h"
+#include "config_loader.h"
+#include "module_schema.h"
+#include "config_codec.h"
+#include "config_bundle.h"
+#include "config_cache.h"
+#include "fleet.h"
+#include "profile.h"
+#include "link_stats.h"
+
+#define CONFIG_DECODE_MAX 4096
+#define CONFIG_PARAM_COUNT (MAX_PIPELINES + MAX_MODULES)
+#define CONFIG_REPORT_SIZE 128
+
+static size_t file_size(const char *filename)
+{
+	struct stat st;
+	return stat(filename, &st) == 0 ? st.st_size : 0;
+}
+
+static int is_vmem_descriptor(const uint8_t buffer[DATA_PARAM_SIZE])
+{
+	return buffer[0] == (CONFIG_HEADER_TAGGED | CONFIG_ENCODING_VMEM);
+}
+
+/* Payload of a configuration too large for its parameter, uploaded before the descriptor is pushed */
+typedef struct
+{
+	uint32_t address;
+	uint8_t *data;
+	size_t size;
+} config_upload_t;
+
+/*
+ * Encode packed configuration into a zero padded data parameter buffer.
+ * Configurations that do not fit are prepared for upload to the vmem address
+ * given by upload_address, if any, and the buffer receives a descriptor of
+ * the upload. The caller uploads the payload and frees it.
+ */
+static int encode_config_buffer(const uint8_t *packed_buf, size_t packed_size, int tagged, const char *upload_address, config_upload_t *upload, uint8_t buffer[DATA_PARAM_SIZE])
+{
+	size_t encoded_size = config_encode_bound(packed_size);
+	uint8_t encoded_buffer[encoded_size];
+	uint64_t start = profile_start();
+	int encoding = config_encode(packed_buf, packed_size, tagged, encoded_buffer, &encoded_size);
+	profile_end(PROFILE_COMPRESS, start, packed_size);
+	if (encoding >= 0 && encoded_size <= DATA_PARAM_SIZE)
+	{
+		printf("Client: Packed %zu bytes, encoded %s to %zu bytes\n", packed_size, config_encoding_name(encoding), encoded_size);
+		memcpy(buffer, encoded_buffer, encoded_size);
+		return encoded_size;
+	}
+
+	if (upload_address == NULL)
+	{
+		printf("Packed and encoded configuration is size %zu bytes which exceeds max size of %d, use --upload to send it through vmem\n", encoded_size, DATA_PARAM_SIZE);
+		return -1;
+	}
+
+	char *endptr;
+	errno = 0;
+	unsigned long address = strtoul(upload_address, &endptr, 0);
+	if (endptr == upload_address || *endptr != '\0' || errno == ERANGE || address > UINT32_MAX)
+	{
+		printf("Invalid vmem address %s\n", upload_address);
+		return -1;
+	}
+
+	/* Upload the smallest payload and reference it from the parameter */
+	size_t payload_size = config_encode_bound(packed_size);
+	uint8_t *payload = malloc(payload_size);
+	if (payload == NULL)
+	{
+		fprintf(stderr, "Error: Failed to allocate memory for upload\n");
+		return -1;
+	}
+	start = profile_start();
+	encoding = config_encode_payload(packed_buf, packed_size, 1, payload, &payload_size);
+	profile_end(PROFILE_COMPRESS, start, packed_size);
+	if (encoding < 0)
+	{
+		free(payload);
+		return -1;
+	}
+
+	printf("Client: Encoded %s to %zu bytes for upload to vmem address 0x%lx\n", config_encoding_name(encoding), payload_size, address);
+	upload->address = address;
+	upload->data = payload;
+	upload->size = payload_size;
+	config_encode_vmem_descriptor(encoding, address, payload_size, config_crc32(payload, payload_size), buffer);
+	return CONFIG_VMEM_DESCRIPTOR_SIZE;
+}
+
+/* Upload the payload referenced by a vmem descriptor, before the descriptor itself is pushed */
+static int upload_config(const config_upload_t *upload, unsigned int node, unsigned int timeout)
+{
+	printf("Client: Uploading %zu bytes to vmem address 0x%" PRIx32 " on node %u\n", upload->size, upload->address, node);
+	uint64_t start = profile_start();
+	uint64_t sent = link_stats_now();
+	int ret = vmem_upload(node, timeout, upload->address, (char *)upload->data, upload->size, 2);
+	link_stats_record(LINK_UPLOAD, node, link_stats_now() - sent, upload->size, ret < 0);
+	profile_end(PROFILE_PUSH, start, upload->size);
+	if (ret < 0)
+	{
+		printf("Upload to vmem address 0x%" PRIx32 " on node %u failed, configuration not pushed\n", upload->address, node);
+		return -1;
+	}
+	return 0;
+}
+
+/* Pack and encode a pipeline definition into a data parameter buffer */
+static int encode_pipeline_config(PipelineDefinition *pipeline, int tagged, const char *upload_address, config_upload_t *upload, uint8_t buffer[DATA_PARAM_SIZE])
+{
+	size_t packed_size = pipeline_definition__get_packed_size(pipeline);
+	uint8_t packed_buf[packed_size];
+	uint64_t start = profile_start();
+	pipeline_definition__pack(pipeline, packed_buf);
+	profile_end(PROFILE_PACK, start, packed_size);
+
+	return encode_config_buffer(packed_buf, packed_size, tagged, upload_address, upload, buffer);
+}
+
+/* Parse, pack and encode a pipeline configuration file into a data parameter buffer */
+static int compile_pipeline_config(const char *filename, int tagged, const char *upload_address, config_upload_t *upload, uint8_t buffer[DATA_PARAM_SIZE])
+{
+	char settings[64];
+	snprintf(settings, sizeof(settings), "pipeline tagged=%d", tagged);
+	uint64_t key;
+	int keyed = config_cache_key(filename, settings, &key) == 0;
+	int cached = keyed ? config_cache_get(key, buffer, DATA_PARAM_SIZE, NULL, 0) : -1;
+	if (cached > 0)
+	{
+		printf("Client: Using cached compilation of %s (%d bytes)\n", filename, cached);
+		return cached;
+	}
+
+	config_arena_t *arena = config_arena_create();
+	if (arena == NULL)
+		return -1;
+
+	PipelineDefinition pipeline = PIPELINE_DEFINITION__INIT;
+	uint64_t start = profile_start();
+	int loaded = config_load_pipeline(filename, arena, &pipeline);
+	profile_end(PROFILE_PARSE, start, file_size(filename));
+	if (loaded < 0)
+	{
+		config_arena_destroy(arena);
+		return -1;
+	}
+
+	int size = encode_pipeline_config(&pipeline, tagged, upload_address, upload, buffer);
+	config_arena_destroy(arena);
+	if (size > 0 && keyed && !is_vmem_descriptor(buffer))
+		config_cache_put(key, buffer, size, NULL);
+	return size;
+}
+
+/*
+ * Remote configuration parameters of a node. Pulled values are stored in the
+ * parameters of the param list, so the parameters are registered there while
+ * they are pulled and read. Those registered here are removed on release and
+ * never show up in other CSH commands.
+ */
+typedef struct
+{
+	param_t *params[CONFIG_PARAM_COUNT];
+	int added[CONFIG_PARAM_COUNT];
+	int count;
+} config_remote_t;
+
+/* Add a remote data parameter, registering it in the param list if needed */
+static param_t *config_remote_add(config_remote_t *remote, int param_id, char *name, unsigned int node)
+{
+	int added = 0;
+	param_t *param = param_list_find_id(node, param_id);
+	if (param == NULL)
+	{
+		param = param_list_create_remote(param_id, node, PARAM_TYPE_DATA, PM_CONF, DATA_PARAM_SIZE, name, NULL, NULL, -1);
+		if (param != NULL)
+			added = param_list_add(param) == 0;
+		else
+			fprintf(stderr, "Error: Failed to allocate memory for remote parameter %s\n", name);
+	}
+
+	if (param != NULL)
+	{
+		remote->params[remote->count] = param;
+		remote->added[remote->count] = added;
+		remote->count++;
+	}
+	return param;
+}
+
+/* Remove the parameters registered by config_remote_add from the param list */
+static void config_remote_release(config_remote_t *remote)
+{
+	for (int i = 0; i < remote->count; i++)
+	{
+		if (remote->added[i])
+			param_list_remove_specific(remote->params[i], 0, 1);
+	}
+	remote->count = 0;
+}
+
+/*
+ * Remote parameters of every node of a fleet. The param list is the part of
+ * libparam that is not thread safe, so these are registered before the fleet
+ * threads start and removed after they end. The threads only look their own
+ * parameters up while replies are applied, and their transfers overlap.
+ */
+typedef struct
+{
+	unsigned int nodes[FLEET_MAX_NODES];
+	config_remote_t remotes[FLEET_MAX_NODES];
+	int count;
+} config_fleet_remote_t;
+
+static config_remote_t *config_fleet_add(config_fleet_remote_t *fleet, unsigned int node)
+{
+	config_remote_t *remote = &fleet->remotes[fleet->count];
+	fleet->nodes[fleet->count++] = node;
+	remote->count = 0;
+	return remote;
+}
+
+static config_remote_t *config_fleet_find(config_fleet_remote_t *fleet, unsigned int node)
+{
+	for (int i = 0; i < fleet->count; i++)
+	{
+		if (fleet->nodes[i] == node)
+			return &fleet->remotes[i];
+	}
+	return NULL;
+}
+
+static void config_fleet_release(config_fleet_remote_t *fleet)
+{
+	for (int i = 0; i < fleet->count; i++)
+		config_remote_release(&fleet->remotes[i]);
+	fleet->count = 0;
+}
+
+static int pull_queue(param_queue_t *queue, unsigned int node, unsigned int timeout)
+{
+	uint64_t start = profile_start();
+	int ret = param_pull_queue(queue, CSP_PRIO_NORM, 0, node, timeout);
+	profile_end(PROFILE_PULL, start, queue->used);
+	return ret;
+}
+
+static int push_queue(param_queue_t *queue, unsigned int node, unsigned int timeout, int ack_with_pull)
+{
+	uint64_t start = profile_start();
+	uint64_t sent = link_stats_now();
+	int ret = param_push_queue(queue, 0, node, timeout, 0, ack_with_pull);
+	link_stats_record(LINK_PUSH, node, link_stats_now() - sent, queue->used, ret < 0);
+	profile_end(PROFILE_PUSH, start, queue->used);
+	return ret;
+}
+
+/* Pull the values of several remote parameters, using as few requests as possible */
+static int pull_config_params(param_t **params, int count, unsigned int node, unsigned int timeout, unsigned int paramver)
+{
+	char queue_buf[PARAM_SERVER_MTU];
+	param_queue_t queue;
+	param_queue_init(&queue, queue_buf, PARAM_SERVER_MTU, 0, PARAM_QUEUE_TYPE_GET, paramver);
+
+	for (int i = 0; i < count; i++)
+	{
+		if (param_queue_add(&queue, params[i], -1, NULL) == 0)
+			continue;
+
+		if (queue.used == 0 || pull_queue(&queue, node, timeout) < 0)
+			return -1;
+		param_queue_init(&queue, queue_buf, PARAM_SERVER_MTU, 0, PARAM_QUEUE_TYPE_GET, paramver);
+		i--;
+	}
+
+	if (queue.used > 0 && pull_queue(&queue, node, timeout) < 0)
+		return -1;
+
+	return 0;
+}
+
+/* Decode and unpack a configuration buffer, then pack it again so equal configurations compare equal bytewise */
+static int canonical_config(const uint8_t buffer[DATA_PARAM_SIZE], int is_pipeline, uint8_t *out, size_t *out_size)
+{
+	uint8_t packed[CONFIG_DECODE_MAX];
+	size_t packed_size = sizeof(packed);
+	if (config_decode(buffer, DATA_PARAM_SIZE, packed, &packed_size) < 0)
+		return -1;
+
+	if (is_pipeline)
+	{
+		PipelineDefinition *pipeline = pipeline_definition__unpack(NULL, packed_size, packed);
+		if (pipeline == NULL)
+			return -1;
+		int fits = pipeline_definition__get_packed_size(pipeline) <= *out_size;
+		if (fits)
+			*out_size = pipeline_definition__pack(pipeline, out);
+		pipeline_definition__free_unpacked(pipeline, NULL);
+		return fits ? 0 : -1;
+	}
+
+	ModuleConfig *module_config = module_config__unpack(NULL, packed_size, packed);
+	if (module_config == NULL)
+		return -1;
+	int fits = module_config__get_packed_size(module_config) <= *out_size;
+	if (fits)
+		*out_size = module_config__pack(module_config, out);
+	module_config__free_unpacked(module_config, NULL);
+	return fits ? 0 : -1;
+}
+
+/* Returns 1 if both buffers hold the same configuration */
+static int config_buffers_equal(const uint8_t a[DATA_PARAM_SIZE], const uint8_t b[DATA_PARAM_SIZE], int is_pipeline)
+{
+	/* Descriptors hold the CRC of the upload, so equal descriptors reference equal configurations */
+	if (is_vmem_descriptor(a) || is_vmem_descriptor(b))
+		return memcmp(a, b, CONFIG_VMEM_DESCRIPTOR_SIZE) == 0;
+
+	uint8_t canonical_a[CONFIG_DECODE_MAX], canonical_b[CONFIG_DECODE_MAX];
+	size_t size_a = sizeof(canonical_a), size_b = sizeof(canonical_b);
+	if (canonical_config(a, is_pipeline, canonical_a, &size_a) < 0 || canonical_config(b, is_pipeline, canonical_b, &size_b) < 0)
+		return 0;
+	return size_a == size_b && memcmp(canonical_a, canonical_b, size_a) == 0;
+}
+
+/* Pull the current value of a configuration parameter and compare it with buffer */
+static int config_param_unchanged(param_t *param, const uint8_t buffer[DATA_PARAM_SIZE], int is_pipeline, unsigned int node, unsigned int timeout, unsigned int paramver)
+{
+	if (pull_config_params(&param, 1, node, timeout, paramver) < 0)
+	{
+		printf("Client: Could not pull %s, pushing anyway\n", param->name);
+		return 0;
+	}
+
+	uint8_t current[DATA_PARAM_SIZE];
+	param_get_data(param, current, DATA_PARAM_SIZE);
+	return config_buffers_equal(current, buffer, is_pipeline);
+}
+
+typedef struct
+{
+	int param_id;
+	char name[20];
+	uint8_t buffer[DATA_PARAM_SIZE];
+	int is_pipeline;
+	config_upload_t upload; // set for configurations uploaded to vmem
+	int diff;
+	unsigned int timeout;
+	unsigned int paramver;
+	int ack_with_pull;
+	config_fleet_remote_t *remotes; // registered for diffs
+} config_push_t;
+
+/* Push one configuration parameter to a node */
+static int push_config_task(unsigned int node, void *arg)
+{
+	const config_push_t *push = arg;
+
+	// Every node gets its own copy, the ack writes back into it
+	uint8_t buffer[DATA_PARAM_SIZE];
+	memcpy(buffer, push->buffer, DATA_PARAM_SIZE);
+	char name[20];
+	strcpy(name, push->name);
+
+	// Mirror the configuration parameter
+	PARAM_DEFINE_REMOTE_DYNAMIC(push->param_id, config_param, node, PARAM_TYPE_DATA, DATA_PARAM_SIZE, 1, PM_CONF, buffer, NULL);
+	config_param.name = name;
+
+	// Skip the push if the node already holds this configuration
+	config_remote_t *remote = push->diff ? config_fleet_find(push->remotes, node) : NULL;
+	if (remote != NULL && remote->count == 1 && config_param_unchanged(remote->params[0], buffer, push->is_pipeline, node, push->timeout, push->paramver))
+	{
+		printf("Client: %s is unchanged on node %u, skipping push\n", name, node);
+		return FLEET_UNCHANGED;
+	}
+
+	// The descriptor must not be pushed before the node holds the payload
+	if (push->upload.data != NULL && upload_config(&push->upload, node, push->timeout) < 0)
+		return -1;
+
+	uint64_t start = profile_start();
+	uint64_t sent = link_stats_now();
+	int pushed = param_push_single(&config_param, -1, buffer, 0, node, push->timeout, push->paramver, push->ack_with_pull);
+	link_stats_record(LINK_PUSH, node, link_stats_now() - sent, DATA_PARAM_SIZE, pushed < 0);
+	profile_end(PROFILE_PUSH, start, DATA_PARAM_SIZE);
+	if (pushed < 0)
+	{
+		printf("No response from node %u\n", node);
+		return -1;
+	}
+	return FLEET_PUSHED;
+}
+
+/* Push a compiled configuration to every node, reporting per node results for node lists */
+static int push_config_fleet(config_push_t *push, const unsigned int *nodes, int node_count, unsigned int retries)
+{
+	config_fleet_remote_t remotes = {0};
+	push->remotes = &remotes;
+	for (int i = 0; push->diff && i < node_count; i++)
+		config_remote_add(config_fleet_add(&remotes, nodes[i]), push->param_id, push->name, nodes[i]);
+
+	fleet_result_t results[node_count];
+	int failed = fleet_run(nodes, node_count, retries, push_config_task, push, results);
+	config_fleet_release(&remotes);
+	free(push->upload.data);
+	if (node_count > 1)
+		fleet_print_results(results, node_count);
+	return failed > 0 ? IPPC_EIO : IPPC_OK;
+}
+
+/* Pack and encode a module configuration into a data parameter buffer */
+static int encode_module_config(ModuleConfig *module_config, const char *schema, int compact, int tagged, const char *upload_address, config_upload_t *upload, uint8_t buffer[DATA_PARAM_SIZE], char report[CONFIG_REPORT_SIZE])
+{
+	// Replace known keys with their schema id, the report is kept with cached compilations
+	report[0] = '\0';
+	if (compact && schema != NULL)
+	{
+		size_t full_size = module_config__get_packed_size(module_config);
+		int replaced = module_schema_compact(schema, module_config);
+		size_t compact_size = module_config__get_packed_size(module_config);
+		snprintf(report, CONFIG_REPORT_SIZE, "Compacted %d keys, packed size %zu -> %zu bytes (saved %zu bytes)", replaced, full_size, compact_size, full_size - compact_size);
+		printf("%s\n", report);
+	}
+
+	size_t packed_size = module_config__get_packed_size(module_config);
+	uint8_t packed_buf[packed_size];
+	uint64_t start = profile_start();
+	module_config__pack(module_config, packed_buf);
+	profile_end(PROFILE_PACK, start, packed_size);
+
+	return encode_config_buffer(packed_buf, packed_size, tagged, upload_address, upload, buffer);
+}
+
+/* Parse, pack and encode a module configuration file into a data parameter buffer */
+static int compile_module_config(const char *filename, const char *schema, int compact, int tagged, const char *upload_address, config_upload_t *upload, uint8_t buffer[DATA_PARAM_SIZE])
+{
+	char settings[128];
+	snprintf(settings, sizeof(settings), "module schema=%s compact=%d tagged=%d", schema != NULL ? schema : "", compact, tagged);
+	uint64_t key;
+	int keyed = config_cache_key(filename, settings, &key) == 0;
+	char report[CONFIG_REPORT_SIZE];
+	int cached = keyed ? config_cache_get(key, buffer, DATA_PARAM_SIZE, report, sizeof(report)) : -1;
+	if (cached > 0)
+	{
+		if (report[0] != '\0')
+			printf("%s\n", report);
+		printf("Client: Using cached compilation of %s (%d bytes)\n", filename, cached);
+		return cached;
+	}
+
+	config_arena_t *arena = config_arena_create();
+	if (arena == NULL)
+		return -1;
+
+	ModuleConfig module_config = MODULE_CONFIG__INIT;
+	uint64_t start = profile_start();
+	int loaded = config_load_module(filename, arena, &module_config, schema);
+	profile_end(PROFILE_PARSE, start, file_size(filename));
+	if (loaded < 0)
+	{
+		config_arena_destroy(arena);
+		return -1;
+	}
+
+	int size = encode_module_config(&module_config, schema, compact, tagged, upload_address, upload, buffer, report);
+	config_arena_destroy(arena);
+	if (size > 0 && keyed && !is_vmem_descriptor(buffer))
+		config_cache_put(key, buffer, size, report);
+	return size;
+}
+
+typedef struct
+{
+	int pipeline_id; // set for pipeline entries
+	int module_id;	 // set for module entries
+	char *file;
+	char *schema;
+	PipelineDefinition *pipeline; // inline configurations, owned by the manifest arena
+	ModuleConfig *module_config;
+	int param_id;
+	char name[20];
+	uint8_t buffer[DATA_PARAM_SIZE];
+} apply_entry_t;
+
+#define MAX_APPLY_ENTRIES (MAX_PIPELINES + MAX_MODULES)
+
+/* Load manifest of pipeline and module configurations, strings and inline configurations live in the arena */
+static int load_apply_manifest(const char *filename, config_arena_t *arena, apply_entry_t *entries, int *entry_count)
+{
+	config_manifest_entry_t *manifest;
+	size_t count;
+	uint64_t start = profile_start();
+	int loaded = config_load_manifest(filename, arena, &manifest, &count);
+	profile_end(PROFILE_PARSE, start, file_size(filename));
+	if (loaded < 0)
+		return -1;
+	if (count > MAX_APPLY_ENTRIES)
+	{
+		fprintf(stderr, "Error: Manifest has more than %d entries\n", MAX_APPLY_ENTRIES);
+		return -1;
+	}
+
+	for (size_t i = 0; i < count; i++)
+	{
+		memset(&entries[i], 0, sizeof(apply_entry_t));
+		entries[i].pipeline_id = manifest[i].pipeline_id;
+		entries[i].module_id = manifest[i].module_id;
+		entries[i].file = manifest[i].file != NULL ? manifest[i].file : (char *)filename;
+		entries[i].schema = manifest[i].schema;
+		entries[i].pipeline = manifest[i].pipeline;
+		entries[i].module_config = manifest[i].module_config;
+	}
+	*entry_count = count;
+	return 0;
+}
+
+/* Compile the configuration of a manifest entry into its parameter buffer */
+static int compile_apply_entry(apply_entry_t *entry, const char *action, int compact, int tagged)
+{
+	if (entry->pipeline_id != 0)
+	{
+		printf("Client: %s pipeline %d, using %s\n", action, entry->pipeline_id, entry->file);
+		entry->param_id = entry->pipeline_id + PIPELINE_PARAMID_OFFSET - 1;
+		sprintf(entry->name, "pipeline_config_%d", entry->pipeline_id);
+		if (entry->pipeline != NULL)
+			return encode_pipeline_config(entry->pipeline, tagged, NULL, NULL, entry->buffer);
+		return compile_pipeline_config(entry->file, tagged, NULL, NULL, entry->buffer);
+	}
+
+	printf("Client: %s module %d, using %s\n", action, entry->module_id, entry->file);
+	entry->param_id = entry->module_id + MODULE_PARAMID_OFFSET - 1;
+	sprintf(entry->name, "module_param_%d", entry->module_id);
+	if (entry->module_config != NULL)
+	{
+		char report[CONFIG_REPORT_SIZE];
+		return encode_module_config(entry->module_config, entry->schema, compact, tagged, NULL, NULL, entry->buffer, report);
+	}
+	return compile_module_config(entry->file, entry->schema, compact, tagged, NULL, NULL, entry->buffer);
+}
+
+/*
+ * Push data parameter buffers to a node, packing as many parameters into
+ * each param queue packet as fit. Only the used bytes of a buffer are sent,
+ * so several configurations share a packet. Buffers are length prefixed and
+ * bytes past the length are never read. Empty buffers are sent in full to
+ * clear the parameter. Returns the number of packets sent or -1.
+ */
+static int push_config_batch(apply_entry_t *entries, int entry_count, unsigned int node, unsigned int timeout, unsigned int paramver, int ack_with_pull)
+{
+	char queue_buf[PARAM_SERVER_MTU];
+	param_queue_t queue;
+	param_queue_init(&queue, queue_buf, PARAM_SERVER_MTU, 0, PARAM_QUEUE_TYPE_SET, paramver);
+
+	int packets = 0;
+	for (int i = 0; i < entry_count; i++)
+	{
+		int length = config_buffer_size(entries[i].buffer, DATA_PARAM_SIZE);
+		if (length == 0)
+			length = DATA_PARAM_SIZE;
+		PARAM_DEFINE_REMOTE_DYNAMIC(entries[i].param_id, config_param, node, PARAM_TYPE_DATA, length, 1, PM_CONF, entries[i].buffer, NULL);
+		config_param.name = entries[i].name;
+
+		if (param_queue_add(&queue, &config_param, -1, entries[i].buffer) == 0)
+			continue;
+
+		/* Queue is full, send it and start a new packet */
+		if (queue.used == 0)
+		{
+			printf("Parameter %s does not fit in a param queue packet\n", entries[i].name);
+			return -1;
+		}
+		if (push_queue(&queue, node, timeout, ack_with_pull) < 0)
+		{
+			printf("No response\n");
+			return -1;
+		}
+		packets++;
+		param_queue_init(&queue, queue_buf, PARAM_SERVER_MTU, 0, PARAM_QUEUE_TYPE_SET, paramver);
+		i--;
+	}
+
+	if (queue.used > 0)
+	{
+		if (push_queue(&queue, node, timeout, ack_with_pull) < 0)
+		{
+			printf("No response\n");
+			return -1;
+		}
+		packets++;
+	}
+
+	return packets;
+}
+
+typedef struct
+{
+	const apply_entry_t *entries;
+	int entry_count;
+	int diff;
+	unsigned int timeout;
+	unsigned int paramver;
+	int ack_with_pull;
+	config_fleet_remote_t *remotes; // registered for diffs
+} apply_push_t;
+
+/* Push the compiled configurations of a manifest to one node */
+static int apply_config_task(unsigned int node, void *arg)
+{
+	const apply_push_t *push = arg;
+
+	// Every node gets its own copy, the diff drops entries from it
+	apply_entry_t entries[MAX_APPLY_ENTRIES];
+	int entry_count = push->entry_count;
+	memcpy(entries, push->entries, entry_count * sizeof(apply_entry_t));
+
+	/* Drop configurations the node already holds */
+	config_remote_t *remote = push->diff ? config_fleet_find(push->remotes, node) : NULL;
+	if (remote != NULL && remote->count < entry_count)
+		return -1;
+	if (remote != NULL)
+	{
+		if (pull_config_params(remote->params, entry_count, node, push->timeout, push->paramver) < 0)
+		{
+			printf("Client: Could not pull current configurations of node %u, pushing all\n", node);
+		}
+		else
+		{
+			int kept = 0;
+			for (int i = 0; i < entry_count; i++)
+			{
+				uint8_t current[DATA_PARAM_SIZE];
+				param_get_data(remote->params[i], current, DATA_PARAM_SIZE);
+				if (config_buffers_equal(current, entries[i].buffer, entries[i].pipeline_id != 0))
+				{
+					printf("Client: %s is unchanged on node %u, skipping push\n", entries[i].name, node);
+					continue;
+				}
+				if (kept != i)
+					entries[kept] = entries[i];
+				kept++;
+			}
+			entry_count = kept;
+		}
+	}
+
+	int packets = push_config_batch(entries, entry_count, node, push->timeout, push->paramver, push->ack_with_pull);
+	if (packets < 0)
+		return -1;
+
+	printf("Applied %d of %d configurations to node %u in %d packets\n", entry_count, push->entry_count, node, packets);
+	return entry_count > 0 ? FLEET_PUSHED : FLEET_UNCHANGED;
+}
+
+/* Name of a pipeline or module parameter from its id, returns 1 for pipeline parameters, 0 for module parameters and -1 for other ids */
+static int config_param_name(int param_id, char name[20])
+{
+	if (param_id >= PIPELINE_PARAMID_OFFSET && param_id < PIPELINE_PARAMID_OFFSET + MAX_PIPELINES)
+	{
+		sprintf(name, "pipeline_config_%d", param_id - PIPELINE_PARAMID_OFFSET + 1);
+		return 1;
+	}
+	if (param_id >= MODULE_PARAMID_OFFSET && param_id < MODULE_PARAMID_OFFSET + MAX_MODULES)
+	{
+		sprintf(name, "module_param_%d", param_id - MODULE_PARAMID_OFFSET + 1);
+		return 0;
+	}
+	return -1;
+}
+
+/* Id of the index-th configuration parameter, pipelines first */
+static int config_param_id(int index)
+{
+	return index < MAX_PIPELINES ? PIPELINE_PARAMID_OFFSET + index : MODULE_PARAMID_OFFSET + index - MAX_PIPELINES;
+}
+
+/* Pull every pipeline and module parameter of a node in one request, pipelines first. The caller releases remote */
+static int pull_all_config_params(config_remote_t *remote, unsigned int node, unsigned int timeout, unsigned int paramver)
+{
+	for (int i = 0; i < CONFIG_PARAM_COUNT; i++)
+	{
+		char name[20];
+		int param_id = config_param_id(i);
+		config_param_name(param_id, name);
+		if (config_remote_add(remote, param_id, name, node) == NULL)
+			return -1;
+	}
+
+	return pull_config_params(remote->params, CONFIG_PARAM_COUNT, node, timeout, paramver);
+}
+
+static void print_config_param(const char *name, const uint8_t buffer[DATA_PARAM_SIZE], int is_pipeline)
+{
+	config_vmem_descriptor_t descriptor;
+	if (config_decode_vmem_descriptor(buffer, DATA_PARAM_SIZE, &descriptor) == 0)
+	{
+		printf("%s (vmem): %" PRIu32 " bytes %s at 0x%08" PRIx32 ", crc32 0x%08" PRIx32 "\n", name, descriptor.length,
+			   config_encoding_name(descriptor.encoding), descriptor.address, descriptor.crc);
+		return;
+	}
+
+	uint8_t packed[CONFIG_DECODE_MAX];
+	size_t packed_size = sizeof(packed);
+	int encoding = config_decode(buffer, DATA_PARAM_SIZE, packed, &packed_size);
+	if (encoding < 0 || packed_size == 0)
+	{
+		printf("%s: not configured\n", name);
+		return;
+	}
+
+	if (is_pipeline)
+	{
+		PipelineDefinition *pipeline = pipeline_definition__unpack(NULL, packed_size, packed);
+		if (pipeline == NULL)
+		{
+			printf("%s: invalid configuration\n", name);
+			return;
+		}
+		printf("%s (%s):\n", name, config_encoding_name(encoding));
+		for (size_t i = 0; i < pipeline->n_modules; i++)
+		{
+			ModuleDefinition *module = pipeline->modules[i];
+			printf("  order %-3d %-20s param_id %d\n", module->order, module->name, module->param_id);
+		}
+		pipeline_definition__free_unpacked(pipeline, NULL);
+		return;
+	}
+
+	ModuleConfig *module_config = module_config__unpack(NULL, packed_size, packed);
+	if (module_config == NULL)
+	{
+		printf("%s: invalid configuration\n", name);
+		return;
+	}
+	printf("%s (%s):\n", name, config_encoding_name(encoding));
+	for (size_t i = 0; i < module_config->n_parameters; i++)
+	{
+		ConfigParameter *param = module_config->parameters[i];
+		switch (param->value_case)
+		{
+			case CONFIG_PARAMETER__VALUE_BOOL_VALUE:
+				printf("  %-20s %s\n", param->key, param->bool_value ? "true" : "false");
+				break;
+			case CONFIG_PARAMETER__VALUE_INT_VALUE:
+				printf("  %-20s %d\n", param->key, param->int_value);
+				break;
+			case CONFIG_PARAMETER__VALUE_FLOAT_VALUE:
+				printf("  %-20s %f\n", param->key, param->float_value);
+				break;
+			case CONFIG_PARAMETER__VALUE_STRING_VALUE:
+				printf("  %-20s \"%s\"\n", param->key, param->string_value);
+				break;
+			default:
+				printf("  %-20s <unset>\n", param->key);
+				break;
+		}
+	}
+	module_config__free_unpacked(module_config, NULL);
+}
+
+
+int ippc_configure_pipeline(int pipeline_id, const char *filename, const ippc_compile_opts_t *compile, const ippc_push_opts_t *push_opts, const unsigned int *nodes, int node_count)
+{
+	if (pipeline_id < 1 || pipeline_id > MAX_PIPELINES)
+	{
+		printf("Pipeline index is invalid. Range is 1-%d\n", MAX_PIPELINES);
+		return IPPC_EINVAL;
+	}
+	if (compile->upload != NULL && node_count > 1)
+	{
+		printf("--upload supports a single node\n");
+		return IPPC_EINVAL;
+	}
+
+	printf("Client: Configuring pipeline %d, using %s\n", pipeline_id, filename);
+
+	// Parse, pack and encode yaml file once for all nodes
+	config_push_t push = {.is_pipeline = 1, .diff = push_opts->diff, .timeout = push_opts->timeout, .paramver = push_opts->paramver, .ack_with_pull = push_opts->ack_with_pull};
+	if (compile_pipeline_config(filename, compile->tagged, compile->upload, &push.upload, push.buffer) < 0)
+		return IPPC_EINVAL;
+
+	// The parameter name must have the id
+	push.param_id = pipeline_id + PIPELINE_PARAMID_OFFSET - 1; // find correct pipeline id (Offset by +10 on pipeline server)
+	sprintf(push.name, "pipeline_config_%d", pipeline_id);
+
+	return push_config_fleet(&push, nodes, node_count, push_opts->retries);
+}
+
+int ippc_configure_module(int module_id, const char *filename, const ippc_compile_opts_t *compile, const ippc_push_opts_t *push_opts, const unsigned int *nodes, int node_count)
+{
+	if (module_id < 1 || module_id > MAX_MODULES)
+	{
+		printf("Module index is invalid. Range is 1-%d\n", MAX_MODULES);
+		return IPPC_EINVAL;
+	}
+	if (compile->schema != NULL && !module_schema_exists(compile->schema))
+	{
+		printf("Unknown module schema %s\n", compile->schema);
+		return IPPC_EINVAL;
+	}
+	if (compile->compact && compile->schema == NULL)
+	{
+		printf("Compact keys require a module schema\n");
+		return IPPC_EINVAL;
+	}
+	if (compile->upload != NULL && node_count > 1)
+	{
+		printf("--upload supports a single node\n");
+		return IPPC_EINVAL;
+	}
+
+	printf("Client: Configuring module %d, using %s\n", module_id, filename);
+
+	// Parse, pack and encode yaml file once for all nodes
+	config_push_t push = {.is_pipeline = 0, .diff = push_opts->diff, .timeout = push_opts->timeout, .paramver = push_opts->paramver, .ack_with_pull = push_opts->ack_with_pull};
+	if (compile_module_config(filename, compile->schema, compile->compact, compile->tagged, compile->upload, &push.upload, push.buffer) < 0)
+		return IPPC_EINVAL;
+
+	// The parameter name must have the id
+	push.param_id = module_id + MODULE_PARAMID_OFFSET - 1; // find correct parameter id (Offset by +30 on pipeline server)
+	sprintf(push.name, "module_param_%d", module_id);
+
+	return push_config_fleet(&push, nodes, node_count, push_opts->retries);
+}
+
+int ippc_apply(const char *manifest, const ippc_compile_opts_t *compile, const ippc_push_opts_t *push_opts, const unsigned int *nodes, int node_count)
+{
+	config_arena_t *arena = config_arena_create();
+	if (arena == NULL)
+		return IPPC_ENOMEM;
+
+	/* Parse the manifest once and compile every configuration before sending anything */
+	apply_entry_t entries[MAX_APPLY_ENTRIES];
+	int entry_count = 0;
+	int ret = load_apply_manifest(manifest, arena, entries, &entry_count);
+	for (int i = 0; ret >= 0 && i < entry_count; i++)
+		ret = compile_apply_entry(&entries[i], "Configuring", compile->compact, compile->tagged);
+	config_arena_destroy(arena);
+	if (ret < 0)
+		return IPPC_EINVAL;
+
+	apply_push_t push = {
+		.entries = entries,
+		.entry_count = entry_count,
+		.diff = push_opts->diff,
+		.timeout = push_opts->timeout,
+		.paramver = push_opts->paramver,
+		.ack_with_pull = push_opts->ack_with_pull,
+	};
+	config_fleet_remote_t remotes = {0};
+	push.remotes = &remotes;
+	for (int i = 0; push.diff && i < node_count; i++)
+	{
+		config_remote_t *remote = config_fleet_add(&remotes, nodes[i]);
+		for (int j = 0; j < entry_count; j++)
+			config_remote_add(remote, entries[j].param_id, entries[j].name, nodes[i]);
+	}
+
+	fleet_result_t results[node_count];
+	int failed = fleet_run(nodes, node_count, push_opts->retries, apply_config_task, &push, results);
+	config_fleet_release(&remotes);
+	if (node_count > 1)
+		fleet_print_results(results, node_count);
+	return failed > 0 ? IPPC_EIO : IPPC_OK;
+}
+
+int ippc_status(unsigned int node, unsigned int timeout, unsigned int paramver)
+{
+	config_remote_t remote = {0};
+	if (pull_all_config_params(&remote, node, timeout, paramver) < 0)
+	{
+		printf("No response\n");
+		config_remote_release(&remote);
+		return IPPC_EIO;
+	}
+
+	for (int i = 0; i < CONFIG_PARAM_COUNT; i++)
+	{
+		uint8_t current[DATA_PARAM_SIZE];
+		param_get_data(remote.params[i], current, DATA_PARAM_SIZE);
+		print_config_param(remote.params[i]->name, current, i < MAX_PIPELINES);
+	}
+
+	config_remote_release(&remote);
+	return IPPC_OK;
+}
+
+int ippc_save(const char *bundle, unsigned int node, unsigned int timeout, unsigned int paramver)
+{
+	config_remote_t remote = {0};
+	if (pull_all_config_params(&remote, node, timeout, paramver) < 0)
+	{
+		printf("No response\n");
+		config_remote_release(&remote);
+		return IPPC_EIO;
+	}
+
+	/* Keep configured parameters only */
+	config_bundle_entry_t entries[CONFIG_PARAM_COUNT];
+	int count = 0;
+	int uploaded = 0;
+	for (int i = 0; i < CONFIG_PARAM_COUNT; i++)
+	{
+		uint8_t current[DATA_PARAM_SIZE];
+		param_get_data(remote.params[i], current, DATA_PARAM_SIZE);
+		size_t used = config_buffer_size(current, DATA_PARAM_SIZE);
+		if (used == 0)
+			continue;
+
+		/* The descriptor alone would point at whatever the vmem address holds when restored */
+		if (is_vmem_descriptor(current))
+		{
+			printf("%s holds a configuration uploaded to vmem, which a bundle cannot hold\n", remote.params[i]->name);
+			uploaded++;
+			continue;
+		}
+
+		entries[count].param_id = remote.params[i]->id;
+		entries[count].length = used;
+		memcpy(entries[count].data, current, used);
+		count++;
+	}
+	config_remote_release(&remote);
+	if (uploaded > 0)
+	{
+		printf("Not saved, push the uploaded configurations from their files instead\n");
+		return IPPC_EINVAL;
+	}
+
+	if (config_bundle_write(bundle, entries, count) < 0)
+		return IPPC_EIO;
+
+	printf("Saved %d configurations from node %u to %s\n", count, node, bundle);
+	return IPPC_OK;
+}
+
+/* Push the buffers of a bundle to a node, with clear also the configuration parameters the bundle does not hold */
+static int push_bundle(const char *bundle_file, unsigned int node, const ippc_push_opts_t *push, int clear)
+{
+	config_bundle_entry_t bundle[CONFIG_PARAM_COUNT];
+	int count = config_bundle_read(bundle_file, bundle, CONFIG_PARAM_COUNT);
+	if (count < 0)
+		return IPPC_EINVAL;
+
+	apply_entry_t entries[MAX_APPLY_ENTRIES];
+	char held[CONFIG_PARAM_COUNT] = {0};
+	for (int i = 0; i < count; i++)
+	{
+		apply_entry_t *entry = &entries[i];
+		memset(entry, 0, sizeof(apply_entry_t));
+		int is_pipeline = config_param_name(bundle[i].param_id, entry->name);
+		int index = is_pipeline ? bundle[i].param_id - PIPELINE_PARAMID_OFFSET : MAX_PIPELINES + bundle[i].param_id - MODULE_PARAMID_OFFSET;
+		if (is_pipeline < 0 || bundle[i].length > DATA_PARAM_SIZE || held[index])
+		{
+			printf("Bundle entry for parameter %d is invalid\n", bundle[i].param_id);
+			return IPPC_EINVAL;
+		}
+		entry->param_id = bundle[i].param_id;
+		memcpy(entry->buffer, bundle[i].data, bundle[i].length);
+		if (is_vmem_descriptor(entry->buffer))
+		{
+			printf("Bundle entry for parameter %d is a vmem descriptor without its upload\n", bundle[i].param_id);
+			return IPPC_EINVAL;
+		}
+		held[index] = 1;
+	}
+
+	/* Zeroed buffers clear the parameters */
+	int entry_count = count;
+	for (int i = 0; clear && i < CONFIG_PARAM_COUNT; i++)
+	{
+		if (held[i])
+			continue;
+		apply_entry_t *entry = &entries[entry_count++];
+		memset(entry, 0, sizeof(apply_entry_t));
+		entry->param_id = config_param_id(i);
+		config_param_name(entry->param_id, entry->name);
+	}
+
+	int packets = push_config_batch(entries, entry_count, node, push->timeout, push->paramver, push->ack_with_pull);
+	if (packets < 0)
+		return IPPC_EIO;
+
+	if (clear)
+		printf("Pushed %d configurations and cleared %d to node %u in %d packets\n", count, entry_count - count, node, packets);
+	else
+		printf("Pushed %d configurations to node %u in %d packets\n", count, node, packets);
+	return IPPC_OK;
+}
+
+int ippc_restore(const char *bundle_file, unsigned int node, const ippc_push_opts_t *push)
+{
+	return push_bundle(bundle_file, node, push, 1);
+}
+
+int ippc_push_bin(const char *artifact_file, unsigned int node, const ippc_push_opts_t *push)
+{
+	return push_bundle(artifact_file, node, push, 0);
+}
+
+int ippc_compile(const char *filename, const char *artifact_file, int pipeline_id, int module_id, const ippc_compile_opts_t *compile)
+{
+	if (pipeline_id != 0 && module_id != 0)
+	{
+		printf("Only one of --pipeline and --module may be given\n");
+		return IPPC_EINVAL;
+	}
+	if (pipeline_id < 0 || pipeline_id > MAX_PIPELINES || module_id < 0 || module_id > MAX_MODULES)
+	{
+		printf("Pipeline index range is 1-%d, module index range is 1-%d\n", MAX_PIPELINES, MAX_MODULES);
+		return IPPC_EINVAL;
+	}
+	if (compile->schema != NULL && !module_schema_exists(compile->schema))
+	{
+		printf("Unknown module schema %s\n", compile->schema);
+		return IPPC_EINVAL;
+	}
+
+	config_arena_t *arena = config_arena_create();
+	if (arena == NULL)
+		return IPPC_ENOMEM;
+
+	/* Without an index the config file is a manifest */
+	apply_entry_t entries[MAX_APPLY_ENTRIES];
+	int entry_count = 1;
+	int ret = 0;
+	memset(&entries[0], 0, sizeof(apply_entry_t));
+	entries[0].pipeline_id = pipeline_id;
+	entries[0].module_id = module_id;
+	entries[0].file = (char *)filename;
+	entries[0].schema = (char *)compile->schema;
+	if (pipeline_id == 0 && module_id == 0)
+		ret = load_apply_manifest(filename, arena, entries, &entry_count);
+
+	/* Compile offline, configurations must fit a parameter */
+	config_bundle_entry_t artifact[MAX_APPLY_ENTRIES];
+	for (int i = 0; ret >= 0 && i < entry_count; i++)
+	{
+		ret = compile_apply_entry(&entries[i], "Compiling", compile->compact, compile->tagged);
+		if (ret < 0)
+			break;
+
+		artifact[i].param_id = entries[i].param_id;
+		artifact[i].length = ret;
+		memcpy(artifact[i].data, entries[i].buffer, ret);
+	}
+	config_arena_destroy(arena);
+	if (ret < 0)
+		return IPPC_EINVAL;
+
+	if (config_bundle_write(artifact_file, artifact, entry_count) < 0)
+		return IPPC_EIO;
+
+	printf("Compiled %d configurations into %s\n", entry_count, artifact_file);
+	return IPPC_OK;
+}
@@ -0,0 +1,665 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <pthread.h>
+#include <jxl/decode.h>
+
+#include "ippc.h"
+#include "ippc_context.h"
+#include "fleet.h"
+#include "metadata_filter.h"
+#include "ring_scheduler.h"
+#include "ring_cursor.h"
+#include "profile.h"
+#include "png_encode.h"
+
+char *ippc_metadata_string(Metadata *meta, const char *key)
+{
+	for (size_t i = 0; i < meta->n_items; i++)
+	{
+		if (strcmp(meta->items[i]->key, key) == 0)
+			return meta->items[i]->string_value;
+	}
+	return NULL;
+}
+
+int ippc_decode_observation(Metadata *meta, uint8_t *payload, uint8_t **pixels)
+{
+	uint32_t image_data_size = meta->size;
+
+	char *enc = ippc_metadata_string(meta, "enc");
+	int is_encoded = enc != NULL && !strcmp(enc, "jxl");
+	printf("Encoded: %d\n", is_encoded);
+	int width = meta->width;
+	int height = meta->height;
+	int channels = meta->channels;
+	uint8_t *data = payload;
+
+	if (is_encoded)
+	{
+		/* Decode image data using JXL */
+		uint64_t start = profile_start();
+		JxlDecoder* decoder = JxlDecoderCreate(NULL);
+		if (JxlDecoderSetInput(decoder, payload, image_data_size) == JXL_DEC_ERROR)
+		{
+			printf("Error: Could not decode image\n");
+			JxlDecoderDestroy(decoder);
+			return IPPC_EINVAL;
+		}
+
+		JxlBasicInfo basic_info;
+		size_t buffer_size;
+		JxlPixelFormat format;
+		uint8_t combined_channels;
+		JxlDecoderSubscribeEvents(decoder, JXL_DEC_BASIC_INFO | JXL_DEC_FULL_IMAGE | JXL_DEC_BASIC_INFO);
+		
+		while (1)
+		{
+			JxlDecoderStatus status = JxlDecoderProcessInput(decoder);
+
+			if (status == JXL_DEC_ERROR)
+			{
+				printf("Error: Jxl decoder error\n");
+				JxlDecoderDestroy(decoder);
+				if (data != payload)
+					free(data);
+				return IPPC_EINVAL;
+			}
+
+			if (status == JXL_DEC_SUCCESS) 
+			{
+				break;
+			}
+			
+			if (status == JXL_DEC_FULL_IMAGE) 
+			{
+				break;
+			}
+
+			if (status == JXL_DEC_BASIC_INFO) 
+			{
+				JxlDecoderGetBasicInfo(decoder, &basic_info);
+				combined_channels = basic_info.num_color_channels + basic_info.num_extra_channels;
+				format.num_channels = combined_channels; format.data_type = JXL_TYPE_UINT8; 
+				format.endianness = JXL_NATIVE_ENDIAN; format.align = 0;
+			}
+			
+			if (status == JXL_DEC_NEED_IMAGE_OUT_BUFFER) 
+			{
+				JxlDecoderImageOutBufferSize(decoder, &format, &buffer_size);
+				data = (uint8_t *)malloc(buffer_size);
+				JxlDecoderSetImageOutBuffer(decoder, &format, data, buffer_size);
+			}
+		}
+		JxlDecoderDestroy(decoder);
+		profile_end(PROFILE_DECODE, start, image_data_size);
+
+		if (basic_info.xsize != width || basic_info.ysize != height || combined_channels != channels)
+		{
+			printf("Info: Dimensions given by metadata do not match decoded dimensions\n");
+		}
+	}
+
+	*pixels = data;
+	return IPPC_OK;
+}
+
+int ippc_export_png(Metadata *meta, const uint8_t *pixels, const char *filename)
+{
+	int stride = meta->width * meta->channels;
+	uint64_t start = profile_start();
+	int png_size = 0;
+	uint8_t *png = png_encode(pixels, meta->width, meta->height, meta->channels, &png_size);
+	profile_end(PROFILE_PNG_ENCODE, start, (size_t)stride * meta->height);
+
+	start = profile_start();
+	FILE *fh = png != NULL ? fopen(filename, "wb") : NULL;
+	int write_success = fh != NULL && fwrite(png, 1, png_size, fh) == (size_t)png_size;
+	if (fh != NULL && fclose(fh) != 0)
+		write_success = 0;
+	profile_end(PROFILE_WRITE, start, png_size);
+	free(png);
+
+	if (!write_success)
+	{
+		fprintf(stderr, "Error writing image to %s\n", filename);
+		return IPPC_EIO;
+	}
+	printf("Image saved as %s\n", filename);
+	return IPPC_OK;
+}
+
+/* Decode an observation and save it as image_<camera><suffix>.png */
+static int save_observation(Metadata *meta, uint8_t *payload, const char *suffix, int save_png)
+{
+	uint8_t *pixels;
+	int ret = ippc_decode_observation(meta, payload, &pixels);
+	if (ret != IPPC_OK)
+		return ret;
+
+	if (save_png)
+	{
+		char filename[128];
+		snprintf(filename, sizeof(filename), "image_%s%s.png", meta->camera, suffix);
+		ret = ippc_export_png(meta, pixels, filename);
+	}
+
+	if (pixels != payload)
+		free(pixels);
+	return ret;
+}
+
+/* Most entries checked per page of a sync, and most pages per node and ring */
+#define SYNC_COUNT_MAX 1000
+#define SYNC_PAGES_MAX 64
+
+/* Outcome of one entry of a sync page */
+typedef enum
+{
+	SYNC_FAILED, // download, unpack or save failed
+	SYNC_SAVED,	 // new entry, saved or not matching the filter
+	SYNC_SEEN,	 // at or before the cursor
+	SYNC_REPEAT, // downloaded by an earlier page, the ring grew since
+} sync_status_t;
+
+typedef struct
+{
+	sync_status_t status;
+	long long timestamp;
+	uint32_t hash;
+} sync_entry_t;
+
+/* Sync state of one node and ring */
+typedef struct
+{
+	ring_cursor_t *cursor;
+	ring_mark_t synced;	   // cursor before the sync
+	ring_mark_t floor;	   // oldest entries of the pages before, newer ones were seen already
+	ring_mark_t candidate; // newest saved entries with no failed entry before them, timestamp -1 if none
+	int fresh;			   // entries newer than the cursor
+	int failed;
+	int paging; // older entries may still be new
+	int reached; // the cursor, the end of the ring or the start of a new cursor was reached
+} sync_source_t;
+
+typedef struct
+{
+	metadata_filter_t *filter;
+	sync_source_t *sources; // set when syncing, entries up to the cursors are skipped
+	int source_count;
+	ring_job_t *jobs;		// jobs of the sync page, with the outcome of each in entries
+	sync_entry_t *entries;
+	int save_png;
+	int multi_entry;  // several entries per ring, offsets go in the file name
+	int multi_source; // several nodes or rings, both go in the file name
+	pthread_mutex_t lock;
+	int matched;
+	ippc_progress_t *progress;
+} buffer_get_t;
+
+/* Unpack, filter and save one downloaded ring entry */
+static int buffer_get_entry(const ring_job_t *job, uint8_t *data, int size, void *arg)
+{
+	buffer_get_t *get = arg;
+	printf("Downloaded %d bytes from node %u in ring buffer '%s' at offset %d\n", size, job->node, job->ring, job->offset);
+
+	/* Extract image metadata */
+	size_t offset = 0;
+	uint32_t metadata_size = 0;
+	if (size >= (int)sizeof(uint32_t))
+		memcpy(&metadata_size, data, sizeof(uint32_t));
+	offset += sizeof(uint32_t);
+	if (size < (int)sizeof(uint32_t) || metadata_size > size - offset)
+	{
+		printf("Error: Entry at offset %d is too short for its metadata\n", job->offset);
+		return -1;
+	}
+	uint64_t start = profile_start();
+	Metadata *meta = metadata__unpack(NULL, metadata_size, data + offset);
+	profile_end(PROFILE_UNPACK, start, metadata_size);
+	offset += metadata_size;
+	if (meta == NULL)
+	{
+		printf("Error: Could not unpack metadata at offset %d\n", job->offset);
+		return -1;
+	}
+
+	/* Skip entries synced before, the cursor only moves past saved entries */
+	sync_entry_t *entry = get->entries != NULL ? &get->entries[job - get->jobs] : NULL;
+	for (int i = 0; entry != NULL && i < get->source_count; i++)
+	{
+		sync_source_t *source = &get->sources[i];
+		if (source->cursor->node != job->node || strcmp(source->cursor->ring, job->ring) != 0)
+			continue;
+		/* Entries of the same second as the cursor or the floor are told apart by their hash */
+		entry->timestamp = meta->timestamp;
+		entry->hash = ring_entry_hash(data, size);
+		int seen = meta->timestamp < source->synced.timestamp || ring_mark_has(&source->synced, entry->timestamp, entry->hash);
+		int repeat = meta->timestamp > source->floor.timestamp || ring_mark_has(&source->floor, entry->timestamp, entry->hash);
+		if (seen || repeat)
+		{
+			printf("Skipping offset %d, already synced\n", job->offset);
+			entry->status = seen ? SYNC_SEEN : SYNC_REPEAT;
+			metadata__free_unpacked(meta, NULL);
+			return 0;
+		}
+		pthread_mutex_lock(&get->lock);
+		source->fresh++;
+		pthread_mutex_unlock(&get->lock);
+	}
+
+	/* Skip decoding and export of entries not matching the filter */
+	if (!metadata_filter_match(get->filter, meta))
+	{
+		printf("Skipping offset %d, metadata does not match filter\n", job->offset);
+		if (entry != NULL)
+			entry->status = SYNC_SAVED;
+		metadata__free_unpacked(meta, NULL);
+		return 0;
+	}
+	pthread_mutex_lock(&get->lock);
+	get->matched++;
+	pthread_mutex_unlock(&get->lock);
+
+	char suffix[64] = "";
+	if (get->multi_source)
+		snprintf(suffix, sizeof(suffix), "_%u_%s_%d", job->node, job->ring, job->offset);
+	else if (get->multi_entry)
+		snprintf(suffix, sizeof(suffix), "_%d", job->offset);
+
+	int ret = save_observation(meta, data + offset, suffix, get->save_png) == IPPC_OK ? 0 : -1;
+	if (entry != NULL && ret == 0)
+		entry->status = SYNC_SAVED;
+	metadata__free_unpacked(meta, NULL);
+	return ret;
+}
+
+static void buffer_get_progress(int finished, uint64_t bytes, void *arg)
+{
+	buffer_get_t *get = arg;
+	ippc_progress_update(get->progress, finished, bytes);
+}
+
+/* Split a comma separated list in place, returns the number of items or -1 */
+static int split_list(char *list, char **items, int max)
+{
+	int count = 0;
+	char *save;
+	for (char *item = strtok_r(list, ",", &save); item != NULL; item = strtok_r(NULL, ",", &save))
+	{
+		if (count >= max)
+			return -1;
+		items[count++] = item;
+	}
+	return count;
+}
+
+/* Split a ring list, the images ring unless a list is given */
+static int parse_rings(const char *list, char *buf, size_t size, char **rings)
+{
+	snprintf(buf, size, "%s", list != NULL ? list : "images");
+	int ring_count = split_list(buf, rings, IPPC_MAX_RINGS);
+	if (ring_count <= 0)
+	{
+		printf("Ring list must have 1-%d rings\n", IPPC_MAX_RINGS);
+		return -1;
+	}
+	for (int i = 0; i < ring_count; i++)
+	{
+		if (strlen(rings[i]) >= RING_NAME_MAX)
+		{
+			printf("Ring name %s is too long\n", rings[i]);
+			return -1;
+		}
+	}
+	return ring_count;
+}
+
+/* Compile the filter of a download, returns -1 on invalid expressions */
+static int buffer_get_init(buffer_get_t *get, const ippc_download_opts_t *opts)
+{
+	get->save_png = opts->save_png;
+	get->progress = opts->progress;
+	if (opts->where != NULL)
+	{
+		get->filter = metadata_filter_compile(opts->where);
+		if (get->filter == NULL)
+			return -1;
+	}
+	pthread_mutex_init(&get->lock, NULL);
+	return 0;
+}
+
+static void buffer_get_destroy(buffer_get_t *get)
+{
+	pthread_mutex_destroy(&get->lock);
+	metadata_filter_free(get->filter);
+}
+
+int ippc_buffer_get(ippc_t *ippc, int input_offset, int front, unsigned int count, const unsigned int *nodes, int node_count, const ippc_download_opts_t *opts)
+{
+	char ring_buf[128];
+	char *rings[IPPC_MAX_RINGS];
+	int ring_count = parse_rings(opts->rings, ring_buf, sizeof(ring_buf), rings);
+	if (ring_count < 0)
+		return IPPC_EINVAL;
+	if (count == 0 || opts->per_node == 0 || opts->per_link == 0)
+	{
+		printf("Count and concurrency limits must be at least 1\n");
+		return IPPC_EINVAL;
+	}
+
+	/* Compile metadata filter */
+	buffer_get_t get = {.multi_entry = count > 1, .multi_source = node_count > 1 || ring_count > 1};
+	if (buffer_get_init(&get, opts) < 0)
+		return IPPC_EINVAL;
+
+	/* One job per entry, node and ring */
+	int job_count = node_count * ring_count * count;
+	ring_job_t *jobs = malloc(job_count * sizeof(ring_job_t));
+	if (jobs == NULL)
+	{
+		buffer_get_destroy(&get);
+		return IPPC_ENOMEM;
+	}
+	int job_idx = 0;
+	for (int n = 0; n < node_count; n++)
+	{
+		for (int r = 0; r < ring_count; r++)
+		{
+			for (unsigned int i = 0; i < count; i++)
+			{
+				jobs[job_idx].node = nodes[n];
+				jobs[job_idx].ring = rings[r];
+				jobs[job_idx].offset = front ? -(input_offset + (int)i) : input_offset + (int)i;
+				job_idx++;
+			}
+		}
+	}
+
+	ring_scheduler_config_t config = {
+		.per_node = opts->per_node,
+		.per_link = opts->per_link,
+		.timeout = opts->timeout,
+		.handler = buffer_get_entry,
+		.arg = &get,
+		.buffers = ippc != NULL ? &ippc->buffers : NULL,
+		.download = opts->download,
+	};
+	if (opts->progress != NULL)
+	{
+		ippc_progress_begin(opts->progress, job_count);
+		config.progress = buffer_get_progress;
+		config.cancel = &opts->progress->cancel;
+	}
+	ring_scheduler_stats_t stats;
+	int failed = ring_schedule(jobs, job_count, &config, &stats);
+
+	if (job_count > 1)
+		printf("Downloaded %d of %d entries, %llu bytes in %.0f ms (%.1f kB/s)\n", stats.downloaded, job_count, (unsigned long long)stats.bytes, stats.elapsed_ms, stats.elapsed_ms > 0 ? stats.bytes / stats.elapsed_ms : 0);
+	if (get.filter != NULL)
+		printf("%d of %d entries matched filter\n", get.matched, job_count);
+
+	buffer_get_destroy(&get);
+	free(jobs);
+	return failed > 0 ? IPPC_EINVAL : IPPC_OK;
+}
+
+/* Arguments of a queued download, copied from those of the command */
+typedef struct
+{
+	ippc_t *ippc;
+	int offset;
+	int front;
+	unsigned int count;
+	unsigned int nodes[FLEET_MAX_NODES];
+	int node_count;
+	ippc_download_opts_t opts;
+	char *rings;
+	char *where;
+} buffer_get_job_t;
+
+static int buffer_get_job(ippc_progress_t *progress, void *arg)
+{
+	buffer_get_job_t *job = arg;
+	job->opts.progress = progress;
+	return ippc_buffer_get(job->ippc, job->offset, job->front, job->count, job->nodes, job->node_count, &job->opts);
+}
+
+static void buffer_get_job_free(void *arg)
+{
+	buffer_get_job_t *job = arg;
+	free(job->rings);
+	free(job->where);
+	free(job);
+}
+
+int ippc_buffer_get_async(ippc_t *ippc, const char *description, int offset, int front, unsigned int count, const unsigned int *nodes, int node_count, const ippc_download_opts_t *opts)
+{
+	if (node_count > FLEET_MAX_NODES)
+	{
+		fprintf(stderr, "Error: At most %d nodes per job\n", FLEET_MAX_NODES);
+		return -1;
+	}
+
+	/* Report invalid arguments now rather than from a worker */
+	char ring_buf[128];
+	char *rings[IPPC_MAX_RINGS];
+	if (parse_rings(opts->rings, ring_buf, sizeof(ring_buf), rings) < 0)
+		return -1;
+	metadata_filter_t *filter = opts->where != NULL ? metadata_filter_compile(opts->where) : NULL;
+	if (opts->where != NULL && filter == NULL)
+		return -1;
+	metadata_filter_free(filter);
+
+	buffer_get_job_t *job = calloc(1, sizeof(buffer_get_job_t));
+	if (job == NULL)
+	{
+		fprintf(stderr, "Error: Failed to allocate memory for job\n");
+		return -1;
+	}
+	job->ippc = ippc;
+	job->offset = offset;
+	job->front = front;
+	job->count = count;
+	memcpy(job->nodes, nodes, node_count * sizeof(unsigned int));
+	job->node_count = node_count;
+	job->opts = *opts;
+	job->rings = opts->rings != NULL ? strdup(opts->rings) : NULL;
+	job->where = opts->where != NULL ? strdup(opts->where) : NULL;
+	job->opts.rings = job->rings;
+	job->opts.where = job->where;
+	if ((opts->rings != NULL && job->rings == NULL) || (opts->where != NULL && job->where == NULL))
+	{
+		fprintf(stderr, "Error: Failed to allocate memory for job\n");
+		buffer_get_job_free(job);
+		return -1;
+	}
+
+	int id = ippc_job_submit(description, buffer_get_job, job, buffer_get_job_free);
+	if (id < 0)
+		buffer_get_job_free(job);
+	return id;
+}
+
+/*
+ * Walk the entries of a sync page from the newest to the oldest. The cursor
+ * may only move to a saved entry with no failed entry before it, and the
+ * next page is needed while every entry is new.
+ */
+static void sync_page_done(sync_source_t *source, const ring_job_t *jobs, const sync_entry_t *entries, unsigned int count, int page)
+{
+	/* Failures past the last download are taken as the end of the ring */
+	int last = -1;
+	for (unsigned int i = 0; i < count; i++)
+	{
+		if (jobs[i].size >= 0)
+			last = i;
+	}
+	if (last < 0 && page == 0)
+		source->failed++;
+
+	source->paging = 0;
+	for (int i = 0; i <= last; i++)
+	{
+		if (entries[i].status == SYNC_SEEN)
+		{
+			source->reached = 1;
+			return;
+		}
+		if (entries[i].status == SYNC_REPEAT)
+			continue;
+		if (entries[i].status == SYNC_FAILED)
+		{
+			source->candidate.timestamp = -1;
+			source->failed++;
+			continue;
+		}
+		if (source->candidate.timestamp < 0 || entries[i].timestamp == source->candidate.timestamp)
+			ring_mark_add(&source->candidate, entries[i].timestamp, entries[i].hash);
+		if (entries[i].timestamp <= source->floor.timestamp)
+			ring_mark_add(&source->floor, entries[i].timestamp, entries[i].hash);
+	}
+
+	/* A new cursor starts at the newest entries rather than at the start of the ring */
+	if (last < (int)count - 1 || (source->synced.timestamp == 0 && source->synced.tie_count == 0))
+		source->reached = 1;
+	else
+		source->paging = page + 1 < SYNC_PAGES_MAX;
+}
+
+int ippc_buffer_sync(ippc_t *ippc, const char *cursor_file, unsigned int count, const unsigned int *nodes, int node_count, const ippc_download_opts_t *opts)
+{
+	char ring_buf[128];
+	char *rings[IPPC_MAX_RINGS];
+	int ring_count = parse_rings(opts->rings, ring_buf, sizeof(ring_buf), rings);
+	if (ring_count < 0)
+		return IPPC_EINVAL;
+	if (count == 0 || count > SYNC_COUNT_MAX || opts->per_node == 0 || opts->per_link == 0)
+	{
+		printf("Count must be 1-%d and concurrency limits at least 1\n", SYNC_COUNT_MAX);
+		return IPPC_EINVAL;
+	}
+	if (node_count > FLEET_MAX_NODES)
+	{
+		printf("At most %d nodes can be synced at once\n", FLEET_MAX_NODES);
+		return IPPC_EINVAL;
+	}
+
+	ring_cursor_set_t *cursors = malloc(sizeof(ring_cursor_set_t));
+	ring_job_t *jobs = malloc(node_count * count * sizeof(ring_job_t));
+	sync_entry_t *entries = malloc(node_count * count * sizeof(sync_entry_t));
+	if (cursors == NULL || jobs == NULL || entries == NULL)
+	{
+		free(cursors);
+		free(jobs);
+		free(entries);
+		return IPPC_ENOMEM;
+	}
+	int ret = IPPC_OK;
+	if (ring_cursor_load(cursor_file, cursors) < 0)
+	{
+		printf("Could not read cursors from %s\n", cursor_file);
+		ret = IPPC_EINVAL;
+	}
+
+	buffer_get_t get = {.multi_entry = 1, .multi_source = 1, .jobs = jobs, .entries = entries};
+	if (ret == IPPC_OK && buffer_get_init(&get, opts) < 0)
+		ret = IPPC_EINVAL;
+	int initialized = ret == IPPC_OK;
+
+	/* Rings are synced one after the other, so earlier rings in the list are downlinked first */
+	sync_source_t sources[FLEET_MAX_NODES];
+	for (int r = 0; r < ring_count && ret == IPPC_OK; r++)
+	{
+		for (int n = 0; n < node_count; n++)
+		{
+			sync_source_t *source = &sources[n];
+			memset(source, 0, sizeof(sync_source_t));
+			source->cursor = ring_cursor_get(cursors, nodes[n], rings[r]);
+			if (source->cursor == NULL)
+			{
+				printf("Too many cursors, at most %d are supported\n", RING_CURSOR_MAX);
+				ret = IPPC_EINVAL;
+				break;
+			}
+			source->synced = source->cursor->mark;
+			source->floor.timestamp = LLONG_MAX;
+			source->candidate.timestamp = -1;
+			source->paging = 1;
+		}
+		if (ret != IPPC_OK)
+			break;
+		get.sources = sources;
+		get.source_count = node_count;
+
+		/* Page back from the newest entries until every node reached its cursor */
+		for (int page = 0;; page++)
+		{
+			int paging[FLEET_MAX_NODES];
+			int paging_count = 0;
+			for (int n = 0; n < node_count; n++)
+			{
+				if (!sources[n].paging)
+					continue;
+				for (unsigned int i = 0; i < count; i++)
+				{
+					ring_job_t *job = &jobs[paging_count * count + i];
+					job->node = nodes[n];
+					job->ring = rings[r];
+					job->offset = -1 - (int)(page * count + i);
+					entries[paging_count * count + i].status = SYNC_FAILED;
+				}
+				paging[paging_count++] = n;
+			}
+			if (paging_count == 0)
+				break;
+
+			ring_scheduler_config_t config = {
+				.per_node = opts->per_node,
+				.per_link = opts->per_link,
+				.timeout = opts->timeout,
+				.handler = buffer_get_entry,
+				.arg = &get,
+				.buffers = ippc != NULL ? &ippc->buffers : NULL,
+				.download = opts->download,
+			};
+			ring_schedule(jobs, paging_count * count, &config, NULL);
+
+			for (int k = 0; k < paging_count; k++)
+				sync_page_done(&sources[paging[k]], &jobs[k * count], &entries[k * count], count, page);
+		}
+
+		for (int n = 0; n < node_count; n++)
+		{
+			sync_source_t *source = &sources[n];
+			/* Entries of the cursor second synced before stay synced */
+			if (source->reached && source->candidate.timestamp >= 0)
+			{
+				for (int t = 0; source->candidate.timestamp == source->synced.timestamp && t < source->synced.tie_count; t++)
+					ring_mark_add(&source->candidate, source->synced.timestamp, source->synced.ties[t]);
+				source->cursor->mark = source->candidate;
+			}
+			if (!source->reached)
+				printf("Node %u ring '%s': still new entries after %d pages, sync again or raise --count\n", nodes[n], rings[r], SYNC_PAGES_MAX);
+			if (source->failed > 0)
+			{
+				printf("Node %u ring '%s': %d downloads failed, cursor kept before them\n", nodes[n], rings[r], source->failed);
+				ret = IPPC_EIO;
+			}
+			printf("Node %u ring '%s': %d new entries, cursor at %lld\n", nodes[n], rings[r], source->fresh, source->cursor->mark.timestamp);
+		}
+
+		/* Persist progress after every ring */
+		if (ring_cursor_save(cursor_file, cursors) < 0)
+			ret = IPPC_EIO;
+	}
+
+	if (initialized)
+		buffer_get_destroy(&get);
+	free(cursors);
+	free(jobs);
+	free(entries);
+	return ret;
+}
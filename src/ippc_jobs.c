@@ -0,0 +1,249 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "ippc.h"
+#include "profile.h"
+#include "link_stats.h"
+
+typedef enum
+{
+	JOB_FREE,
+	JOB_QUEUED,
+	JOB_RUNNING,
+	JOB_DONE,
+	JOB_FAILED,
+	JOB_CANCELLED,
+} job_state_t;
+
+static const char *job_state_names[] = {"", "queued", "running", "done", "failed", "cancelled"};
+
+typedef struct
+{
+	int id;
+	job_state_t state;
+	char description[64];
+	ippc_job_fn_t run;
+	void *arg;
+	void (*release)(void *arg);
+	ippc_progress_t progress;
+	double started; // s, monotonic
+	double ended;
+} job_t;
+
+/* Guards the jobs and the progress of every download */
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t queued = PTHREAD_COND_INITIALIZER;
+static job_t jobs[IPPC_JOB_MAX];
+static int next_id = 1;
+static int workers;
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int job_finished(const job_t *job)
+{
+	return job->state == JOB_DONE || job->state == JOB_FAILED || job->state == JOB_CANCELLED;
+}
+
+/* Oldest queued job, called locked */
+static job_t *next_job(void)
+{
+	job_t *next = NULL;
+	for (int i = 0; i < IPPC_JOB_MAX; i++)
+	{
+		if (jobs[i].state == JOB_QUEUED && (next == NULL || jobs[i].id < next->id))
+			next = &jobs[i];
+	}
+	return next;
+}
+
+static void *job_worker(void *arg)
+{
+	/*
+	 * Profiling and tracing, from -P, -T, IPPC_PROFILE or IPPC_TRACE, belong
+	 * to the foreground command running at the time, not to jobs
+	 */
+	profile_mute(1);
+
+	pthread_mutex_lock(&lock);
+	while (1)
+	{
+		job_t *job = next_job();
+		if (job == NULL)
+		{
+			pthread_cond_wait(&queued, &lock);
+			continue;
+		}
+		job->state = JOB_RUNNING;
+		job->started = now();
+		pthread_mutex_unlock(&lock);
+
+		int ret = job->run(&job->progress, job->arg);
+		/* Jobs may end after the last command, which would flush their transfers */
+		link_stats_flush();
+
+		pthread_mutex_lock(&lock);
+		job->ended = now();
+		job->state = job->progress.cancel ? JOB_CANCELLED : ret == IPPC_OK ? JOB_DONE : JOB_FAILED;
+		if (job->release != NULL)
+			job->release(job->arg);
+		job->arg = NULL;
+	}
+	return NULL;
+}
+
+int ippc_job_submit(const char *description, ippc_job_fn_t run, void *arg, void (*release)(void *arg))
+{
+	pthread_mutex_lock(&lock);
+
+	/* A free slot, or the one of the oldest finished job */
+	job_t *job = NULL;
+	for (int i = 0; i < IPPC_JOB_MAX; i++)
+	{
+		if (jobs[i].state == JOB_FREE)
+		{
+			job = &jobs[i];
+			break;
+		}
+		if (job_finished(&jobs[i]) && (job == NULL || jobs[i].id < job->id))
+			job = &jobs[i];
+	}
+	if (job == NULL)
+	{
+		pthread_mutex_unlock(&lock);
+		fprintf(stderr, "Error: %d jobs are queued or running already\n", IPPC_JOB_MAX);
+		return -1;
+	}
+
+	/* Workers start with the first job */
+	for (; workers < IPPC_JOB_WORKERS; workers++)
+	{
+		pthread_t thread;
+		if (pthread_create(&thread, NULL, job_worker, NULL) != 0)
+			break;
+		pthread_detach(thread);
+	}
+	if (workers == 0)
+	{
+		pthread_mutex_unlock(&lock);
+		fprintf(stderr, "Error: Could not start job workers\n");
+		return -1;
+	}
+
+	memset(job, 0, sizeof(job_t));
+	job->id = next_id++;
+	job->state = JOB_QUEUED;
+	snprintf(job->description, sizeof(job->description), "%s", description);
+	job->run = run;
+	job->arg = arg;
+	job->release = release;
+	pthread_cond_signal(&queued);
+
+	int id = job->id;
+	pthread_mutex_unlock(&lock);
+	return id;
+}
+
+int ippc_job_cancel(int id)
+{
+	pthread_mutex_lock(&lock);
+	job_t *job = NULL;
+	for (int i = 0; i < IPPC_JOB_MAX && job == NULL; i++)
+	{
+		if (jobs[i].state != JOB_FREE && jobs[i].id == id)
+			job = &jobs[i];
+	}
+
+	int ret = IPPC_OK;
+	if (job == NULL || job_finished(job))
+	{
+		printf("No queued or running job %d\n", id);
+		ret = IPPC_EINVAL;
+	}
+	else if (job->state == JOB_QUEUED)
+	{
+		job->state = JOB_CANCELLED;
+		job->started = job->ended = now();
+		if (job->release != NULL)
+			job->release(job->arg);
+		job->arg = NULL;
+		printf("Cancelled job %d\n", id);
+	}
+	else
+	{
+		job->progress.cancel = 1;
+		printf("Cancelling job %d, downloads in flight finish first\n", id);
+	}
+	pthread_mutex_unlock(&lock);
+	return ret;
+}
+
+void ippc_jobs_print(void)
+{
+	pthread_mutex_lock(&lock);
+	int any = 0;
+	for (int i = 0; i < IPPC_JOB_MAX; i++)
+		any |= jobs[i].state != JOB_FREE;
+	if (!any)
+	{
+		printf("No jobs\n");
+		pthread_mutex_unlock(&lock);
+		return;
+	}
+	printf("%4s  %-9s  %11s  %12s  %9s  %8s  %s\n", "ID", "State", "Entries", "Bytes", "kB/s", "ETA [s]", "Command");
+
+	/* Oldest first */
+	for (int id = 0;;)
+	{
+		const job_t *job = NULL;
+		for (int i = 0; i < IPPC_JOB_MAX; i++)
+		{
+			if (jobs[i].state != JOB_FREE && jobs[i].id > id && (job == NULL || jobs[i].id < job->id))
+				job = &jobs[i];
+		}
+		if (job == NULL)
+			break;
+		id = job->id;
+
+		const ippc_progress_t *progress = &job->progress;
+		double elapsed = job->state == JOB_RUNNING ? now() - job->started : job->ended - job->started;
+		char entries[24];
+		snprintf(entries, sizeof(entries), "%d/%d", progress->finished, progress->total);
+		char rate[16] = "-";
+		if (elapsed > 0 && progress->bytes > 0)
+			snprintf(rate, sizeof(rate), "%.1f", progress->bytes / elapsed / 1e3);
+
+		/* Entries left at the pace of those finished so far */
+		char eta[16] = "-";
+		if (job->state == JOB_RUNNING && progress->finished > 0)
+			snprintf(eta, sizeof(eta), "%.1f", elapsed * (progress->total - progress->finished) / progress->finished);
+
+		printf("%4d  %-9s  %11s  %12llu  %9s  %8s  %s\n", job->id, job_state_names[job->state], entries,
+			   (unsigned long long)progress->bytes, rate, eta, job->description);
+	}
+	pthread_mutex_unlock(&lock);
+}
+
+void ippc_progress_begin(ippc_progress_t *progress, int total)
+{
+	pthread_mutex_lock(&lock);
+	progress->total = total;
+	progress->finished = 0;
+	progress->bytes = 0;
+	pthread_mutex_unlock(&lock);
+}
+
+void ippc_progress_update(ippc_progress_t *progress, int finished, uint64_t bytes)
+{
+	pthread_mutex_lock(&lock);
+	progress->finished = finished;
+	progress->bytes = bytes;
+	pthread_mutex_unlock(&lock);
+}
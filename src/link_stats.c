@@ -0,0 +1,395 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+
+#include "link_stats.h"
+
+const unsigned int link_stats_bounds[LINK_STATS_BUCKETS - 1] = {1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000};
+
+static const char *kind_names[LINK_KIND_COUNT] = {
+	[LINK_DOWNLOAD] = "download",
+	[LINK_PUSH] = "push",
+	[LINK_UPLOAD] = "upload",
+};
+
+static pthread_mutex_t session_lock = PTHREAD_MUTEX_INITIALIZER;
+static link_stats_set_t session;
+static __thread int thread_failure = -1;
+
+uint64_t link_stats_now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+link_stats_t *link_stats_get(link_stats_set_t *set, unsigned int node)
+{
+	for (int i = 0; i < set->count; i++)
+	{
+		if (set->nodes[i].node == node)
+			return &set->nodes[i];
+	}
+	if (set->count >= LINK_STATS_MAX_NODES)
+		return NULL;
+
+	link_stats_t *stats = &set->nodes[set->count++];
+	memset(stats, 0, sizeof(link_stats_t));
+	stats->node = node;
+	return stats;
+}
+
+void link_stats_record(link_kind_t kind, unsigned int node, uint64_t ns, size_t bytes, int failed)
+{
+	pthread_mutex_lock(&session_lock);
+	link_stats_t *stats = link_stats_get(&session, node);
+	if (failed)
+		thread_failure = kind;
+	if (stats != NULL)
+	{
+		link_counter_t *counter = &stats->kinds[kind];
+		if (failed)
+			counter->failures++;
+		else
+		{
+			int bucket = 0;
+			while (bucket < LINK_STATS_BUCKETS - 1 && ns > link_stats_bounds[bucket] * 1000000ULL)
+				bucket++;
+			counter->count++;
+			counter->bytes += bytes;
+			counter->ns += ns;
+			counter->hist[bucket]++;
+		}
+	}
+	pthread_mutex_unlock(&session_lock);
+}
+
+void link_stats_retry(link_kind_t kind, unsigned int node)
+{
+	pthread_mutex_lock(&session_lock);
+	link_stats_t *stats = link_stats_get(&session, node);
+	if (stats != NULL)
+		stats->kinds[kind].retries++;
+	pthread_mutex_unlock(&session_lock);
+}
+
+int link_stats_last_failure(void)
+{
+	int kind = thread_failure;
+	thread_failure = -1;
+	return kind;
+}
+
+const char *link_stats_file(void)
+{
+	const char *path = getenv("IPPC_STATS");
+	return path != NULL && path[0] != '\0' ? path : LINK_STATS_FILE;
+}
+
+static int parse_kind(const char *name)
+{
+	for (int i = 0; i < LINK_KIND_COUNT; i++)
+	{
+		if (strcmp(kind_names[i], name) == 0)
+			return i;
+	}
+	return -1;
+}
+
+int link_stats_load(const char *path, link_stats_set_t *set)
+{
+	set->count = 0;
+	FILE *fh = fopen(path, "r");
+	if (fh == NULL)
+		return errno == ENOENT ? 0 : -1;
+
+	char line[512];
+	int ret = 0;
+	while (fgets(line, sizeof(line), fh) != NULL)
+	{
+		if (line[0] == '#' || line[0] == '\n')
+			continue;
+
+		unsigned int node;
+		char name[16];
+		link_counter_t counter;
+		int pos = 0;
+		int kind = -1;
+		if (sscanf(line, "%u %15s %llu %llu %llu %llu %llu %lf %lld%n", &node, name, &counter.count, &counter.failures,
+				   &counter.retries, &counter.bytes, &counter.ns, &counter.rate, &counter.last, &pos) == 9)
+			kind = parse_kind(name);
+
+		char *cur = line + pos;
+		for (int i = 0; kind >= 0 && i < LINK_STATS_BUCKETS; i++)
+		{
+			char *end;
+			counter.hist[i] = strtoull(cur, &end, 10);
+			if (end == cur)
+				kind = -1;
+			cur = end;
+		}
+		if (kind < 0)
+		{
+			fprintf(stderr, "Error: Malformed statistics in %s: %s", path, line);
+			ret = -1;
+			break;
+		}
+
+		link_stats_t *stats = link_stats_get(set, node);
+		if (stats == NULL)
+		{
+			fprintf(stderr, "Error: %s has more than %d nodes\n", path, LINK_STATS_MAX_NODES);
+			ret = -1;
+			break;
+		}
+		stats->kinds[kind] = counter;
+	}
+
+	fclose(fh);
+	return ret;
+}
+
+int link_stats_save(const char *path, const link_stats_set_t *set)
+{
+	char tmp_path[PATH_MAX];
+	if (snprintf(tmp_path, sizeof(tmp_path), "%s.XXXXXX", path) >= (int)sizeof(tmp_path))
+	{
+		fprintf(stderr, "Error: Statistics path %s is too long\n", path);
+		return -1;
+	}
+	int fd = mkstemp(tmp_path);
+	FILE *fh = fd >= 0 ? fdopen(fd, "w") : NULL;
+	if (fh == NULL)
+	{
+		fprintf(stderr, "Error: Could not write statistics to %s\n", tmp_path);
+		if (fd >= 0)
+		{
+			close(fd);
+			remove(tmp_path);
+		}
+		return -1;
+	}
+	fchmod(fd, 0644);
+
+	fprintf(fh, "# node kind count failures retries bytes ns rate last histogram[%d]\n", LINK_STATS_BUCKETS);
+	for (int i = 0; i < set->count; i++)
+	{
+		for (int kind = 0; kind < LINK_KIND_COUNT; kind++)
+		{
+			const link_counter_t *counter = &set->nodes[i].kinds[kind];
+			if (counter->count == 0 && counter->failures == 0 && counter->retries == 0)
+				continue;
+			fprintf(fh, "%u %s %llu %llu %llu %llu %llu %.1f %lld", set->nodes[i].node, kind_names[kind], counter->count,
+					counter->failures, counter->retries, counter->bytes, counter->ns, counter->rate, counter->last);
+			for (int j = 0; j < LINK_STATS_BUCKETS; j++)
+				fprintf(fh, " %llu", counter->hist[j]);
+			fprintf(fh, "\n");
+		}
+	}
+
+	if (fclose(fh) != 0 || rename(tmp_path, path) < 0)
+	{
+		fprintf(stderr, "Error: Could not write statistics to %s\n", path);
+		remove(tmp_path);
+		return -1;
+	}
+	return 0;
+}
+
+/* Take the lock serializing updates of the statistics file between processes, closing it releases the lock */
+static int lock_file(const char *path)
+{
+	char lock_path[PATH_MAX];
+	if (snprintf(lock_path, sizeof(lock_path), "%s.lock", path) >= (int)sizeof(lock_path))
+	{
+		fprintf(stderr, "Error: Statistics path %s is too long\n", path);
+		return -1;
+	}
+	int fd = open(lock_path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+	if (fd < 0)
+	{
+		fprintf(stderr, "Error: Could not open %s\n", lock_path);
+		return -1;
+	}
+	while (flock(fd, LOCK_EX) < 0)
+	{
+		if (errno != EINTR)
+		{
+			fprintf(stderr, "Error: Could not lock %s\n", lock_path);
+			close(fd);
+			return -1;
+		}
+	}
+	return fd;
+}
+
+int link_stats_clear(const char *path)
+{
+	int lock = lock_file(path);
+	if (lock < 0)
+		return -1;
+	int ret = 0;
+	if (remove(path) < 0 && errno != ENOENT)
+	{
+		fprintf(stderr, "Error: Could not delete %s\n", path);
+		ret = -1;
+	}
+	close(lock);
+	return ret;
+}
+
+static void merge_counter(link_counter_t *total, const link_counter_t *counter, long long now)
+{
+	if (counter->ns > 0 && counter->bytes > 0)
+	{
+		double rate = counter->bytes / (counter->ns / 1e9);
+		total->rate = total->rate > 0 ? (1 - LINK_STATS_WEIGHT) * total->rate + LINK_STATS_WEIGHT * rate : rate;
+	}
+	total->count += counter->count;
+	total->failures += counter->failures;
+	total->retries += counter->retries;
+	total->bytes += counter->bytes;
+	total->ns += counter->ns;
+	total->last = now;
+	for (int i = 0; i < LINK_STATS_BUCKETS; i++)
+		total->hist[i] += counter->hist[i];
+}
+
+int link_stats_flush(void)
+{
+	pthread_mutex_lock(&session_lock);
+	link_stats_set_t current = session;
+	session.count = 0;
+	pthread_mutex_unlock(&session_lock);
+
+	if (current.count == 0)
+		return 0;
+
+	const char *path = link_stats_file();
+	link_stats_set_t *set = malloc(sizeof(link_stats_set_t));
+	if (set == NULL)
+		return -1;
+
+	/* Commands finishing at the same time must not lose each other's sessions */
+	int lock = lock_file(path);
+	if (lock < 0 || link_stats_load(path, set) < 0)
+	{
+		if (lock >= 0)
+			close(lock);
+		free(set);
+		return -1;
+	}
+
+	long long now = time(NULL);
+	int ret = 0;
+	for (int i = 0; i < current.count; i++)
+	{
+		link_stats_t *stats = link_stats_get(set, current.nodes[i].node);
+		if (stats == NULL)
+		{
+			fprintf(stderr, "Error: %s has more than %d nodes\n", path, LINK_STATS_MAX_NODES);
+			ret = -1;
+			break;
+		}
+		for (int kind = 0; kind < LINK_KIND_COUNT; kind++)
+		{
+			const link_counter_t *counter = &current.nodes[i].kinds[kind];
+			if (counter->count > 0 || counter->failures > 0 || counter->retries > 0)
+				merge_counter(&stats->kinds[kind], counter, now);
+		}
+	}
+
+	if (ret == 0)
+		ret = link_stats_save(path, set);
+	close(lock);
+	free(set);
+	return ret;
+}
+
+double link_stats_percentile(const link_counter_t *counter, double fraction)
+{
+	unsigned long long seen = 0;
+	for (int i = 0; i < LINK_STATS_BUCKETS - 1; i++)
+	{
+		seen += counter->hist[i];
+		if (counter->count > 0 && seen >= fraction * counter->count)
+			return link_stats_bounds[i];
+	}
+	/* Beyond the last bound, the mean is the best estimate left */
+	return counter->count > 0 ? counter->ns / 1e6 / counter->count : 0;
+}
+
+static void print_json(const link_stats_set_t *set, unsigned int node)
+{
+	int first = 1;
+	printf("[");
+	for (int i = 0; i < set->count; i++)
+	{
+		const link_stats_t *stats = &set->nodes[i];
+		if (node != 0 && stats->node != node)
+			continue;
+		printf("%s\n  {\"node\": %u", first ? "" : ",", stats->node);
+		first = 0;
+		for (int kind = 0; kind < LINK_KIND_COUNT; kind++)
+		{
+			const link_counter_t *counter = &stats->kinds[kind];
+			printf(", \"%s\": {\"count\": %llu, \"failures\": %llu, \"retries\": %llu, \"bytes\": %llu, \"ns\": %llu, "
+				   "\"rate\": %.1f, \"last\": %lld, \"histogram_ms\": [",
+				   kind_names[kind], counter->count, counter->failures, counter->retries, counter->bytes, counter->ns,
+				   counter->rate, counter->last);
+			for (int j = 0; j < LINK_STATS_BUCKETS; j++)
+			{
+				if (j < LINK_STATS_BUCKETS - 1)
+					printf("%s{\"le\": %u, \"count\": %llu}", j ? ", " : "", link_stats_bounds[j], counter->hist[j]);
+				else
+					printf(", {\"le\": null, \"count\": %llu}", counter->hist[j]);
+			}
+			printf("]}");
+		}
+		printf("}");
+	}
+	printf("\n]\n");
+}
+
+void link_stats_print(const link_stats_set_t *set, unsigned int node, int json)
+{
+	if (json)
+	{
+		print_json(set, node);
+		return;
+	}
+
+	printf("%-6s %-9s %8s %7s %7s %12s %11s %11s %8s %8s %s\n", "Node", "Kind", "Count", "Failed", "Retries", "Bytes",
+		   "Total kB/s", "Recent kB/s", "p50 ms", "p90 ms", "Last");
+	for (int i = 0; i < set->count; i++)
+	{
+		const link_stats_t *stats = &set->nodes[i];
+		if (node != 0 && stats->node != node)
+			continue;
+		for (int kind = 0; kind < LINK_KIND_COUNT; kind++)
+		{
+			const link_counter_t *counter = &stats->kinds[kind];
+			if (counter->count == 0 && counter->failures == 0 && counter->retries == 0)
+				continue;
+
+			char last[32] = "-";
+			time_t when = counter->last;
+			struct tm tm;
+			if (when > 0 && localtime_r(&when, &tm) != NULL)
+				strftime(last, sizeof(last), "%Y-%m-%d %H:%M", &tm);
+
+			double mean = counter->ns > 0 ? counter->bytes / (counter->ns / 1e9) / 1e3 : 0;
+			printf("%-6u %-9s %8llu %7llu %7llu %12llu %11.1f %11.1f %8.0f %8.0f %s\n", stats->node, kind_names[kind],
+				   counter->count, counter->failures, counter->retries, counter->bytes, mean, counter->rate / 1e3,
+				   link_stats_percentile(counter, 0.5), link_stats_percentile(counter, 0.9), last);
+		}
+	}
+}
@@ -0,0 +1,382 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "metadata_filter.h"
+
+typedef enum
+{
+	NODE_OR,
+	NODE_AND,
+	NODE_NOT,
+	NODE_COMPARE,
+	NODE_TRUTH,
+} node_type_t;
+
+typedef enum
+{
+	OP_EQ,
+	OP_NE,
+	OP_LT,
+	OP_LE,
+	OP_GT,
+	OP_GE,
+} compare_op_t;
+
+typedef enum
+{
+	VALUE_NONE,
+	VALUE_NUMBER,
+	VALUE_STRING,
+} value_type_t;
+
+typedef struct
+{
+	value_type_t type;
+	double number;
+	const char *string;
+} filter_value_t;
+
+typedef struct filter_node
+{
+	node_type_t type;
+	compare_op_t op;
+	char *ident;
+	char *string; // owned storage for string literals
+	filter_value_t literal;
+	struct filter_node *left;
+	struct filter_node *right;
+} filter_node_t;
+
+struct metadata_filter
+{
+	filter_node_t *root;
+};
+
+typedef struct
+{
+	const char *expr;
+	const char *pos;
+	int failed;
+} filter_parser_t;
+
+static void free_node(filter_node_t *node)
+{
+	if (node == NULL)
+		return;
+	free_node(node->left);
+	free_node(node->right);
+	free(node->ident);
+	free(node->string);
+	free(node);
+}
+
+static void parse_error(filter_parser_t *p, const char *msg)
+{
+	if (p->failed)
+		return;
+	p->failed = 1;
+	fprintf(stderr, "Error: Filter %s at position %ld: \"%s\"\n", msg, (long)(p->pos - p->expr), p->expr);
+}
+
+static void skip_space(filter_parser_t *p)
+{
+	while (isspace((unsigned char)*p->pos))
+		p->pos++;
+}
+
+static int accept(filter_parser_t *p, const char *token)
+{
+	skip_space(p);
+	size_t len = strlen(token);
+	if (strncmp(p->pos, token, len) == 0)
+	{
+		p->pos += len;
+		return 1;
+	}
+	return 0;
+}
+
+static filter_node_t *new_node(node_type_t type, filter_node_t *left, filter_node_t *right)
+{
+	filter_node_t *node = calloc(1, sizeof(filter_node_t));
+	if (node == NULL)
+	{
+		free_node(left);
+		free_node(right);
+		return NULL;
+	}
+	node->type = type;
+	node->left = left;
+	node->right = right;
+	return node;
+}
+
+static char *parse_ident(filter_parser_t *p)
+{
+	skip_space(p);
+	const char *start = p->pos;
+	while (isalnum((unsigned char)*p->pos) || *p->pos == '_' || *p->pos == '.' || *p->pos == '-')
+		p->pos++;
+	if (p->pos == start)
+	{
+		parse_error(p, "expected identifier");
+		return NULL;
+	}
+	return strndup(start, p->pos - start);
+}
+
+static int parse_literal(filter_parser_t *p, filter_node_t *node)
+{
+	skip_space(p);
+	if (*p->pos == '"' || *p->pos == '\'')
+	{
+		char quote = *p->pos++;
+		const char *start = p->pos;
+		while (*p->pos != '\0' && *p->pos != quote)
+			p->pos++;
+		if (*p->pos != quote)
+		{
+			parse_error(p, "has unterminated string");
+			return -1;
+		}
+		node->string = strndup(start, p->pos - start);
+		node->literal.type = VALUE_STRING;
+		node->literal.string = node->string;
+		p->pos++;
+		return 0;
+	}
+	if (accept(p, "true"))
+	{
+		node->literal.type = VALUE_NUMBER;
+		node->literal.number = 1;
+		return 0;
+	}
+	if (accept(p, "false"))
+	{
+		node->literal.type = VALUE_NUMBER;
+		node->literal.number = 0;
+		return 0;
+	}
+
+	char *endptr;
+	double val = strtod(p->pos, &endptr);
+	if (endptr == p->pos)
+	{
+		parse_error(p, "expected literal");
+		return -1;
+	}
+	p->pos = endptr;
+	node->literal.type = VALUE_NUMBER;
+	node->literal.number = val;
+	return 0;
+}
+
+static filter_node_t *parse_or(filter_parser_t *p);
+
+static filter_node_t *parse_unary(filter_parser_t *p)
+{
+	if (accept(p, "!"))
+		return new_node(NODE_NOT, parse_unary(p), NULL);
+
+	if (accept(p, "("))
+	{
+		filter_node_t *node = parse_or(p);
+		if (!accept(p, ")"))
+			parse_error(p, "expected ')'");
+		return node;
+	}
+
+	filter_node_t *node = new_node(NODE_TRUTH, NULL, NULL);
+	if (node == NULL)
+		return NULL;
+	node->ident = parse_ident(p);
+	if (node->ident == NULL)
+		return node;
+
+	/* Two character operators must be tried first */
+	static const struct
+	{
+		const char *token;
+		compare_op_t op;
+	} ops[] = {
+		{"==", OP_EQ}, {"!=", OP_NE}, {"<=", OP_LE}, {">=", OP_GE}, {"<", OP_LT}, {">", OP_GT},
+	};
+	for (size_t i = 0; i < sizeof(ops) / sizeof(ops[0]); i++)
+	{
+		if (accept(p, ops[i].token))
+		{
+			node->type = NODE_COMPARE;
+			node->op = ops[i].op;
+			parse_literal(p, node);
+			break;
+		}
+	}
+	return node;
+}
+
+static filter_node_t *parse_and(filter_parser_t *p)
+{
+	filter_node_t *node = parse_unary(p);
+	while (!p->failed && accept(p, "&&"))
+		node = new_node(NODE_AND, node, parse_unary(p));
+	return node;
+}
+
+static filter_node_t *parse_or(filter_parser_t *p)
+{
+	filter_node_t *node = parse_and(p);
+	while (!p->failed && accept(p, "||"))
+		node = new_node(NODE_OR, node, parse_and(p));
+	return node;
+}
+
+metadata_filter_t *metadata_filter_compile(const char *expr)
+{
+	filter_parser_t p = {.expr = expr, .pos = expr, .failed = 0};
+	filter_node_t *root = parse_or(&p);
+
+	skip_space(&p);
+	if (!p.failed && *p.pos != '\0')
+		parse_error(&p, "has trailing characters");
+	if (!p.failed && root == NULL)
+	{
+		fprintf(stderr, "Error: Failed to allocate memory for filter\n");
+		p.failed = 1;
+	}
+
+	metadata_filter_t *filter = p.failed ? NULL : malloc(sizeof(metadata_filter_t));
+	if (filter == NULL)
+	{
+		free_node(root);
+		return NULL;
+	}
+	filter->root = root;
+	return filter;
+}
+
+void metadata_filter_free(metadata_filter_t *filter)
+{
+	if (filter == NULL)
+		return;
+	free_node(filter->root);
+	free(filter);
+}
+
+static filter_value_t lookup_value(const Metadata *meta, const char *ident)
+{
+	filter_value_t value = {.type = VALUE_NUMBER};
+	if (strcmp(ident, "size") == 0)
+		value.number = meta->size;
+	else if (strcmp(ident, "height") == 0)
+		value.number = meta->height;
+	else if (strcmp(ident, "width") == 0)
+		value.number = meta->width;
+	else if (strcmp(ident, "channels") == 0)
+		value.number = meta->channels;
+	else if (strcmp(ident, "timestamp") == 0)
+		value.number = meta->timestamp;
+	else if (strcmp(ident, "bits_pixel") == 0)
+		value.number = meta->bits_pixel;
+	else if (strcmp(ident, "camera") == 0)
+	{
+		value.type = VALUE_STRING;
+		value.string = meta->camera;
+	}
+	else
+	{
+		/* Fall back to custom metadata items */
+		value.type = VALUE_NONE;
+		for (size_t i = 0; i < meta->n_items; i++)
+		{
+			MetadataItem *item = meta->items[i];
+			if (strcmp(item->key, ident) != 0)
+				continue;
+			value.type = VALUE_NUMBER;
+			switch (item->value_case)
+			{
+				case METADATA_ITEM__VALUE_BOOL_VALUE:
+					value.number = item->bool_value;
+					break;
+				case METADATA_ITEM__VALUE_INT_VALUE:
+					value.number = item->int_value;
+					break;
+				case METADATA_ITEM__VALUE_FLOAT_VALUE:
+					value.number = item->float_value;
+					break;
+				case METADATA_ITEM__VALUE_STRING_VALUE:
+					value.type = VALUE_STRING;
+					value.string = item->string_value;
+					break;
+				default:
+					value.type = VALUE_NONE;
+					break;
+			}
+			break;
+		}
+	}
+	return value;
+}
+
+static int compare_values(compare_op_t op, filter_value_t a, filter_value_t b)
+{
+	if (a.type == VALUE_NONE || a.type != b.type)
+		return 0;
+
+	int cmp;
+	if (a.type == VALUE_STRING)
+		cmp = strcmp(a.string ? a.string : "", b.string);
+	else
+		cmp = (a.number > b.number) - (a.number < b.number);
+
+	switch (op)
+	{
+		case OP_EQ:
+			return cmp == 0;
+		case OP_NE:
+			return cmp != 0;
+		case OP_LT:
+			return cmp < 0;
+		case OP_LE:
+			return cmp <= 0;
+		case OP_GT:
+			return cmp > 0;
+		case OP_GE:
+			return cmp >= 0;
+	}
+	return 0;
+}
+
+static int eval_node(const filter_node_t *node, const Metadata *meta)
+{
+	if (node == NULL)
+		return 0;
+
+	switch (node->type)
+	{
+		case NODE_OR:
+			return eval_node(node->left, meta) || eval_node(node->right, meta);
+		case NODE_AND:
+			return eval_node(node->left, meta) && eval_node(node->right, meta);
+		case NODE_NOT:
+			return !eval_node(node->left, meta);
+		case NODE_COMPARE:
+			return compare_values(node->op, lookup_value(meta, node->ident), node->literal);
+		case NODE_TRUTH:
+		{
+			filter_value_t value = lookup_value(meta, node->ident);
+			if (value.type == VALUE_STRING)
+				return value.string != NULL && value.string[0] != '\0';
+			return value.type == VALUE_NUMBER && value.number != 0;
+		}
+	}
+	return 0;
+}
+
+int metadata_filter_match(const metadata_filter_t *filter, const Metadata *meta)
+{
+	if (filter == NULL)
+		return 1;
+	return eval_node(filter->root, meta);
+}
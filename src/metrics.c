@@ -0,0 +1,281 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+
+#include "metrics.h"
+#include "profile.h"
+#include "link_stats.h"
+#include "config_cache.h"
+
+typedef struct
+{
+	double calls[PROFILE_PHASE_COUNT];
+	double seconds[PROFILE_PHASE_COUNT];
+	double bytes[PROFILE_PHASE_COUNT];
+	double cache_hits;
+	double cache_misses;
+} metrics_totals_t;
+
+/* Cache counters already exported, they count from the start of the process */
+static unsigned int exported_hits = 0;
+static unsigned int exported_misses = 0;
+
+const char *metrics_file(void)
+{
+	const char *path = getenv("IPPC_METRICS");
+	return path != NULL && path[0] != '\0' ? path : NULL;
+}
+
+/* Phase names with underscores, as label values */
+static void phase_label(profile_phase_t phase, char *label, size_t size)
+{
+	snprintf(label, size, "%s", profile_phase_name(phase));
+	for (char *c = label; *c != '\0'; c++)
+	{
+		if (*c == ' ')
+			*c = '_';
+	}
+}
+
+static int find_phase(const char *label)
+{
+	char name[32];
+	for (int i = 0; i < PROFILE_PHASE_COUNT; i++)
+	{
+		phase_label(i, name, sizeof(name));
+		if (strcmp(name, label) == 0)
+			return i;
+	}
+	return -1;
+}
+
+/* Read the totals of the previous export, a missing or foreign file starts from zero */
+static void read_totals(const char *path, metrics_totals_t *totals)
+{
+	memset(totals, 0, sizeof(metrics_totals_t));
+	FILE *fh = fopen(path, "r");
+	if (fh == NULL)
+		return;
+
+	char line[256];
+	while (fgets(line, sizeof(line), fh) != NULL)
+	{
+		char metric[64];
+		char label[32];
+		double value;
+		if (sscanf(line, "ippc_phase_%63[a-z_]{phase=\"%31[^\"]\"} %lf", metric, label, &value) == 3)
+		{
+			int phase = find_phase(label);
+			if (phase < 0)
+				continue;
+			if (strcmp(metric, "calls_total") == 0)
+				totals->calls[phase] = value;
+			else if (strcmp(metric, "seconds_total") == 0)
+				totals->seconds[phase] = value;
+			else if (strcmp(metric, "bytes_total") == 0)
+				totals->bytes[phase] = value;
+		}
+		else if (sscanf(line, "ippc_config_cache_hits_total %lf", &value) == 1)
+			totals->cache_hits = value;
+		else if (sscanf(line, "ippc_config_cache_misses_total %lf", &value) == 1)
+			totals->cache_misses = value;
+	}
+	fclose(fh);
+}
+
+static void write_header(FILE *fh, const char *name, const char *type, const char *help)
+{
+	fprintf(fh, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+static void write_transfers(FILE *fh, const link_stats_set_t *set)
+{
+	static const char *kinds[LINK_KIND_COUNT] = {"download", "push", "upload"};
+	static const struct
+	{
+		const char *name;
+		const char *type;
+		const char *help;
+	} metrics[] = {
+		{"ippc_transfers_total", "counter", "Successful ring downloads, parameter pushes and vmem uploads."},
+		{"ippc_transfer_failures_total", "counter", "Failed ring downloads, parameter pushes and vmem uploads."},
+		{"ippc_transfer_retries_total", "counter", "Attempts retried after a failed transfer."},
+		{"ippc_transfer_bytes_total", "counter", "Bytes of successful transfers."},
+		{"ippc_transfer_rate_bytes_per_second", "gauge", "Throughput averaged over recent sessions."},
+	};
+
+	for (size_t m = 0; m < sizeof(metrics) / sizeof(metrics[0]); m++)
+	{
+		write_header(fh, metrics[m].name, metrics[m].type, metrics[m].help);
+		for (int i = 0; i < set->count; i++)
+		{
+			for (int kind = 0; kind < LINK_KIND_COUNT; kind++)
+			{
+				const link_counter_t *counter = &set->nodes[i].kinds[kind];
+				double values[] = {counter->count, counter->failures, counter->retries, counter->bytes, counter->rate};
+				fprintf(fh, "%s{node=\"%u\",kind=\"%s\"} %.15g\n", metrics[m].name, set->nodes[i].node, kinds[kind], values[m]);
+			}
+		}
+	}
+
+	write_header(fh, "ippc_transfer_latency_seconds", "histogram", "Latency of successful transfers, including the ack of pushes.");
+	for (int i = 0; i < set->count; i++)
+	{
+		for (int kind = 0; kind < LINK_KIND_COUNT; kind++)
+		{
+			const link_counter_t *counter = &set->nodes[i].kinds[kind];
+			unsigned long long cumulative = 0;
+			for (int j = 0; j < LINK_STATS_BUCKETS; j++)
+			{
+				cumulative += counter->hist[j];
+				if (j < LINK_STATS_BUCKETS - 1)
+					fprintf(fh, "ippc_transfer_latency_seconds_bucket{node=\"%u\",kind=\"%s\",le=\"%g\"} %llu\n",
+							set->nodes[i].node, kinds[kind], link_stats_bounds[j] / 1e3, cumulative);
+				else
+					fprintf(fh, "ippc_transfer_latency_seconds_bucket{node=\"%u\",kind=\"%s\",le=\"+Inf\"} %llu\n",
+							set->nodes[i].node, kinds[kind], cumulative);
+			}
+			fprintf(fh, "ippc_transfer_latency_seconds_sum{node=\"%u\",kind=\"%s\"} %.9f\n", set->nodes[i].node, kinds[kind], counter->ns / 1e9);
+			fprintf(fh, "ippc_transfer_latency_seconds_count{node=\"%u\",kind=\"%s\"} %llu\n", set->nodes[i].node, kinds[kind], counter->count);
+		}
+	}
+}
+
+static void write_phases(FILE *fh, const metrics_totals_t *totals)
+{
+	static const char *names[] = {"calls_total", "seconds_total", "bytes_total"};
+	static const char *help[] = {
+		"Times a phase of a command ran.",
+		"Time spent in a phase, added over threads.",
+		"Bytes processed by a phase.",
+	};
+
+	for (int m = 0; m < 3; m++)
+	{
+		char name[64];
+		snprintf(name, sizeof(name), "ippc_phase_%s", names[m]);
+		write_header(fh, name, "counter", help[m]);
+		for (int i = 0; i < PROFILE_PHASE_COUNT; i++)
+		{
+			char label[32];
+			phase_label(i, label, sizeof(label));
+			double value = m == 0 ? totals->calls[i] : m == 1 ? totals->seconds[i] : totals->bytes[i];
+			fprintf(fh, "%s{phase=\"%s\"} %.15g\n", name, label, value);
+		}
+	}
+}
+
+/* Take the lock of the metrics file, held from reading the totals until the new file is in place */
+static int lock_file(const char *path)
+{
+	char lock_path[PATH_MAX];
+	if (snprintf(lock_path, sizeof(lock_path), "%s.lock", path) >= (int)sizeof(lock_path))
+	{
+		fprintf(stderr, "Error: Metrics path %s is too long\n", path);
+		return -1;
+	}
+	int fd = open(lock_path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+	if (fd < 0)
+	{
+		fprintf(stderr, "Error: Could not open %s\n", lock_path);
+		return -1;
+	}
+	while (flock(fd, LOCK_EX) < 0)
+	{
+		if (errno != EINTR)
+		{
+			fprintf(stderr, "Error: Could not lock %s\n", lock_path);
+			close(fd);
+			return -1;
+		}
+	}
+	return fd;
+}
+
+/* Add the counters of this process to the totals of the file, with the file locked so concurrent commands add up */
+static int write_locked(const char *path)
+{
+	metrics_totals_t totals;
+	read_totals(path, &totals);
+
+	for (int i = 0; i < PROFILE_PHASE_COUNT; i++)
+	{
+		unsigned int calls;
+		uint64_t ns;
+		uint64_t bytes;
+		profile_totals(i, &calls, &ns, &bytes);
+		totals.calls[i] += calls;
+		totals.seconds[i] += ns / 1e9;
+		totals.bytes[i] += bytes;
+	}
+
+	unsigned int hits;
+	unsigned int misses;
+	config_cache_stats(&hits, &misses);
+	totals.cache_hits += hits - exported_hits;
+	totals.cache_misses += misses - exported_misses;
+
+	link_stats_set_t *set = malloc(sizeof(link_stats_set_t));
+	if (set == NULL || link_stats_load(link_stats_file(), set) < 0)
+	{
+		fprintf(stderr, "Error: Could not read statistics for metrics\n");
+		free(set);
+		return -1;
+	}
+
+	char tmp_path[PATH_MAX];
+	if (snprintf(tmp_path, sizeof(tmp_path), "%s.XXXXXX", path) >= (int)sizeof(tmp_path))
+	{
+		fprintf(stderr, "Error: Metrics path %s is too long\n", path);
+		free(set);
+		return -1;
+	}
+	int fd = mkstemp(tmp_path);
+	FILE *fh = fd >= 0 ? fdopen(fd, "w") : NULL;
+	if (fh == NULL)
+	{
+		fprintf(stderr, "Error: Could not write metrics to %s\n", tmp_path);
+		if (fd >= 0)
+		{
+			close(fd);
+			remove(tmp_path);
+		}
+		free(set);
+		return -1;
+	}
+	fchmod(fd, 0644);
+
+	write_transfers(fh, set);
+	write_phases(fh, &totals);
+	write_header(fh, "ippc_config_cache_hits_total", "counter", "Configuration compilations served from the cache.");
+	fprintf(fh, "ippc_config_cache_hits_total %.15g\n", totals.cache_hits);
+	write_header(fh, "ippc_config_cache_misses_total", "counter", "Configuration compilations not found in the cache.");
+	fprintf(fh, "ippc_config_cache_misses_total %.15g\n", totals.cache_misses);
+	free(set);
+
+	if (fclose(fh) != 0 || rename(tmp_path, path) < 0)
+	{
+		fprintf(stderr, "Error: Could not write metrics to %s\n", path);
+		remove(tmp_path);
+		return -1;
+	}
+	exported_hits = hits;
+	exported_misses = misses;
+	return 0;
+}
+
+int metrics_write(const char *path)
+{
+	int lock = lock_file(path);
+	if (lock < 0)
+		return -1;
+	int ret = write_locked(path);
+	close(lock);
+	return ret;
+}
@@ -0,0 +1,98 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "module_schema.h"
+
+static const module_schema_key_t schema_keys[] = {
+#define MODULE_SCHEMA(module)
+#define SCHEMA_KEY(module, id, key, type) {#module, id, #key, type, #id},
+#include "module_schemas.def"
+#undef MODULE_SCHEMA
+#undef SCHEMA_KEY
+};
+
+static const char *const schema_modules[] = {
+#define MODULE_SCHEMA(module) #module,
+#define SCHEMA_KEY(module, id, key, type)
+#include "module_schemas.def"
+#undef MODULE_SCHEMA
+#undef SCHEMA_KEY
+};
+
+static const char schema_table[] =
+#define MODULE_SCHEMA(module) #module ":\n"
+#define SCHEMA_KEY(module, id, key, type) #id " " #key " " #type "\n"
+#include "module_schemas.def"
+#undef MODULE_SCHEMA
+#undef SCHEMA_KEY
+	;
+
+#define SCHEMA_KEY_COUNT (sizeof(schema_keys) / sizeof(schema_keys[0]))
+#define SCHEMA_MODULE_COUNT (sizeof(schema_modules) / sizeof(schema_modules[0]))
+
+int module_schema_exists(const char *module)
+{
+	for (size_t i = 0; i < SCHEMA_MODULE_COUNT; i++)
+	{
+		if (strcmp(schema_modules[i], module) == 0)
+			return 1;
+	}
+	return 0;
+}
+
+const module_schema_key_t *module_schema_lookup(const char *module, const char *key)
+{
+	for (size_t i = 0; i < SCHEMA_KEY_COUNT; i++)
+	{
+		if (strcmp(schema_keys[i].module, module) == 0 && strcmp(schema_keys[i].key, key) == 0)
+			return &schema_keys[i];
+	}
+	return NULL;
+}
+
+const module_schema_key_t *module_schema_lookup_id(const char *module, int id)
+{
+	for (size_t i = 0; i < SCHEMA_KEY_COUNT; i++)
+	{
+		if (strcmp(schema_keys[i].module, module) == 0 && schema_keys[i].id == id)
+			return &schema_keys[i];
+	}
+	return NULL;
+}
+
+const char *module_schema_table(void)
+{
+	return schema_table;
+}
+
+void module_schema_print(void)
+{
+	for (size_t m = 0; m < SCHEMA_MODULE_COUNT; m++)
+	{
+		printf("%s:\n", schema_modules[m]);
+		for (size_t i = 0; i < SCHEMA_KEY_COUNT; i++)
+		{
+			if (strcmp(schema_keys[i].module, schema_modules[m]) == 0)
+				printf("  %3d  %-20s type %d\n", schema_keys[i].id, schema_keys[i].key, schema_keys[i].type);
+		}
+	}
+}
+
+int module_schema_compact(const char *module, ModuleConfig *module_config)
+{
+	int replaced = 0;
+	for (size_t i = 0; i < module_config->n_parameters; i++)
+	{
+		ConfigParameter *param = module_config->parameters[i];
+		const module_schema_key_t *entry = module_schema_lookup(module, param->key);
+		if (entry == NULL)
+		{
+			printf("Info: Key \"%s\" is not in the %s schema and is sent in full\n", param->key, module);
+			continue;
+		}
+
+		param->key = (char *)entry->compact_key;
+		replaced++;
+	}
+	return replaced;
+}
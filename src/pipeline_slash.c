@@ -1,247 +1,166 @@
 #include <stdio.h>
 #include <stdlib.h>
-#include <sys/types.h>
+#include <stdbool.h>
+#include <limits.h>
 #include <slash/slash.h>
 #include <slash/optparse.h>
 #include <slash/dflopt.h>
-#include <param/param.h>
-#include <param/param_client.h>
 #include <vmem/vmem_client.h>
-#include <vmem/vmem_server.h>
-#include <yaml.h>
-#include <errno.h>
-#include <math.h>
-#include <jxl/decode.h>
-#include <brotli/encode.h>
-
-#include "pipeline_config.pb-c.h"
-#include "module_config.pb-c.h"
-#include "metadata.pb-c.h"
-#define STB_IMAGE_WRITE_IMPLEMENTATION
-#include "stb_image_write.h"
-
-#define MAX_MODULES 20
-#define MAX_PIPELINES 6
-#define PIPELINE_PARAMID_OFFSET 10
-#define MODULE_PARAMID_OFFSET 30
-#define DATA_PARAM_SIZE 188
-
-int initialize_parser(const char *filename, yaml_parser_t *parser, FILE *fh)
-{
-	fh = fopen(filename, "r");
-
-	/* Initialize parser */
-	if (!yaml_parser_initialize(parser))
-	{
-		fprintf(stderr, "Error: Failed to initialize parser!\n");
-		return -1;
-	}
-	if (fh == NULL)
-	{
-		fprintf(stderr, "Error: Failed to open file!\n");
-		return -1;
-	}
 
-	/* Set input file */
-	yaml_parser_set_input_file(parser, fh);
+#include "ippc.h"
+#include "module_schema.h"
+#include "config_cache.h"
+#include "fleet.h"
+#include "profile.h"
 
-	return 0;
+/* Run a command with fresh phase timings, printed afterwards if profiling was enabled */
+static int run_profiled(int (*command)(struct slash *slash), struct slash *slash)
+{
+	ippc_begin();
+	int ret = command(slash);
+	ippc_end();
+	return ret;
 }
 
-void cleanup_resources(yaml_parser_t *parser, yaml_event_t *event, FILE *fh)
+#define PROFILED(command) \
+	static int command##_profiled(struct slash *slash) { return run_profiled(command, slash); }
+
+/* Command line of a command, shortened to fit buf */
+static void command_line(struct slash *slash, char *buf, size_t size)
 {
-	if (event != NULL)
-	{
-		yaml_event_delete(event);
-	}
-	yaml_parser_delete(parser);
+	size_t used = 0;
+	buf[0] = '\0';
+	for (int i = 0; i < slash->argc && used < size; i++)
+		used += snprintf(buf + used, size - used, "%s%s", i > 0 ? " " : "", slash->argv[i]);
+}
 
-	if (fh != NULL)
-	{
-		fclose(fh);
-	}
+/* -n starts out unset in commands that also take -N, so both cannot be given */
+#define NODE_UNSET UINT_MAX
+
+static int resolve_nodes(const char *node_list, unsigned int node, unsigned int nodes[FLEET_MAX_NODES])
+{
+	int given = node != NODE_UNSET;
+	return ippc_resolve_nodes(node_list, given ? node : slash_dfl_node, given, nodes);
 }
 
-int safe_atof(const char *in, float *out)
+/* Core context of the shell, kept for as long as it runs */
+static ippc_t *shell_context(void)
 {
-	errno = 0; // To detect overflow or underflow
-	char *endptr;
-	float val = strtof(in, &endptr);
+	static ippc_t *ippc = NULL;
+	if (ippc == NULL)
+		ippc = ippc_init();
+	return ippc;
+}
 
-	if (endptr == in)
-	{
-		fprintf(stderr, "Error: Value \"%s\" could not be parsed to a floating-point number.\n", in);
-		return -1;
-	}
-	else if (*endptr != '\0')
-	{
-		fprintf(stderr, "Error: Extra characters after number: \"%s\"\n", endptr);
-		return -1;
-	}
-	else if ((val == HUGE_VALF || val == -HUGE_VALF) && errno == ERANGE)
-	{
-		// Note: Checking against HUGE_VALF for float-specific overflow/underflow
-		fprintf(stderr, "Error: Value \"%s\" is out of range.\n", in);
-		return -1;
+/* Slash return code of a core library result */
+static int slash_status(int ret)
+{
+	switch (ret)
+	{
+		case IPPC_OK:
+			return SLASH_SUCCESS;
+		case IPPC_EIO:
+			return SLASH_EIO;
+		case IPPC_ENOMEM:
+			return SLASH_ENOMEM;
+		default:
+			return SLASH_EINVAL;
 	}
-
-	*out = val;
-	return 0;
 }
 
-int safe_atoi(const char *in, int *out)
+static int slash_csp_configure_pipeline(struct slash *slash)
 {
-	errno = 0; // To detect overflow
-	char *endptr;
-	long val = strtol(in, &endptr, 10); // Base 10 for decimal conversion
+	unsigned int node = NODE_UNSET; // current node unless given
+    unsigned int timeout = slash_dfl_timeout;
+	unsigned int paramver = 2;
+	int ack_with_pull = true;
+	int tagged = false;
+	char *upload = NULL;
+	int diff = false;
+	char *node_list = NULL;
+	unsigned int retries = 0;
+	int profile = false;
+	char *trace = NULL;
+	optparse_t *parser = optparse_new("pipeline", "<pipeline-idx> <config-file>");
+	optparse_add_help(parser);
+	optparse_add_set(parser, 'P', "profile", 1, &profile, "Print time and throughput of every phase");
+	optparse_add_string(parser, 'T', "trace", "FILE", &trace, "Write every phase to FILE as a Chrome trace");
+	optparse_add_unsigned(parser, 'n', "node", "NUM", 0, &node, "node (default = <env>)");
+    optparse_add_unsigned(parser, 't', "timeout", "NUM", 0, &timeout, "timeout (default = <env>)");
+    optparse_add_unsigned(parser, 'v', "paramver", "NUM", 0, &paramver, "parameter system version (default = 2)");
+	optparse_add_set(parser, 'a', "no_ack_push", 0, &ack_with_pull, "Disable ack with param push queue");
+	optparse_add_set(parser, 'b', "best", 1, &tagged, "Send the smallest of all encodings, tagged (requires pipeline support)");
+	optparse_add_string(parser, 'u', "upload", "ADDR", &upload, "Upload configurations too large for a parameter to this vmem address");
+	optparse_add_set(parser, 'd', "diff", 1, &diff, "Pull the current configuration and only push if it differs");
+	optparse_add_string(parser, 'N', "nodes", "LIST", &node_list, "comma separated nodes to configure concurrently");
+	optparse_add_unsigned(parser, 'r', "retries", "NUM", 0, &retries, "retries per node (default = 0)");
 
-	if (endptr == in)
-	{
-		fprintf(stderr, "Error: No digits were found in token %s\n", in);
-		return -1;
-	}
-	if (*endptr != '\0')
-	{
-		fprintf(stderr, "Error: Extra characters after number: %s in token %s\n", endptr, in);
-		return -1;
-	}
-	if ((val == LONG_MIN || val == LONG_MAX) && errno == ERANGE)
-	{
-		fprintf(stderr, "Error: Value out of long int range for token %s\n", in);
-		return -1;
-	}
-	if (val < INT_MIN || val > INT_MAX)
+	int argi = optparse_parse(parser, slash->argc - 1, (const char **)slash->argv + 1);
+	if (argi < 0)
 	{
-		fprintf(stderr, "Error: Value out of int range for token %s\n", in);
-		return -1;
+		optparse_del(parser);
+		return SLASH_EINVAL;
 	}
+	if (profile)
+		profile_enable();
+	if (trace)
+		profile_trace(trace);
 
-	*out = (int)val;
-	return 0;
-}
+	unsigned int nodes[FLEET_MAX_NODES];
+	int node_count = resolve_nodes(node_list, node, nodes);
+	if (node_count < 0)
+		return SLASH_EINVAL;
 
-int parse_pipeline_yaml_file(const char *filename, PipelineDefinition *pipeline)
-{
-	yaml_parser_t parser;
-	FILE *fh = NULL;
-	if (initialize_parser(filename, &parser, fh) < 0)
-		return -1;
-
-	/* Module definitions */
-	ModuleDefinition *modules = NULL;
-	int module_idx = -1;  // current module index
-	int module_count = 0; // find total amount of modules
-
-	/* START parsing */
-	yaml_event_t event;
-	while (1)
+	/* Check if pipeline id and config file are present */
+	if (++argi >= slash->argc)
 	{
-		if (!yaml_parser_parse(&parser, &event))
-		{
-			printf("Error: Parser error %d\n", parser.error);
-			return -1;
-		}
-		switch (event.type)
-		{
-			case YAML_MAPPING_START_EVENT:
-				// New Dash
-				module_idx++;
-				ModuleDefinition *temp = realloc(modules, (module_count + 1) * sizeof(ModuleDefinition));
-				if (!temp)
-				{
-					fprintf(stderr, "Error: Failed to allocate memory for ModuleDefinition during parsing\n");
-					return -1;
-				}
-
-				modules = temp;
-
-				// Fill in the new struct
-				ModuleDefinition module = MODULE_DEFINITION__INIT;
-				modules[module_idx] = module;
-
-				module_count++;
-				break;
-			case YAML_SCALAR_EVENT:
-				// New set of ModuleDefinition encountered
-				if (strcmp((char *)event.data.scalar.value, "order") == 0)
-				{
-					// Expect the next event to be the value of order
-					if (!yaml_parser_parse(&parser, &event))
-						break;
-					if (safe_atoi((char *)event.data.scalar.value, &modules[module_idx].order) < 0)
-					{
-						return -1;
-					}
-				}
-				else if (strcmp((char *)event.data.scalar.value, "name") == 0)
-				{
-					// Expect the next event to be the value of name
-					if (!yaml_parser_parse(&parser, &event))
-						break;
-					modules[module_idx].name = strdup((char *)event.data.scalar.value);
-				}
-				else if (strcmp((char *)event.data.scalar.value, "param_id") == 0)
-				{
-					// Expect the next event to be the value of param_id
-					if (!yaml_parser_parse(&parser, &event))
-						break;
-					if (safe_atoi((char *)event.data.scalar.value, &modules[module_idx].param_id) < 0)
-					{
-						return -1;
-					}
-					if (modules[module_idx].param_id < 1 || modules[module_idx].param_id > MAX_MODULES) {
-						fprintf(stderr, "Error: Param_id is invalid. Range is 1-%d\n", MAX_MODULES);
-						return -1;
-					}
-				}
-				else
-				{
-					// Unexpected event type
-					fprintf(stderr, "Error: Unexpected YAML scalar value format: %s\nAllowed values are: order, name, param_id\n", (char *)event.data.scalar.value);
-					return -1;
-				}
-			default:
-				break;
-		}
-		if (event.type == YAML_SEQUENCE_END_EVENT || event.type == YAML_DOCUMENT_END_EVENT)
-			break;
-
-		yaml_event_delete(&event);
+		printf("Missing pipeline id\n");
+		return SLASH_EINVAL;
 	}
-
-	// Insert ModuleDefinitions into PipelineDefinition
-	pipeline->n_modules = module_count;
-	pipeline->modules = malloc(sizeof(ModuleDefinition *) * module_count);
-	int orders[module_count];
-	for (size_t i = 0; i < module_count; i++)
+	if (argi + 1 >= slash->argc)
 	{
-		pipeline->modules[i] = &modules[i];
-
-		// Ensure module orders are unique
-		if (modules[i].order > module_count || modules[i].order < 1 || orders[modules[i].order - 1] == 1) {
-			fprintf(stderr, "Error: Order values are out of bounds or not sequential, bad value: %d\n", modules[i].order);
-			return -1;
-		}
-		orders[modules[i].order - 1] = 1;
+		printf("Missing config-file path\n");
+		return SLASH_EINVAL;
 	}
 
-	cleanup_resources(&parser, &event, fh);
-
-	return 0;
+	ippc_compile_opts_t compile = {.tagged = tagged, .upload = upload};
+	ippc_push_opts_t push = {.timeout = timeout, .paramver = paramver, .ack_with_pull = ack_with_pull, .diff = diff, .retries = retries};
+	return slash_status(ippc_configure_pipeline(atoi(slash->argv[argi]), slash->argv[argi + 1], &compile, &push, nodes, node_count));
 }
 
-static int slash_csp_configure_pipeline(struct slash *slash)
+PROFILED(slash_csp_configure_pipeline)
+slash_command_sub(ippc, pipeline, slash_csp_configure_pipeline_profiled, "[OPTIONS...] <pipeline-idx> <config-file>", "Configure a specific pipeline");
+
+static int slash_csp_configure_module(struct slash *slash)
 {
-	unsigned int node = slash_dfl_node; // fetch current node id
+	unsigned int node = NODE_UNSET; // current node unless given
     unsigned int timeout = slash_dfl_timeout;
 	unsigned int paramver = 2;
 	int ack_with_pull = true;
-	optparse_t *parser = optparse_new("pipeline", "<pipeline-idx> <config-file>");
+	char *schema = NULL;
+	int compact = false;
+	int tagged = false;
+	char *upload = NULL;
+	int diff = false;
+	char *node_list = NULL;
+	unsigned int retries = 0;
+	int profile = false;
+	char *trace = NULL;
+	optparse_t *parser = optparse_new("module", "<module-idx> <config-file>");
 	optparse_add_help(parser);
+	optparse_add_set(parser, 'P', "profile", 1, &profile, "Print time and throughput of every phase");
+	optparse_add_string(parser, 'T', "trace", "FILE", &trace, "Write every phase to FILE as a Chrome trace");
 	optparse_add_unsigned(parser, 'n', "node", "NUM", 0, &node, "node (default = <env>)");
     optparse_add_unsigned(parser, 't', "timeout", "NUM", 0, &timeout, "timeout (default = <env>)");
     optparse_add_unsigned(parser, 'v', "paramver", "NUM", 0, &paramver, "parameter system version (default = 2)");
 	optparse_add_set(parser, 'a', "no_ack_push", 0, &ack_with_pull, "Disable ack with param push queue");
+	optparse_add_string(parser, 's', "schema", "NAME", &schema, "module schema used to infer types and compact keys");
+	optparse_add_set(parser, 'k', "compact", 1, &compact, "Replace keys known by the schema with their id (requires --schema)");
+	optparse_add_set(parser, 'b', "best", 1, &tagged, "Send the smallest of all encodings, tagged (requires pipeline support)");
+	optparse_add_string(parser, 'u', "upload", "ADDR", &upload, "Upload configurations too large for a parameter to this vmem address");
+	optparse_add_set(parser, 'd', "diff", 1, &diff, "Pull the current configuration and only push if it differs");
+	optparse_add_string(parser, 'N', "nodes", "LIST", &node_list, "comma separated nodes to configure concurrently");
+	optparse_add_unsigned(parser, 'r', "retries", "NUM", 0, &retries, "retries per node (default = 0)");
 
 	int argi = optparse_parse(parser, slash->argc - 1, (const char **)slash->argv + 1);
 	if (argi < 0)
@@ -249,227 +168,188 @@ static int slash_csp_configure_pipeline(struct slash *slash)
 		optparse_del(parser);
 		return SLASH_EINVAL;
 	}
+	if (profile)
+		profile_enable();
+	if (trace)
+		profile_trace(trace);
 
-	/* Check if pipeline id is present */
-	if (++argi >= slash->argc)
-	{
-		printf("Missing pipeline id\n");
+	unsigned int nodes[FLEET_MAX_NODES];
+	int node_count = resolve_nodes(node_list, node, nodes);
+	if (node_count < 0)
 		return SLASH_EINVAL;
-	}
 
-	/* Parse pipeline id */
-	int pipeline_id = atoi(slash->argv[argi]);
-	if (pipeline_id < 1 || pipeline_id > MAX_PIPELINES)
+	/* Check if module id and config file are present */
+	if (++argi >= slash->argc)
 	{
-		printf("Pipeline index is invalid. Range is 1-%d\n", MAX_PIPELINES);
+		printf("Missing module id\n");
 		return SLASH_EINVAL;
 	}
-
-	/* Check if config file is present */
-	if (++argi >= slash->argc)
+	if (argi + 1 >= slash->argc)
 	{
 		printf("Missing config-file path\n");
 		return SLASH_EINVAL;
 	}
 
-	/* Parse config file */
-	char *config_filename = strdup(slash->argv[argi]);
+	ippc_compile_opts_t compile = {.schema = schema, .compact = compact, .tagged = tagged, .upload = upload};
+	ippc_push_opts_t push = {.timeout = timeout, .paramver = paramver, .ack_with_pull = ack_with_pull, .diff = diff, .retries = retries};
+	return slash_status(ippc_configure_module(atoi(slash->argv[argi]), slash->argv[argi + 1], &compile, &push, nodes, node_count));
+}
 
-	printf("Client: Configuring pipeline %d, using %s\n", pipeline_id, config_filename);
+PROFILED(slash_csp_configure_module)
+slash_command_sub(ippc, module, slash_csp_configure_module_profiled, "[OPTIONS...] <module-idx> <config-file>", "Configure a specific module");
 
-	// Define PipelineDefinition and parse yaml file
-	PipelineDefinition pipeline = PIPELINE_DEFINITION__INIT;
-	if (parse_pipeline_yaml_file(config_filename, &pipeline) < 0)
+static int slash_csp_list_schemas(struct slash *slash)
+{
+	module_schema_print();
+	return SLASH_SUCCESS;
+}
+
+slash_command_sub(ippc, schema, slash_csp_list_schemas, "", "List module key schemas");
+
+static int slash_csp_configure_apply(struct slash *slash)
+{
+	unsigned int node = NODE_UNSET; // current node unless given
+	unsigned int timeout = slash_dfl_timeout;
+	unsigned int paramver = 2;
+	int ack_with_pull = true;
+	int compact = false;
+	int tagged = false;
+	int diff = false;
+	char *node_list = NULL;
+	unsigned int retries = 0;
+	int profile = false;
+	char *trace = NULL;
+	optparse_t *parser = optparse_new("apply", "<manifest-file>");
+	optparse_add_help(parser);
+	optparse_add_set(parser, 'P', "profile", 1, &profile, "Print time and throughput of every phase");
+	optparse_add_string(parser, 'T', "trace", "FILE", &trace, "Write every phase to FILE as a Chrome trace");
+	optparse_add_unsigned(parser, 'n', "node", "NUM", 0, &node, "node (default = <env>)");
+	optparse_add_unsigned(parser, 't', "timeout", "NUM", 0, &timeout, "timeout (default = <env>)");
+	optparse_add_unsigned(parser, 'v', "paramver", "NUM", 0, &paramver, "parameter system version (default = 2)");
+	optparse_add_set(parser, 'a', "no_ack_push", 0, &ack_with_pull, "Disable ack with param push queue");
+	optparse_add_set(parser, 'k', "compact", 1, &compact, "Replace keys known by the module schemas with their id");
+	optparse_add_set(parser, 'b', "best", 1, &tagged, "Send the smallest of all encodings, tagged (requires pipeline support)");
+	optparse_add_set(parser, 'd', "diff", 1, &diff, "Pull the current configurations and only push those that differ");
+	optparse_add_string(parser, 'N', "nodes", "LIST", &node_list, "comma separated nodes to configure concurrently");
+	optparse_add_unsigned(parser, 'r', "retries", "NUM", 0, &retries, "retries per node (default = 0)");
+
+	int argi = optparse_parse(parser, slash->argc - 1, (const char **)slash->argv + 1);
+	if (argi < 0)
 	{
+		optparse_del(parser);
 		return SLASH_EINVAL;
 	}
+	if (profile)
+		profile_enable();
+	if (trace)
+		profile_trace(trace);
 
-	// Pack PipelineDefinition
-	size_t packed_size = pipeline_definition__get_packed_size(&pipeline);
-	if (packed_size + 1 >= DATA_PARAM_SIZE) {
-		printf("Packed configuration too large");
-		return SLASH_EINVAL;
-	}
-	uint8_t packed_buf[packed_size];
-	pipeline_definition__pack(&pipeline, packed_buf);
-
-	size_t encoded_buffer_size = 1000;
-    uint8_t encoded_buffer[encoded_buffer_size];
-	if (BrotliEncoderCompress(BROTLI_DEFAULT_QUALITY, BROTLI_DEFAULT_WINDOW, BROTLI_DEFAULT_MODE, packed_size, packed_buf, &encoded_buffer_size, encoded_buffer) == BROTLI_FALSE)
-    {
-        fprintf(stderr, "Brotli compression failed\n");
+	unsigned int nodes[FLEET_MAX_NODES];
+	int node_count = resolve_nodes(node_list, node, nodes);
+	if (node_count < 0)
 		return SLASH_EINVAL;
-    }
-	if (encoded_buffer_size + 1 > DATA_PARAM_SIZE)
+
+	/* Check if manifest is present */
+	if (++argi >= slash->argc)
 	{
-		printf("Packed and encoded configuration is size %ld bytes which exceeds max size of %d\n", encoded_buffer_size + 1, DATA_PARAM_SIZE);
+		printf("Missing manifest-file path\n");
 		return SLASH_EINVAL;
 	}
-	uint8_t buffer[encoded_buffer_size + 1];
-	memcpy(buffer + 1, encoded_buffer, encoded_buffer_size);
-	buffer[0] = encoded_buffer_size;
 
-	// Mirror pipeline_config parameter
-	int param_id = pipeline_id + PIPELINE_PARAMID_OFFSET - 1; // find correct pipeline id (Offset by +10 on pipeline server)
-	PARAM_DEFINE_REMOTE_DYNAMIC(param_id, pipeline_config, node, PARAM_TYPE_DATA, DATA_PARAM_SIZE, 1, PM_CONF, &buffer, NULL);
+	ippc_compile_opts_t compile = {.compact = compact, .tagged = tagged};
+	ippc_push_opts_t push = {.timeout = timeout, .paramver = paramver, .ack_with_pull = ack_with_pull, .diff = diff, .retries = retries};
+	return slash_status(ippc_apply(slash->argv[argi], &compile, &push, nodes, node_count));
+}
 
-	// The parameter name must have the id
-	char name[20];
-	sprintf(name, "pipeline_config_%d", pipeline_id);
-	pipeline_config.name = name;
+PROFILED(slash_csp_configure_apply)
+slash_command_sub(ippc, apply, slash_csp_configure_apply_profiled, "[OPTIONS...] <manifest-file>", "Configure pipelines and modules listed in a manifest");
 
-	// Insert packed pipeline definition into parameter
-	if (param_push_single(&pipeline_config, -1, buffer, 0, node, timeout, paramver, ack_with_pull) < 0)
+static int slash_csp_configure_status(struct slash *slash)
+{
+	unsigned int node = slash_dfl_node; // fetch current node id
+	unsigned int timeout = slash_dfl_timeout;
+	unsigned int paramver = 2;
+	int profile = false;
+	char *trace = NULL;
+	optparse_t *parser = optparse_new("status", "");
+	optparse_add_help(parser);
+	optparse_add_set(parser, 'P', "profile", 1, &profile, "Print time and throughput of every phase");
+	optparse_add_string(parser, 'T', "trace", "FILE", &trace, "Write every phase to FILE as a Chrome trace");
+	optparse_add_unsigned(parser, 'n', "node", "NUM", 0, &node, "node (default = <env>)");
+	optparse_add_unsigned(parser, 't', "timeout", "NUM", 0, &timeout, "timeout (default = <env>)");
+	optparse_add_unsigned(parser, 'v', "paramver", "NUM", 0, &paramver, "parameter system version (default = 2)");
+
+	int argi = optparse_parse(parser, slash->argc - 1, (const char **)slash->argv + 1);
+	if (argi < 0)
 	{
-		printf("No response\n");
-		return SLASH_EIO;
+		optparse_del(parser);
+		return SLASH_EINVAL;
 	}
+	if (profile)
+		profile_enable();
+	if (trace)
+		profile_trace(trace);
 
-	return SLASH_SUCCESS;
+	return slash_status(ippc_status(node, timeout, paramver));
 }
 
-slash_command_sub(ippc, pipeline, slash_csp_configure_pipeline, "[OPTIONS...] <pipeline-idx> <config-file>", "Configure a specific pipeline");
+PROFILED(slash_csp_configure_status)
+slash_command_sub(ippc, status, slash_csp_configure_status_profiled, "[OPTIONS...]", "Show pipeline and module configurations on a node");
 
-int parse_module_yaml_file(const char *filename, ModuleConfig *module_config)
+static int slash_csp_configure_save(struct slash *slash)
 {
-	yaml_parser_t parser;
-	FILE *fh = NULL;
-	if (initialize_parser(filename, &parser, fh) < 0)
-		return -1;
-
-	/* Module definitions */
-	ConfigParameter *params = NULL;
-	int param_idx = -1;	 // current module index
-	int param_count = 0; // find total amount of modules
-
-	/* START parsing */
-	yaml_event_t event;
-	while (1)
-	{
-		if (!yaml_parser_parse(&parser, &event))
-		{
-			printf("Error: Parser error %d\n", parser.error);
-			return -1;
-		}
-		switch (event.type)
-		{
-			case YAML_MAPPING_START_EVENT:
-				// New Dash
-				param_idx++;
-				ConfigParameter *temp = realloc(params, (param_count + 1) * sizeof(ConfigParameter));
-				if (!temp)
-				{
-					fprintf(stderr, "Error: Failed to allocate memory for ConfigParameter during parsing\n");
-					return -1;
-				}
-				params = temp;
-
-				// Fill in the new struct
-				ConfigParameter param = CONFIG_PARAMETER__INIT;
-				params[param_idx] = param;
-
-				param_count++;
-				break;
-			case YAML_SCALAR_EVENT:
-				// New set of ModuleDefinition encountered
-				if (strcmp((char *)event.data.scalar.value, "key") == 0)
-				{
-					// Expect the next event to be the value of order
-					if (!yaml_parser_parse(&parser, &event))
-						break;
-					params[param_idx].key = strdup((char *)event.data.scalar.value);
-				}
-				else if (strcmp((char *)event.data.scalar.value, "type") == 0)
-				{
-					// Expect the next event to be the value of name
-					if (!yaml_parser_parse(&parser, &event))
-						break;
-					if (safe_atoi((char *)event.data.scalar.value, (int *)&params[param_idx].value_case) < 0)
-					{
-						return -1;
-					}
-				}
-				else if (strcmp((char *)event.data.scalar.value, "value") == 0)
-				{
-					// Expect the next event to be the value of param_id
-					if (!yaml_parser_parse(&parser, &event))
-						break;
-					switch (params[param_idx].value_case)
-					{
-						case CONFIG_PARAMETER__VALUE_BOOL_VALUE:
-							if (strcmp((char *)event.data.scalar.value, "true") == 0)
-							{
-								params[param_idx].bool_value = 1;
-							}
-							else if (strcmp((char *)event.data.scalar.value, "false") == 0)
-							{
-								params[param_idx].bool_value = 0;
-							}
-							else
-							{
-								fprintf(stderr, "Error: Could not parse %s to boolean value\nAllowed values are: true, false\n", (char *)event.data.scalar.value);
-								return -1;
-							}
-							break;
-						case CONFIG_PARAMETER__VALUE_INT_VALUE:
-							if (safe_atoi((char *)event.data.scalar.value, &params[param_idx].int_value) < 0)
-							{
-								return -1;
-							}
-							break;
-						case CONFIG_PARAMETER__VALUE_FLOAT_VALUE:
-							if (safe_atof((char *)event.data.scalar.value, &params[param_idx].float_value) < 0)
-							{
-								return -1;
-							}
-							break;
-						case CONFIG_PARAMETER__VALUE_STRING_VALUE:
-							params[param_idx].string_value = strdup((char *)event.data.scalar.value);
-							break;
-						default:
-							fprintf(stderr, "Error: Value case %d unknown.\n", params[param_idx].value_case);
-							return -1;
-					}
-				}
-				else
-				{
-					// Unexpected event type
-					printf("Error: Unexpected YAML scalar value format: %s\nAllowed values are: key, type, value\n", (char *)event.data.scalar.value);
-					return -1;
-				}
-			default:
-				break;
-		}
-		if (event.type == YAML_SEQUENCE_END_EVENT || event.type == YAML_DOCUMENT_END_EVENT)
-			break;
+	unsigned int node = slash_dfl_node; // fetch current node id
+	unsigned int timeout = slash_dfl_timeout;
+	unsigned int paramver = 2;
+	int profile = false;
+	char *trace = NULL;
+	optparse_t *parser = optparse_new("save", "<bundle-file>");
+	optparse_add_help(parser);
+	optparse_add_set(parser, 'P', "profile", 1, &profile, "Print time and throughput of every phase");
+	optparse_add_string(parser, 'T', "trace", "FILE", &trace, "Write every phase to FILE as a Chrome trace");
+	optparse_add_unsigned(parser, 'n', "node", "NUM", 0, &node, "node (default = <env>)");
+	optparse_add_unsigned(parser, 't', "timeout", "NUM", 0, &timeout, "timeout (default = <env>)");
+	optparse_add_unsigned(parser, 'v', "paramver", "NUM", 0, &paramver, "parameter system version (default = 2)");
 
-		yaml_event_delete(&event);
+	int argi = optparse_parse(parser, slash->argc - 1, (const char **)slash->argv + 1);
+	if (argi < 0)
+	{
+		optparse_del(parser);
+		return SLASH_EINVAL;
 	}
+	if (profile)
+		profile_enable();
+	if (trace)
+		profile_trace(trace);
 
-	// Insert ConfigParameter into ModuleConfig
-	module_config->n_parameters = param_count;
-	module_config->parameters = malloc(sizeof(ConfigParameter *) * param_count);
-	for (size_t i = 0; i < param_count; i++)
+	/* Check if bundle file is present */
+	if (++argi >= slash->argc)
 	{
-		module_config->parameters[i] = &params[i];
+		printf("Missing bundle-file path\n");
+		return SLASH_EINVAL;
 	}
 
-	cleanup_resources(&parser, &event, fh);
-
-	return 0;
+	return slash_status(ippc_save(slash->argv[argi], node, timeout, paramver));
 }
 
-static int slash_csp_configure_module(struct slash *slash)
+PROFILED(slash_csp_configure_save)
+slash_command_sub(ippc, save, slash_csp_configure_save_profiled, "[OPTIONS...] <bundle-file>", "Save pipeline and module configurations of a node to a bundle");
+
+static int push_bundle_command(struct slash *slash, const char *command, int (*push_bundle)(const char *, unsigned int, const ippc_push_opts_t *))
 {
 	unsigned int node = slash_dfl_node; // fetch current node id
-    unsigned int timeout = slash_dfl_timeout;
+	unsigned int timeout = slash_dfl_timeout;
 	unsigned int paramver = 2;
 	int ack_with_pull = true;
-	optparse_t *parser = optparse_new("module", "<module-idx> <config-file>");
+	int profile = false;
+	char *trace = NULL;
+	optparse_t *parser = optparse_new(command, "<bundle-file>");
 	optparse_add_help(parser);
+	optparse_add_set(parser, 'P', "profile", 1, &profile, "Print time and throughput of every phase");
+	optparse_add_string(parser, 'T', "trace", "FILE", &trace, "Write every phase to FILE as a Chrome trace");
 	optparse_add_unsigned(parser, 'n', "node", "NUM", 0, &node, "node (default = <env>)");
-    optparse_add_unsigned(parser, 't', "timeout", "NUM", 0, &timeout, "timeout (default = <env>)");
-    optparse_add_unsigned(parser, 'v', "paramver", "NUM", 0, &paramver, "parameter system version (default = 2)");
+	optparse_add_unsigned(parser, 't', "timeout", "NUM", 0, &timeout, "timeout (default = <env>)");
+	optparse_add_unsigned(parser, 'v', "paramver", "NUM", 0, &paramver, "parameter system version (default = 2)");
 	optparse_add_set(parser, 'a', "no_ack_push", 0, &ack_with_pull, "Disable ack with param push queue");
 
 	int argi = optparse_parse(parser, slash->argc - 1, (const char **)slash->argv + 1);
@@ -478,126 +358,148 @@ static int slash_csp_configure_module(struct slash *slash)
 		optparse_del(parser);
 		return SLASH_EINVAL;
 	}
+	if (profile)
+		profile_enable();
+	if (trace)
+		profile_trace(trace);
 
-	/* Check if module id is present */
+	/* Check if bundle file is present */
 	if (++argi >= slash->argc)
 	{
-		printf("Missing module id\n");
+		printf("Missing bundle-file path\n");
 		return SLASH_EINVAL;
 	}
 
-	/* Parse module id */
-	int module_id = atoi(slash->argv[argi]);
-	if (module_id < 1 || module_id > MAX_MODULES)
+	ippc_push_opts_t push = {.timeout = timeout, .paramver = paramver, .ack_with_pull = ack_with_pull};
+	return slash_status(push_bundle(slash->argv[argi], node, &push));
+}
+
+static int slash_csp_configure_restore(struct slash *slash)
+{
+	return push_bundle_command(slash, "restore", ippc_restore);
+}
+
+PROFILED(slash_csp_configure_restore)
+slash_command_sub(ippc, restore, slash_csp_configure_restore_profiled, "[OPTIONS...] <bundle-file>", "Push the configurations of a bundle to a node, clearing those it does not hold");
+
+static int slash_csp_configure_compile(struct slash *slash)
+{
+	unsigned int pipeline_id = 0;
+	unsigned int module_id = 0;
+	char *schema = NULL;
+	int compact = false;
+	int tagged = false;
+	int profile = false;
+	char *trace = NULL;
+	optparse_t *parser = optparse_new("compile", "<config-file> <artifact-file>");
+	optparse_add_help(parser);
+	optparse_add_set(parser, 'P', "profile", 1, &profile, "Print time and throughput of every phase");
+	optparse_add_string(parser, 'T', "trace", "FILE", &trace, "Write every phase to FILE as a Chrome trace");
+	optparse_add_unsigned(parser, 'p', "pipeline", "NUM", 0, &pipeline_id, "compile a pipeline configuration for this pipeline index");
+	optparse_add_unsigned(parser, 'm', "module", "NUM", 0, &module_id, "compile a module configuration for this module index");
+	optparse_add_string(parser, 's', "schema", "NAME", &schema, "module schema used to infer types and compact keys");
+	optparse_add_set(parser, 'k', "compact", 1, &compact, "Replace keys known by the module schemas with their id");
+	optparse_add_set(parser, 'b', "best", 1, &tagged, "Use the smallest of all encodings, tagged (requires pipeline support)");
+
+	int argi = optparse_parse(parser, slash->argc - 1, (const char **)slash->argv + 1);
+	if (argi < 0)
 	{
-		printf("Module index is invalid. Range is 1-%d\n", MAX_MODULES);
+		optparse_del(parser);
 		return SLASH_EINVAL;
 	}
+	if (profile)
+		profile_enable();
+	if (trace)
+		profile_trace(trace);
 
-	/* Check if config file is present */
-	if (++argi >= slash->argc)
+	/* Check if config and artifact files are present */
+	if (argi + 2 >= slash->argc)
 	{
-		printf("Missing config-file path\n");
+		printf("Missing config-file or artifact-file path\n");
 		return SLASH_EINVAL;
 	}
 
-	/* Parse config file */
-	char *config_filename = strdup(slash->argv[argi]);
+	ippc_compile_opts_t compile = {.schema = schema, .compact = compact, .tagged = tagged};
+	return slash_status(ippc_compile(slash->argv[argi + 1], slash->argv[argi + 2], pipeline_id, module_id, &compile));
+}
 
-	printf("Client: Configuring module %d, using %s\n", module_id, config_filename);
+PROFILED(slash_csp_configure_compile)
+slash_command_sub(ippc, compile, slash_csp_configure_compile_profiled, "[OPTIONS...] <config-file> <artifact-file>", "Compile configurations into a binary artifact without contacting a node");
 
-	// Define PipelineDefinition and parse yaml file
-	ModuleConfig module_config = MODULE_CONFIG__INIT;
-	if (parse_module_yaml_file(config_filename, &module_config) < 0)
-		return SLASH_EINVAL;
+static int slash_csp_configure_push_bin(struct slash *slash)
+{
+	return push_bundle_command(slash, "push_bin", ippc_push_bin);
+}
 
-	// Pack PipelineDefinition
-	size_t packed_size = module_config__get_packed_size(&module_config);
-	if (packed_size + 1 >= DATA_PARAM_SIZE) {
-		printf("Packed configuration too large");
-		return SLASH_EINVAL;
-	}
-	uint8_t packed_buf[packed_size];
-	module_config__pack(&module_config, packed_buf); // Insert after first index
-	
-	size_t encoded_buffer_size = 1000;
-    uint8_t encoded_buffer[encoded_buffer_size];
-	if (BrotliEncoderCompress(BROTLI_DEFAULT_QUALITY, BROTLI_DEFAULT_WINDOW, BROTLI_DEFAULT_MODE, packed_size, packed_buf, &encoded_buffer_size, encoded_buffer) == BROTLI_FALSE)
-    {
-        fprintf(stderr, "Brotli compression failed\n");
-		return SLASH_EINVAL;
-    }
-	if (encoded_buffer_size + 1 > DATA_PARAM_SIZE)
+PROFILED(slash_csp_configure_push_bin)
+slash_command_sub(ippc, push_bin, slash_csp_configure_push_bin_profiled, "[OPTIONS...] <artifact-file>", "Push a compiled configuration artifact to a node");
+
+static int slash_csp_configure_cache(struct slash *slash)
+{
+	int clear = false;
+	optparse_t *parser = optparse_new("cache", "");
+	optparse_add_help(parser);
+	optparse_add_set(parser, 'c', "clear", 1, &clear, "Remove all cached compilations");
+
+	int argi = optparse_parse(parser, slash->argc - 1, (const char **)slash->argv + 1);
+	if (argi < 0)
 	{
-		printf("Packed and encoded configuration is size %ld bytes which exceeds max size of %d\n", encoded_buffer_size + 1, DATA_PARAM_SIZE);
+		optparse_del(parser);
 		return SLASH_EINVAL;
 	}
-	uint8_t buffer[encoded_buffer_size + 1];
-	memcpy(buffer + 1, encoded_buffer, encoded_buffer_size);
-	buffer[0] = encoded_buffer_size;
-
-	// Mirror module_param parameter
-	int param_id = module_id + MODULE_PARAMID_OFFSET - 1; // find correct parameter id (Offset by +30 on pipeline server)
-	PARAM_DEFINE_REMOTE_DYNAMIC(param_id, module_param, node, PARAM_TYPE_DATA, DATA_PARAM_SIZE, 1, PM_CONF, &buffer, NULL);
 
-	// The parameter name must have the id
-	char name[20];
-	sprintf(name, "module_param_%d", module_id);
-	module_param.name = name;
-
-	// Insert packed pipeline definition into parameter
-	if (param_push_single(&module_param, -1, buffer, 0, node, timeout, paramver, ack_with_pull) < 0)
+	if (clear)
 	{
-		printf("No response\n");
-		return SLASH_EIO;
+		int removed = config_cache_clear();
+		if (removed < 0)
+		{
+			printf("Could not clear cache\n");
+			return SLASH_EIO;
+		}
+		printf("Removed %d cached compilations\n", removed);
+		return SLASH_SUCCESS;
 	}
 
+	config_cache_list();
 	return SLASH_SUCCESS;
 }
 
-slash_command_sub(ippc, module, slash_csp_configure_module, "[OPTIONS...] <module-idx> <config-file>", "Configure a specific module");
-
-static MetadataItem *get_item(Metadata *data, const char *key) {
-    MetadataItem *found_item = NULL;
-    for (size_t i = 0; i < data->n_items; i++)
-    {
-        if (strcmp(data->items[i]->key, key) == 0)
-        {
-            found_item = data->items[i];
-            break;
-        }
-    }
-    return found_item;
-}
-
-char *get_custom_metadata_string(Metadata *data, char *key)
-{
-    MetadataItem *found_item = get_item(data, key);
-
-    if (found_item == NULL)
-    {
-        return NULL;
-    }
-    
-    return found_item->string_value;
-}
+slash_command_sub(ippc, cache, slash_csp_configure_cache, "[OPTIONS...]", "List or clear cached configuration compilations");
 
 static int slash_csp_buffer_get(struct slash *slash)
 {
-	unsigned int node = slash_dfl_node; // fetch current node id
+	unsigned int node = NODE_UNSET; // current node unless given
     unsigned int timeout = slash_dfl_timeout;
 	unsigned int paramver = 2;
 	int ack_with_pull = true;
 	int save_png = false;
 	int front = false;
+	unsigned int count = 1;
+	char *where = NULL;
+	char *node_list = NULL;
+	char *ring_list = NULL;
+	unsigned int per_node = 1;
+	unsigned int per_link = 4;
+	int async = false;
+	int profile = false;
+	char *trace = NULL;
 	optparse_t *parser = optparse_new("get", "<offset>");
 	optparse_add_help(parser);
+	optparse_add_set(parser, 'P', "profile", 1, &profile, "Print time and throughput of every phase");
+	optparse_add_string(parser, 'T', "trace", "FILE", &trace, "Write every phase to FILE as a Chrome trace");
 	optparse_add_unsigned(parser, 'n', "node", "NUM", 0, &node, "node (default = <env>)");
     optparse_add_unsigned(parser, 't', "timeout", "NUM", 0, &timeout, "timeout (default = <env>)");
     optparse_add_unsigned(parser, 'v', "paramver", "NUM", 0, &paramver, "parameter system version (default = 2)");
 	optparse_add_set(parser, 'a', "no_ack_push", 0, &ack_with_pull, "Disable ack with param push queue");
 	optparse_add_set(parser, 's', "save_png", 1, &save_png, "Save downloaded data as png (default = false)");
 	optparse_add_set(parser, 'f', "front", 1, &front, "Index from front/newest image (default = false)");
+	optparse_add_unsigned(parser, 'c', "count", "NUM", 0, &count, "number of consecutive entries to fetch (default = 1)");
+	optparse_add_string(parser, 'w', "where", "EXPR", &where, "only decode and save entries whose metadata matches EXPR");
+	optparse_add_string(parser, 'N', "nodes", "LIST", &node_list, "comma separated nodes to download from");
+	optparse_add_string(parser, 'R', "rings", "LIST", &ring_list, "comma separated ring buffers to download from (default = images)");
+	optparse_add_unsigned(parser, 'p', "per_node", "NUM", 0, &per_node, "concurrent transfers per node (default = 1)");
+	optparse_add_unsigned(parser, 'l', "per_link", "NUM", 0, &per_link, "concurrent transfers in total (default = 4)");
+	optparse_add_set(parser, 'A', "async", 1, &async, "Download and save in the background, see ippb jobs");
 
 	int argi = optparse_parse(parser, slash->argc - 1, (const char **)slash->argv + 1);
 	if (argi < 0)
@@ -605,6 +507,12 @@ static int slash_csp_buffer_get(struct slash *slash)
 		optparse_del(parser);
 		return SLASH_EINVAL;
 	}
+	if (async && (profile || trace))
+	{
+		printf("Profiling is not supported with --async\n");
+		optparse_del(parser);
+		return SLASH_EINVAL;
+	}
 
 	/* Check if tail offset is present */
 	if (++argi >= slash->argc)
@@ -613,113 +521,173 @@ static int slash_csp_buffer_get(struct slash *slash)
 		return SLASH_EINVAL;
 	}
 
-	/* Fetch tail offset parameter */
-	int input_offset = atoi(slash->argv[argi]);
-	if (front) input_offset *= -1;
+	unsigned int nodes[FLEET_MAX_NODES];
+	int node_count = resolve_nodes(node_list, node, nodes);
+	if (node_count < 0)
+		return SLASH_EINVAL;
 
-	/* Download image file */
-	unsigned char *image_data = (unsigned char *)malloc(10000000); // image buffer
-	int size_down = vmem_ring_download(node, timeout, "images", input_offset, (char *)image_data, 2, 1);
-	if (size_down == -1) {
-		printf("Download failed\n");
+	ippc_download_opts_t opts = {
+		.timeout = timeout,
+		.rings = ring_list,
+		.where = where,
+		.save_png = save_png,
+		.per_node = per_node,
+		.per_link = per_link,
+	};
+	if (!async)
+	{
+		/* Only the foreground download is a command of its own, jobs outlive it */
+		ippc_begin();
+		if (profile)
+			profile_enable();
+		if (trace)
+			profile_trace(trace);
+		int ret = ippc_buffer_get(shell_context(), atoi(slash->argv[argi]), front, count, nodes, node_count, &opts);
+		ippc_end();
+		return slash_status(ret);
+	}
+
+	char description[64];
+	command_line(slash, description, sizeof(description));
+	int id = ippc_buffer_get_async(shell_context(), description, atoi(slash->argv[argi]), front, count, nodes, node_count, &opts);
+	if (id < 0)
 		return SLASH_EINVAL;
-	}
-	printf("Downloaded %d bytes from node %d in ring buffer '%s' at offset %d\n", size_down, node, "images", input_offset);
-	
-	/* Extract image metadata */
-	size_t offset = 0;
-	uint32_t metadata_size = *((uint32_t *)(image_data)); 
-	offset += sizeof(uint32_t);
-	Metadata *meta = metadata__unpack(NULL, metadata_size, (uint8_t *) image_data + offset); 
-	offset += metadata_size;
-	uint32_t image_data_size = meta->size;
-
-	char *enc = get_custom_metadata_string(meta, "enc");
-	int is_encoded = enc != NULL && !strcmp(enc, "jxl");
-	printf("Encoded: %d\n", is_encoded);
-	int width = meta->width;
-	int height = meta->height;
-	int channels = meta->channels;
-	int stride = width * channels;
-	uint8_t *data = image_data + offset;
-
-	if (is_encoded)
-	{
-		/* Decode image data using JXL */
-		JxlDecoder* decoder = JxlDecoderCreate(NULL);
-		if (JxlDecoderSetInput(decoder, image_data + offset, image_data_size) == JXL_DEC_ERROR)
-		{
-			printf("Error: Could not decode image\n");
-			return SLASH_EINVAL;
-		}
+	printf("Queued job %d\n", id);
+	return SLASH_SUCCESS;
+}
 
-		JxlBasicInfo basic_info;
-		size_t buffer_size;
-		JxlPixelFormat format;
-		uint8_t combined_channels;
-		JxlDecoderSubscribeEvents(decoder, JXL_DEC_BASIC_INFO | JXL_DEC_FULL_IMAGE | JXL_DEC_BASIC_INFO);
-		
-		while (1)
-		{
-			JxlDecoderStatus status = JxlDecoderProcessInput(decoder);
-
-			if (status == JXL_DEC_ERROR)
-			{
-				printf("Error: Jxl decoder error\n");
-				return SLASH_EINVAL;
-			}
-
-			if (status == JXL_DEC_SUCCESS) 
-			{
-				break;
-			}
-			
-			if (status == JXL_DEC_FULL_IMAGE) 
-			{
-				break;
-			}
-
-			if (status == JXL_DEC_BASIC_INFO) 
-			{
-				JxlDecoderGetBasicInfo(decoder, &basic_info);
-				combined_channels = basic_info.num_color_channels + basic_info.num_extra_channels;
-				format.num_channels = combined_channels; format.data_type = JXL_TYPE_UINT8; 
-				format.endianness = JXL_NATIVE_ENDIAN; format.align = 0;
-			}
-			
-			if (status == JXL_DEC_NEED_IMAGE_OUT_BUFFER) 
-			{
-				JxlDecoderImageOutBufferSize(decoder, &format, &buffer_size);
-				data = (uint8_t *)malloc(buffer_size);
-				JxlDecoderSetImageOutBuffer(decoder, &format, data, buffer_size);
-			}
-		}
+slash_command_sub(ippb, get, slash_csp_buffer_get, "[OPTIONS...] <offset>", "Fetch image at <offset> from the DISCO-2 ring-buffer (0 = oldest, -1 = newest)");
 
-		if (basic_info.xsize != width || basic_info.ysize != height || combined_channels != channels)
-		{
-			printf("Info: Dimensions given by metadata do not match decoded dimensions\n");
-		}
+static int slash_csp_buffer_jobs(struct slash *slash)
+{
+	ippc_jobs_print();
+	return SLASH_SUCCESS;
+}
+
+slash_command_sub(ippb, jobs, slash_csp_buffer_jobs, "", "List background downloads with their progress, rate and time left");
+
+static int slash_csp_buffer_cancel(struct slash *slash)
+{
+	optparse_t *parser = optparse_new("cancel", "<job-id>");
+	optparse_add_help(parser);
+
+	int argi = optparse_parse(parser, slash->argc - 1, (const char **)slash->argv + 1);
+	optparse_del(parser);
+	if (argi < 0)
+		return SLASH_EINVAL;
+
+	/* Check if job id is present */
+	if (++argi >= slash->argc)
+	{
+		printf("Missing job id\n");
+		return SLASH_EINVAL;
 	}
 
-	if (save_png)
+	return slash_status(ippc_job_cancel(atoi(slash->argv[argi])));
+}
+
+slash_command_sub(ippb, cancel, slash_csp_buffer_cancel, "<job-id>", "Cancel a background download, downloads in flight finish first");
+
+static int slash_csp_buffer_rings(struct slash *slash)
+{
+	unsigned int node = slash_dfl_node; // fetch current node id
+	unsigned int timeout = slash_dfl_timeout;
+	optparse_t *parser = optparse_new("rings", "");
+	optparse_add_help(parser);
+	optparse_add_unsigned(parser, 'n', "node", "NUM", 0, &node, "node (default = <env>)");
+	optparse_add_unsigned(parser, 't', "timeout", "NUM", 0, &timeout, "timeout (default = <env>)");
+
+	int argi = optparse_parse(parser, slash->argc - 1, (const char **)slash->argv + 1);
+	if (argi < 0)
 	{
-		/* Save decoded image data */
-		char filename[20];
-		sprintf(filename, "image_%s.png", meta->camera);
-		int write_success = stbi_write_png(filename, width, height, channels, data, stride);
-		if (!write_success)
-		{
-			fprintf(stderr, "Error writing image to %s\n", filename);
-			return SLASH_EINVAL;
-		}
-		else
-		{
-			printf("Image saved as %s\n", filename);
-		}
+		optparse_del(parser);
+		return SLASH_EINVAL;
 	}
+
+	/* Ring buffers are vmem areas of the node */
+	vmem_client_list(node, timeout, 2);
 	return SLASH_SUCCESS;
 }
 
-slash_command_sub(ippb, get, slash_csp_buffer_get, "[OPTIONS...] <offset>", "Fetch image at <offset> from the DISCO-2 ring-buffer (0 = oldest, -1 = newest)");
+slash_command_sub(ippb, rings, slash_csp_buffer_rings, "[OPTIONS...]", "List the vmem areas of a node, including its ring buffers");
+
+static int slash_csp_link_stats(struct slash *slash)
+{
+	unsigned int node = 0;
+	int json = false;
+	int clear = false;
+	optparse_t *parser = optparse_new("stats", "");
+	optparse_add_help(parser);
+	optparse_add_unsigned(parser, 'n', "node", "NUM", 0, &node, "only show this node (default = all)");
+	optparse_add_set(parser, 'j', "json", 1, &json, "Print the statistics as JSON");
+	optparse_add_set(parser, 'c', "clear", 1, &clear, "Delete the statistics");
+
+	int argi = optparse_parse(parser, slash->argc - 1, (const char **)slash->argv + 1);
+	optparse_del(parser);
+	if (argi < 0)
+		return SLASH_EINVAL;
+
+	return slash_status(ippc_link_stats(node, json, clear));
+}
+
+slash_command_sub(ippb, stats, slash_csp_link_stats, "[OPTIONS...]", "Show download and push statistics per node, kept across sessions");
+slash_command_sub(ippc, stats, slash_csp_link_stats, "[OPTIONS...]", "Show download and push statistics per node, kept across sessions");
+
+static int slash_csp_buffer_sync(struct slash *slash)
+{
+	unsigned int node = NODE_UNSET; // current node unless given
+	unsigned int timeout = slash_dfl_timeout;
+	int save_png = false;
+	unsigned int count = 10;
+	char *where = NULL;
+	char *node_list = NULL;
+	char *ring_list = NULL;
+	char *cursor_file = "ippb_cursors.txt";
+	unsigned int per_node = 1;
+	unsigned int per_link = 4;
+	int profile = false;
+	char *trace = NULL;
+	optparse_t *parser = optparse_new("sync", "");
+	optparse_add_help(parser);
+	optparse_add_set(parser, 'P', "profile", 1, &profile, "Print time and throughput of every phase");
+	optparse_add_string(parser, 'T', "trace", "FILE", &trace, "Write every phase to FILE as a Chrome trace");
+	optparse_add_unsigned(parser, 'n', "node", "NUM", 0, &node, "node (default = <env>)");
+	optparse_add_unsigned(parser, 't', "timeout", "NUM", 0, &timeout, "timeout (default = <env>)");
+	optparse_add_set(parser, 's', "save_png", 1, &save_png, "Save downloaded data as png (default = false)");
+	optparse_add_unsigned(parser, 'c', "count", "NUM", 0, &count, "newest entries to check per node and ring (default = 10)");
+	optparse_add_string(parser, 'w', "where", "EXPR", &where, "only decode and save entries whose metadata matches EXPR");
+	optparse_add_string(parser, 'N', "nodes", "LIST", &node_list, "comma separated nodes to download from");
+	optparse_add_string(parser, 'R', "rings", "LIST", &ring_list, "comma separated ring buffers, synced in this order (default = images)");
+	optparse_add_string(parser, 'C', "cursors", "FILE", &cursor_file, "cursor file (default = ippb_cursors.txt)");
+	optparse_add_unsigned(parser, 'p', "per_node", "NUM", 0, &per_node, "concurrent transfers per node (default = 1)");
+	optparse_add_unsigned(parser, 'l', "per_link", "NUM", 0, &per_link, "concurrent transfers in total (default = 4)");
 
+	int argi = optparse_parse(parser, slash->argc - 1, (const char **)slash->argv + 1);
+	if (argi < 0)
+	{
+		optparse_del(parser);
+		return SLASH_EINVAL;
+	}
+	if (profile)
+		profile_enable();
+	if (trace)
+		profile_trace(trace);
+
+	unsigned int nodes[FLEET_MAX_NODES];
+	int node_count = resolve_nodes(node_list, node, nodes);
+	if (node_count < 0)
+		return SLASH_EINVAL;
+
+	ippc_download_opts_t opts = {
+		.timeout = timeout,
+		.rings = ring_list,
+		.where = where,
+		.save_png = save_png,
+		.per_node = per_node,
+		.per_link = per_link,
+	};
+	return slash_status(ippc_buffer_sync(shell_context(), cursor_file, count, nodes, node_count, &opts));
+}
 
+PROFILED(slash_csp_buffer_sync)
+slash_command_sub(ippb, sync, slash_csp_buffer_sync_profiled, "[OPTIONS...]", "Download the entries added to the ring buffers since the last sync");
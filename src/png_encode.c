@@ -0,0 +1,9 @@
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "stb_image_write.h"
+
+#include "png_encode.h"
+
+uint8_t *png_encode(const uint8_t *pixels, int width, int height, int channels, int *size)
+{
+	return stbi_write_png_to_mem(pixels, width * channels, width, height, channels, size);
+}
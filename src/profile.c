@@ -0,0 +1,340 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "profile.h"
+
+typedef struct
+{
+	unsigned int calls;
+	uint64_t ns;
+	uint64_t bytes;
+} profile_entry_t;
+
+static const char *phase_names[PROFILE_PHASE_COUNT] = {
+	[PROFILE_PARSE] = "yaml parse",
+	[PROFILE_PACK] = "protobuf pack",
+	[PROFILE_COMPRESS] = "compress",
+	[PROFILE_PULL] = "param pull",
+	[PROFILE_PUSH] = "param push",
+	[PROFILE_DOWNLOAD] = "ring download",
+	[PROFILE_UNPACK] = "metadata unpack",
+	[PROFILE_DECODE] = "jxl decode",
+	[PROFILE_PNG_ENCODE] = "png encode",
+	[PROFILE_WRITE] = "file write",
+	[PROFILE_WAIT] = "queue wait",
+};
+
+/* Events beyond this are dropped, about 40 MB of trace */
+#define TRACE_MAX_EVENTS 1000000
+/* Trace process of local work, outside the range of CSP node addresses */
+#define TRACE_LOCAL_PID 100000
+
+typedef struct
+{
+	profile_phase_t phase;
+	unsigned int node;
+	unsigned int thread;
+	uint64_t start;
+	uint64_t ns;
+	size_t bytes;
+} trace_event_t;
+
+static pthread_mutex_t profile_lock = PTHREAD_MUTEX_INITIALIZER;
+static profile_entry_t profile_entries[PROFILE_PHASE_COUNT];
+static int profile_on = 0;
+static int report_on = 0;
+
+static char *trace_file = NULL;
+static trace_event_t *trace_events = NULL;
+static size_t trace_count = 0;
+static size_t trace_capacity = 0;
+static size_t trace_dropped = 0;
+static unsigned int trace_threads = 0;
+static unsigned int trace_generation = 0;
+static uint64_t trace_origin = 0;
+
+static __thread unsigned int thread_node = 0;
+static __thread unsigned int thread_id = 0;
+static __thread unsigned int thread_generation = 0;
+static __thread int thread_muted = 0;
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+void profile_reset(void)
+{
+	const char *env = getenv("IPPC_PROFILE");
+	const char *trace_env = getenv("IPPC_TRACE");
+
+	pthread_mutex_lock(&profile_lock);
+	for (int i = 0; i < PROFILE_PHASE_COUNT; i++)
+	{
+		profile_entries[i].calls = 0;
+		profile_entries[i].ns = 0;
+		profile_entries[i].bytes = 0;
+	}
+	report_on = env != NULL && atoi(env) != 0;
+	profile_on = report_on;
+	free(trace_file);
+	free(trace_events);
+	trace_file = NULL;
+	trace_events = NULL;
+	trace_count = 0;
+	trace_capacity = 0;
+	pthread_mutex_unlock(&profile_lock);
+
+	if (trace_env != NULL && trace_env[0] != '\0')
+		profile_trace(trace_env);
+}
+
+void profile_enable(void)
+{
+	report_on = 1;
+	profile_on = 1;
+}
+
+int profile_enabled(void)
+{
+	return report_on;
+}
+
+void profile_trace(const char *filename)
+{
+	pthread_mutex_lock(&profile_lock);
+	free(trace_file);
+	free(trace_events);
+	trace_file = strdup(filename);
+	trace_events = NULL;
+	trace_count = 0;
+	trace_capacity = 0;
+	trace_dropped = 0;
+	trace_threads = 0;
+	trace_generation++;
+	trace_origin = now_ns();
+	profile_on = 1;
+	pthread_mutex_unlock(&profile_lock);
+}
+
+void profile_mute(int muted)
+{
+	thread_muted = muted;
+}
+
+int profile_muted(void)
+{
+	return thread_muted;
+}
+
+void profile_set_node(unsigned int node)
+{
+	thread_node = node;
+}
+
+/* Called with profile_lock held */
+static void trace_record(profile_phase_t phase, uint64_t start, uint64_t elapsed, size_t bytes)
+{
+	if (trace_count == trace_capacity)
+	{
+		size_t capacity = trace_capacity ? trace_capacity * 2 : 1024;
+		if (capacity > TRACE_MAX_EVENTS)
+			capacity = TRACE_MAX_EVENTS;
+		trace_event_t *events = capacity > trace_capacity ? realloc(trace_events, capacity * sizeof(trace_event_t)) : NULL;
+		if (events == NULL)
+		{
+			trace_dropped++;
+			return;
+		}
+		trace_events = events;
+		trace_capacity = capacity;
+	}
+	/* Threads are numbered in the order they first record an event */
+	if (thread_generation != trace_generation)
+	{
+		thread_generation = trace_generation;
+		thread_id = ++trace_threads;
+	}
+
+	trace_event_t *event = &trace_events[trace_count++];
+	event->phase = phase;
+	event->node = thread_node;
+	event->thread = thread_id;
+	event->start = start;
+	event->ns = elapsed;
+	event->bytes = bytes;
+}
+
+uint64_t profile_start(void)
+{
+	return profile_on && !thread_muted ? now_ns() : 0;
+}
+
+void profile_end(profile_phase_t phase, uint64_t start, size_t bytes)
+{
+	if (start == 0)
+		return;
+	uint64_t elapsed = now_ns() - start;
+
+	pthread_mutex_lock(&profile_lock);
+	profile_entries[phase].calls++;
+	profile_entries[phase].ns += elapsed;
+	profile_entries[phase].bytes += bytes;
+	if (trace_file != NULL)
+		trace_record(phase, start, elapsed, bytes);
+	pthread_mutex_unlock(&profile_lock);
+}
+
+void profile_collect(void)
+{
+	profile_on = 1;
+}
+
+const char *profile_phase_name(profile_phase_t phase)
+{
+	return phase_names[phase];
+}
+
+void profile_totals(profile_phase_t phase, unsigned int *calls, uint64_t *ns, uint64_t *bytes)
+{
+	pthread_mutex_lock(&profile_lock);
+	*calls = profile_entries[phase].calls;
+	*ns = profile_entries[phase].ns;
+	*bytes = profile_entries[phase].bytes;
+	pthread_mutex_unlock(&profile_lock);
+}
+
+void profile_report(void)
+{
+	pthread_mutex_lock(&profile_lock);
+	printf("%-16s %6s %12s %12s %10s\n", "Phase", "Calls", "Time [ms]", "Bytes", "MB/s");
+	for (int i = 0; i < PROFILE_PHASE_COUNT; i++)
+	{
+		const profile_entry_t *entry = &profile_entries[i];
+		if (entry->calls == 0)
+			continue;
+		double ms = entry->ns / 1e6;
+		printf("%-16s %6u %12.3f %12llu", phase_names[i], entry->calls, ms, (unsigned long long)entry->bytes);
+		if (entry->bytes > 0 && entry->ns > 0)
+			printf(" %10.2f\n", entry->bytes / (entry->ns / 1e9) / 1e6);
+		else
+			printf(" %10s\n", "-");
+	}
+	pthread_mutex_unlock(&profile_lock);
+}
+
+static unsigned int trace_pid(unsigned int node)
+{
+	return node == 0 ? TRACE_LOCAL_PID : node;
+}
+
+/* Separates the events of the trace array */
+static const char *trace_sep(size_t *written)
+{
+	return (*written)++ > 0 ? ",\n" : "";
+}
+
+/* Name the process of every node and the thread of every worker that has events */
+static int trace_write_names(FILE *fh, size_t *written)
+{
+	typedef struct
+	{
+		unsigned int node;
+		unsigned int thread;
+	} track_t;
+	track_t *tracks = NULL;
+	size_t track_count = 0;
+
+	for (size_t i = 0; i < trace_count; i++)
+	{
+		const trace_event_t *event = &trace_events[i];
+		int named_pid = 0;
+		int named_tid = 0;
+		for (size_t j = 0; j < track_count && !named_tid; j++)
+		{
+			named_pid |= tracks[j].node == event->node;
+			named_tid |= tracks[j].node == event->node && tracks[j].thread == event->thread;
+		}
+		if (named_tid)
+			continue;
+
+		track_t *grown = realloc(tracks, (track_count + 1) * sizeof(track_t));
+		if (grown == NULL)
+		{
+			free(tracks);
+			return -1;
+		}
+		tracks = grown;
+		tracks[track_count].node = event->node;
+		tracks[track_count].thread = event->thread;
+		track_count++;
+
+		unsigned int pid = trace_pid(event->node);
+		if (!named_pid)
+		{
+			if (event->node == 0)
+				fprintf(fh, "%s{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":%u,\"args\":{\"name\":\"local\"}}", trace_sep(written), pid);
+			else
+				fprintf(fh, "%s{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":%u,\"args\":{\"name\":\"node %u\"}}", trace_sep(written), pid, event->node);
+		}
+		fprintf(fh, "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":%u,\"tid\":%u,\"args\":{\"name\":\"worker %u\"}}", trace_sep(written), pid, event->thread, event->thread);
+	}
+	free(tracks);
+	return 0;
+}
+
+int profile_trace_write(void)
+{
+	pthread_mutex_lock(&profile_lock);
+	if (trace_file == NULL)
+	{
+		pthread_mutex_unlock(&profile_lock);
+		return 0;
+	}
+
+	int ret = 0;
+	FILE *fh = fopen(trace_file, "w");
+	if (fh == NULL)
+	{
+		fprintf(stderr, "Error: Failed to open trace file %s\n", trace_file);
+		ret = -1;
+	}
+	else
+	{
+		size_t written = 0;
+		fprintf(fh, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+		if (trace_write_names(fh, &written) < 0)
+			fprintf(stderr, "Error: Failed to allocate memory for trace track names\n");
+		for (size_t i = 0; i < trace_count; i++)
+		{
+			const trace_event_t *event = &trace_events[i];
+			fprintf(fh, "%s{\"ph\":\"X\",\"name\":\"%s\",\"pid\":%u,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"bytes\":%zu}}",
+					trace_sep(&written), phase_names[event->phase], trace_pid(event->node), event->thread,
+					(event->start - trace_origin) / 1e3, event->ns / 1e3, event->bytes);
+		}
+		fprintf(fh, "\n]}\n");
+		if (fclose(fh) != 0)
+		{
+			fprintf(stderr, "Error: Failed to write trace file %s\n", trace_file);
+			ret = -1;
+		}
+		else
+			printf("Wrote %zu trace events to %s\n", trace_count, trace_file);
+	}
+	if (trace_dropped > 0)
+		fprintf(stderr, "Error: Dropped %zu trace events\n", trace_dropped);
+
+	free(trace_file);
+	free(trace_events);
+	trace_file = NULL;
+	trace_events = NULL;
+	trace_count = 0;
+	trace_capacity = 0;
+	pthread_mutex_unlock(&profile_lock);
+	return ret;
+}
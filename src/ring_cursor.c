@@ -0,0 +1,145 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <inttypes.h>
+
+#include "ring_cursor.h"
+
+/* Parse the optional comma separated hashes after the timestamp of a cursor line */
+static int parse_ties(const char *pos, long long timestamp, ring_mark_t *mark)
+{
+	mark->timestamp = timestamp;
+	while (*pos == ' ' || *pos == '\t')
+		pos++;
+	while (*pos != '\n' && *pos != '\0')
+	{
+		char *end;
+		unsigned long hash = strtoul(pos, &end, 16);
+		if (end == pos || (*end != ',' && *end != '\n' && *end != '\0') || hash > UINT32_MAX)
+			return -1;
+		ring_mark_add(mark, timestamp, hash);
+		pos = *end == ',' ? end + 1 : end;
+	}
+	return 0;
+}
+
+int ring_cursor_load(const char *path, ring_cursor_set_t *set)
+{
+	set->count = 0;
+	FILE *fh = fopen(path, "r");
+	if (fh == NULL)
+		return errno == ENOENT ? 0 : -1;
+
+	char line[64 + 9 * RING_MARK_TIES];
+	int ret = 0;
+	while (fgets(line, sizeof(line), fh) != NULL)
+	{
+		if (line[0] == '#' || line[0] == '\n')
+			continue;
+
+		unsigned int node;
+		char ring[RING_NAME_MAX];
+		long long timestamp;
+		int used;
+		ring_mark_t mark = {0};
+		if (sscanf(line, "%u %31s %lld%n", &node, ring, &timestamp, &used) != 3 || parse_ties(line + used, timestamp, &mark) < 0)
+		{
+			fprintf(stderr, "Error: Malformed cursor in %s: %s", path, line);
+			ret = -1;
+			break;
+		}
+		ring_cursor_t *cursor = ring_cursor_get(set, node, ring);
+		if (cursor == NULL)
+		{
+			fprintf(stderr, "Error: %s has more than %d cursors\n", path, RING_CURSOR_MAX);
+			ret = -1;
+			break;
+		}
+		cursor->mark = mark;
+	}
+
+	fclose(fh);
+	return ret;
+}
+
+int ring_cursor_save(const char *path, const ring_cursor_set_t *set)
+{
+	char tmp_path[strlen(path) + 5];
+	sprintf(tmp_path, "%s.tmp", path);
+	FILE *fh = fopen(tmp_path, "w");
+	if (fh == NULL)
+	{
+		fprintf(stderr, "Error: Could not write cursors to %s\n", tmp_path);
+		return -1;
+	}
+
+	fprintf(fh, "# node ring timestamp hashes\n");
+	for (int i = 0; i < set->count; i++)
+	{
+		const ring_cursor_t *cursor = &set->cursors[i];
+		fprintf(fh, "%u %s %lld", cursor->node, cursor->ring, cursor->mark.timestamp);
+		for (int t = 0; t < cursor->mark.tie_count; t++)
+			fprintf(fh, "%c%08" PRIx32, t == 0 ? ' ' : ',', cursor->mark.ties[t]);
+		fprintf(fh, "\n");
+	}
+
+	if (fclose(fh) != 0 || rename(tmp_path, path) < 0)
+	{
+		fprintf(stderr, "Error: Could not write cursors to %s\n", path);
+		remove(tmp_path);
+		return -1;
+	}
+	return 0;
+}
+
+ring_cursor_t *ring_cursor_get(ring_cursor_set_t *set, unsigned int node, const char *ring)
+{
+	for (int i = 0; i < set->count; i++)
+	{
+		if (set->cursors[i].node == node && strcmp(set->cursors[i].ring, ring) == 0)
+			return &set->cursors[i];
+	}
+	if (set->count >= RING_CURSOR_MAX || strlen(ring) >= RING_NAME_MAX)
+		return NULL;
+
+	ring_cursor_t *cursor = &set->cursors[set->count++];
+	cursor->node = node;
+	snprintf(cursor->ring, sizeof(cursor->ring), "%s", ring);
+	cursor->mark = (ring_mark_t){0};
+	return cursor;
+}
+
+uint32_t ring_entry_hash(const uint8_t *data, size_t size)
+{
+	uint32_t hash = 0x811c9dc5;
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= data[i];
+		hash *= 0x01000193;
+	}
+	return hash;
+}
+
+int ring_mark_has(const ring_mark_t *mark, long long timestamp, uint32_t hash)
+{
+	if (timestamp != mark->timestamp)
+		return 0;
+	for (int i = 0; i < mark->tie_count; i++)
+	{
+		if (mark->ties[i] == hash)
+			return 1;
+	}
+	return 0;
+}
+
+void ring_mark_add(ring_mark_t *mark, long long timestamp, uint32_t hash)
+{
+	if (timestamp != mark->timestamp)
+	{
+		mark->timestamp = timestamp;
+		mark->tie_count = 0;
+	}
+	if (mark->tie_count < RING_MARK_TIES && !ring_mark_has(mark, timestamp, hash))
+		mark->ties[mark->tie_count++] = hash;
+}
@@ -0,0 +1,332 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include <vmem/vmem_client.h>
+
+#include "ring_scheduler.h"
+#include "profile.h"
+#include "link_stats.h"
+
+/* Download statistics and pending jobs of one node and ring */
+typedef struct
+{
+	unsigned int node;
+	const char *ring;
+	uint64_t bytes;
+	int entries;
+	int node_idx;
+	int *pending; // job indexes in job order
+	int pending_count;
+	int next; // first pending job
+} ring_source_t;
+
+/* Transfers in flight from a node, shared by all its rings */
+typedef struct
+{
+	unsigned int node;
+	int active;
+} ring_node_t;
+
+typedef struct
+{
+	ring_job_t *jobs;
+	int count;
+	const ring_scheduler_config_t *config;
+
+	pthread_mutex_t lock;
+	pthread_cond_t changed;
+	int *source; // source index of every job
+	int *pending; // job indexes grouped by source, shared by the sources
+	ring_source_t *sources;
+	int source_count;
+	ring_node_t *nodes;
+	int node_count;
+	int remaining;
+	int muted; // profiling of the scheduling thread, inherited by the workers
+	unsigned int workers;
+
+	ring_scheduler_stats_t stats;
+} ring_scheduler_t;
+
+uint8_t *ring_buffer_take(ring_buffer_pool_t *pool)
+{
+	uint8_t *buffer = NULL;
+	pthread_mutex_lock(&pool->lock);
+	if (pool->count > 0)
+		buffer = pool->free[--pool->count];
+	pthread_mutex_unlock(&pool->lock);
+	return buffer != NULL ? buffer : malloc(RING_ENTRY_MAX);
+}
+
+void ring_buffer_give(ring_buffer_pool_t *pool, uint8_t *buffer, unsigned int keep)
+{
+	if (buffer == NULL)
+		return;
+	if (keep > RING_BUFFERS_KEPT)
+		keep = RING_BUFFERS_KEPT;
+	pthread_mutex_lock(&pool->lock);
+
+	/* Drop buffers kept for schedules with more workers */
+	while (pool->count > (int)keep)
+		free(pool->free[--pool->count]);
+	if (pool->count < (int)keep)
+	{
+		pool->free[pool->count++] = buffer;
+		buffer = NULL;
+	}
+	pthread_mutex_unlock(&pool->lock);
+	free(buffer);
+}
+
+void ring_buffer_pool_clear(ring_buffer_pool_t *pool)
+{
+	pthread_mutex_lock(&pool->lock);
+	while (pool->count > 0)
+		free(pool->free[--pool->count]);
+	pthread_mutex_unlock(&pool->lock);
+}
+
+static int ring_download(const ring_job_t *job, unsigned int timeout, uint8_t *buffer)
+{
+	return vmem_ring_download(job->node, timeout, (char *)job->ring, job->offset, (char *)buffer, 2, 1);
+}
+
+static int find_source(ring_scheduler_t *sched, unsigned int node, const char *ring)
+{
+	for (int i = 0; i < sched->source_count; i++)
+	{
+		if (sched->sources[i].node == node && strcmp(sched->sources[i].ring, ring) == 0)
+			return i;
+	}
+	return -1;
+}
+
+static int find_node(ring_scheduler_t *sched, unsigned int node)
+{
+	for (int i = 0; i < sched->node_count; i++)
+	{
+		if (sched->nodes[i].node == node)
+			return i;
+	}
+	return -1;
+}
+
+/* Estimated size of an entry, the average of the source or of all downloads so far */
+static double estimate_size(ring_scheduler_t *sched, const ring_source_t *source)
+{
+	if (source->entries > 0)
+		return (double)source->bytes / source->entries;
+	if (sched->stats.downloaded > 0)
+		return (double)sched->stats.bytes / sched->stats.downloaded;
+	return 1;
+}
+
+/* Pick the next job, the first pending one of the node with the most estimated bytes left. Called locked */
+static int next_job(ring_scheduler_t *sched)
+{
+	double left[sched->node_count];
+	int first[sched->node_count];
+	for (int n = 0; n < sched->node_count; n++)
+	{
+		left[n] = 0;
+		first[n] = -1;
+	}
+
+	/* Estimated bytes left and first pending source of every node */
+	for (int i = 0; i < sched->source_count; i++)
+	{
+		ring_source_t *source = &sched->sources[i];
+		int pending = source->pending_count - source->next;
+		if (pending == 0)
+			continue;
+		int n = source->node_idx;
+		left[n] += pending * estimate_size(sched, source);
+		if (first[n] < 0 || source->pending[source->next] < sched->sources[first[n]].pending[sched->sources[first[n]].next])
+			first[n] = i;
+	}
+
+	int best = -1;
+	for (int n = 0; n < sched->node_count; n++)
+	{
+		if (first[n] < 0 || sched->nodes[n].active >= (int)sched->config->per_node)
+			continue;
+		if (best < 0 || left[n] > left[best])
+			best = n;
+	}
+	if (best < 0)
+		return -1;
+
+	ring_source_t *source = &sched->sources[first[best]];
+	return source->pending[source->next++];
+}
+
+static int cancelled(ring_scheduler_t *sched)
+{
+	return sched->config->cancel != NULL && *sched->config->cancel;
+}
+
+static void *ring_worker(void *arg)
+{
+	ring_scheduler_t *sched = arg;
+	ring_buffer_pool_t *pool = sched->config->buffers;
+	uint8_t *buffer = pool != NULL ? ring_buffer_take(pool) : malloc(RING_ENTRY_MAX);
+	ring_download_t download = sched->config->download != NULL ? sched->config->download : ring_download;
+	profile_mute(sched->muted);
+
+	pthread_mutex_lock(&sched->lock);
+	while (buffer != NULL && sched->remaining > 0 && !cancelled(sched))
+	{
+		int job_idx = next_job(sched);
+		if (job_idx < 0)
+		{
+			/* Every pending job waits for a busy node */
+			uint64_t start = profile_start();
+			pthread_cond_wait(&sched->changed, &sched->lock);
+			profile_end(PROFILE_WAIT, start, 0);
+			continue;
+		}
+		ring_job_t *job = &sched->jobs[job_idx];
+		ring_source_t *source = &sched->sources[sched->source[job_idx]];
+		ring_node_t *node = &sched->nodes[source->node_idx];
+		node->active++;
+		pthread_mutex_unlock(&sched->lock);
+
+		profile_set_node(job->node);
+		uint64_t start = profile_start();
+		uint64_t sent = link_stats_now();
+		int size = download(job, sched->config->timeout, buffer);
+		link_stats_record(LINK_DOWNLOAD, job->node, link_stats_now() - sent, size > 0 ? size : 0, size < 0);
+		profile_end(PROFILE_DOWNLOAD, start, size > 0 ? size : 0);
+		job->size = size;
+		int ret = -1;
+		if (size < 0)
+			printf("Download of offset %d from ring '%s' on node %u failed\n", job->offset, job->ring, job->node);
+		else
+			ret = sched->config->handler(job, buffer, size, sched->config->arg);
+		profile_set_node(0);
+
+		pthread_mutex_lock(&sched->lock);
+		node->active--;
+		sched->remaining--;
+		if (size >= 0)
+		{
+			source->bytes += size;
+			source->entries++;
+			sched->stats.bytes += size;
+			sched->stats.downloaded++;
+		}
+		if (ret < 0)
+			sched->stats.failed++;
+		if (sched->config->progress != NULL)
+			sched->config->progress(sched->count - sched->remaining, sched->stats.bytes, sched->config->arg);
+		pthread_cond_broadcast(&sched->changed);
+	}
+	pthread_mutex_unlock(&sched->lock);
+
+	if (buffer == NULL)
+		fprintf(stderr, "Error: Failed to allocate download buffer\n");
+	else if (pool != NULL)
+		ring_buffer_give(pool, buffer, sched->workers);
+	else
+		free(buffer);
+	return NULL;
+}
+
+int ring_schedule(ring_job_t *jobs, int count, const ring_scheduler_config_t *config, ring_scheduler_stats_t *stats)
+{
+	ring_scheduler_t sched = {
+		.jobs = jobs,
+		.count = count,
+		.config = config,
+		.remaining = count,
+		.muted = profile_muted(),
+	};
+	sched.source = calloc(count, sizeof(int));
+	sched.pending = calloc(count, sizeof(int));
+	sched.sources = calloc(count, sizeof(ring_source_t));
+	sched.nodes = calloc(count, sizeof(ring_node_t));
+	if (count > 0 && (sched.source == NULL || sched.pending == NULL || sched.sources == NULL || sched.nodes == NULL))
+	{
+		fprintf(stderr, "Error: Failed to allocate memory for scheduler\n");
+		free(sched.source);
+		free(sched.pending);
+		free(sched.sources);
+		free(sched.nodes);
+		return count;
+	}
+
+	for (int i = 0; i < count; i++)
+	{
+		jobs[i].size = -1;
+		int idx = find_source(&sched, jobs[i].node, jobs[i].ring);
+		if (idx < 0)
+		{
+			idx = sched.source_count++;
+			sched.sources[idx].node = jobs[i].node;
+			sched.sources[idx].ring = jobs[i].ring;
+			sched.sources[idx].node_idx = find_node(&sched, jobs[i].node);
+			if (sched.sources[idx].node_idx < 0)
+			{
+				sched.sources[idx].node_idx = sched.node_count++;
+				sched.nodes[sched.sources[idx].node_idx].node = jobs[i].node;
+			}
+		}
+		sched.source[i] = idx;
+		sched.sources[idx].pending_count++;
+	}
+
+	/* Queue the jobs of every source in job order */
+	int queued = 0;
+	for (int i = 0; i < sched.source_count; i++)
+	{
+		sched.sources[i].pending = sched.pending + queued;
+		queued += sched.sources[i].pending_count;
+		sched.sources[i].pending_count = 0;
+	}
+	for (int i = 0; i < count; i++)
+	{
+		ring_source_t *source = &sched.sources[sched.source[i]];
+		source->pending[source->pending_count++] = i;
+	}
+
+	pthread_mutex_init(&sched.lock, NULL);
+	pthread_cond_init(&sched.changed, NULL);
+
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	unsigned int workers = config->per_link > 0 ? config->per_link : 1;
+	if (workers > (unsigned int)count)
+		workers = count > 0 ? count : 1;
+	sched.workers = workers;
+	pthread_t threads[workers];
+	unsigned int started = 0;
+	for (; started < workers; started++)
+	{
+		if (pthread_create(&threads[started], NULL, ring_worker, &sched) != 0)
+			break;
+	}
+	if (started == 0)
+		ring_worker(&sched);
+	for (unsigned int i = 0; i < started; i++)
+		pthread_join(threads[i], NULL);
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	sched.stats.elapsed_ms = (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6;
+
+	/* Jobs never started, e.g. after allocation failures or cancellation, count as failed */
+	sched.stats.failed += sched.remaining;
+
+	pthread_cond_destroy(&sched.changed);
+	pthread_mutex_destroy(&sched.lock);
+	free(sched.source);
+	free(sched.pending);
+	free(sched.sources);
+	free(sched.nodes);
+
+	if (stats != NULL)
+		*stats = sched.stats;
+	return sched.stats.failed;
+}
@@ -0,0 +1,24 @@
+#ifndef IPPC_TEST_H
+#define IPPC_TEST_H
+
+#include <stdio.h>
+
+/*
+ * Minimal checks for the unit tests run by meson test. A failed check is
+ * reported with its location and the test exits non-zero once done.
+ */
+static int test_failures;
+
+#define CHECK(cond)                                                                     \
+	do                                                                                  \
+	{                                                                                   \
+		if (!(cond))                                                                    \
+		{                                                                               \
+			fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+			test_failures++;                                                            \
+		}                                                                               \
+	} while (0)
+
+#define TEST_RESULT() (test_failures > 0 ? 1 : 0)
+
+#endif
@@ -0,0 +1,130 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <dirent.h>
+
+#include "ippc.h"
+#include "ring_cursor.h"
+#include "test.h"
+
+#define RING_SIZE 32
+
+/* Stand-in ring of one pixel observations, each with its own camera name */
+static long long timestamps[RING_SIZE];
+static int ring_count = 0;
+static int grow_at = 0; // offset whose first download appends an entry first, 0 for none
+static long long grow_timestamp;
+
+static void append(long long timestamp)
+{
+	timestamps[ring_count++] = timestamp;
+}
+
+static int fake_download(const ring_job_t *job, unsigned int timeout, uint8_t *buffer)
+{
+	if (grow_at != 0 && job->offset == grow_at)
+	{
+		grow_at = 0;
+		append(grow_timestamp);
+	}
+	int index = ring_count + job->offset;
+	if (index < 0 || index >= ring_count)
+		return -1;
+
+	char camera[16];
+	snprintf(camera, sizeof(camera), "e%d", index);
+	Metadata meta = METADATA__INIT;
+	meta.size = 1;
+	meta.width = 1;
+	meta.height = 1;
+	meta.channels = 1;
+	meta.bits_pixel = 8;
+	meta.timestamp = timestamps[index];
+	meta.camera = camera;
+	uint32_t meta_size = metadata__get_packed_size(&meta);
+	memcpy(buffer, &meta_size, sizeof(meta_size));
+	metadata__pack(&meta, buffer + sizeof(meta_size));
+	buffer[sizeof(meta_size) + meta_size] = index;
+	return sizeof(meta_size) + meta_size + 1;
+}
+
+/* Returns the saved entries as a bit set and removes their files, -1 if an entry was saved twice */
+static long long take_saved(void)
+{
+	long long saved = 0;
+	DIR *dir = opendir(".");
+	struct dirent *ent;
+	while ((ent = readdir(dir)) != NULL)
+	{
+		int index;
+		if (sscanf(ent->d_name, "image_e%d_", &index) != 1)
+			continue;
+		if (saved >= 0)
+			saved = saved & (1LL << index) ? -1 : saved | (1LL << index);
+		unlink(ent->d_name);
+	}
+	closedir(dir);
+	return saved;
+}
+
+static long long entries(int first, int last)
+{
+	long long set = 0;
+	for (int i = first; i <= last; i++)
+		set |= 1LL << i;
+	return set;
+}
+
+int main(void)
+{
+	char dir[] = "/tmp/ippc_sync_XXXXXX";
+	if (mkdtemp(dir) == NULL || chdir(dir) < 0)
+		return 1;
+
+	unsigned int node = 162;
+	ippc_download_opts_t opts = {.timeout = 100, .save_png = 1, .per_node = 1, .per_link = 1, .download = fake_download};
+
+	/* A new cursor starts at the newest page, entries of one second are all saved */
+	append(1000);
+	append(1000);
+	append(1000);
+	CHECK(ippc_buffer_sync(NULL, "cursors", 2, &node, 1, &opts) == IPPC_OK);
+	CHECK(take_saved() == entries(1, 2));
+
+	/* Entries appended in the second of the cursor are new */
+	append(1000);
+	append(1000);
+	append(1001);
+	CHECK(ippc_buffer_sync(NULL, "cursors", 2, &node, 1, &opts) == IPPC_OK);
+	CHECK(take_saved() == entries(3, 5));
+	append(1001);
+	append(1001);
+	CHECK(ippc_buffer_sync(NULL, "cursors", 2, &node, 1, &opts) == IPPC_OK);
+	CHECK(take_saved() == entries(6, 7));
+
+	/* The cursor keeps every entry of its second across syncs */
+	ring_cursor_set_t *cursors = malloc(sizeof(ring_cursor_set_t));
+	CHECK(ring_cursor_load("cursors", cursors) == 0 && cursors->count == 1);
+	CHECK(cursors->cursors[0].mark.timestamp == 1001 && cursors->cursors[0].mark.tie_count == 3);
+	CHECK(ippc_buffer_sync(NULL, "cursors", 2, &node, 1, &opts) == IPPC_OK);
+	CHECK(take_saved() == 0);
+
+	/* An entry appended while paging shifts the next page, which still reaches the cursor */
+	append(1002);
+	append(1002);
+	append(1002);
+	append(1002);
+	grow_at = -3;
+	grow_timestamp = 1002;
+	CHECK(ippc_buffer_sync(NULL, "cursors", 2, &node, 1, &opts) == IPPC_OK);
+	CHECK(take_saved() == entries(8, 11));
+	CHECK(ippc_buffer_sync(NULL, "cursors", 2, &node, 1, &opts) == IPPC_OK);
+	CHECK(take_saved() == entries(12, 12));
+
+	free(cursors);
+	unlink("cursors");
+	chdir("/");
+	rmdir(dir);
+	return TEST_RESULT();
+}
@@ -0,0 +1,82 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cli_parse.h"
+#include "test.h"
+
+#define ARGS_MAX 8
+
+static char *argv[ARGS_MAX];
+
+static int split(const char *text)
+{
+	static char line[256];
+	snprintf(line, sizeof(line), "%s", text);
+	return cli_split_line(line, argv, ARGS_MAX);
+}
+
+/* JSON string of len bytes of str, to free */
+static char *json(const char *str, size_t len)
+{
+	char *data = NULL;
+	size_t size = 0;
+	FILE *out = open_memstream(&data, &size);
+	cli_json_string(out, str, len);
+	fclose(out);
+	return data;
+}
+
+static int json_is(const char *str, const char *expected)
+{
+	char *data = json(str, strlen(str));
+	int same = strcmp(data, expected) == 0;
+	if (!same)
+		fprintf(stderr, "got %s, expected %s\n", data, expected);
+	free(data);
+	return same;
+}
+
+int main(void)
+{
+	/* Blanks separate arguments */
+	CHECK(split("get -s -c 5 -- -1\n") == 6);
+	CHECK(strcmp(argv[0], "get") == 0 && strcmp(argv[4], "--") == 0 && strcmp(argv[5], "-1") == 0);
+	CHECK(split("  sync\t-N 162,163 \r\n") == 3 && strcmp(argv[2], "162,163") == 0);
+
+	/* Quotes group words and are removed */
+	CHECK(split("get -w \"camera == 'vis'\" 0") == 4 && strcmp(argv[2], "camera == 'vis'") == 0);
+	CHECK(split("get -w 'width > 64' 0") == 4 && strcmp(argv[2], "width > 64") == 0);
+	CHECK(split("apply a\" b\"c") == 2 && strcmp(argv[1], "a bc") == 0);
+	CHECK(split("apply \"\"") == 2 && strcmp(argv[1], "") == 0);
+
+	/* Comments and empty lines */
+	CHECK(split("# Configure first\n") == 0);
+	CHECK(split("status # of node 162") == 1);
+	CHECK(split("   \n") == 0);
+	CHECK(split("") == 0);
+
+	/* Open quotes and too many arguments */
+	CHECK(split("get -w \"camera == 'vis' 0") == -1);
+	CHECK(split("a b c d e f g") == 7);
+	CHECK(split("a b c d e f g h") == -1);
+
+	/* JSON strings escape quotes, backslashes and control characters */
+	CHECK(json_is("Image saved as image_vis.png", "\"Image saved as image_vis.png\""));
+	CHECK(json_is("say \"hi\"", "\"say \\\"hi\\\"\""));
+	CHECK(json_is("C:\\path", "\"C:\\\\path\""));
+	CHECK(json_is("one\ntwo\tthree\r", "\"one\\ntwo\\tthree\\u000d\""));
+	CHECK(json_is("\x01\x1f", "\"\\u0001\\u001f\""));
+	CHECK(json_is("", "\"\""));
+
+	/* UTF-8 passes through, and the length bounds the string even past a NUL */
+	CHECK(json_is("\xc3\xa6\xc3\xb8", "\"\xc3\xa6\xc3\xb8\""));
+	char *data = json("ab\0cd", 5);
+	CHECK(strcmp(data, "\"ab\\u0000cd\"") == 0);
+	free(data);
+	data = json("abcdef", 3);
+	CHECK(strcmp(data, "\"abc\"") == 0);
+	free(data);
+
+	return TEST_RESULT();
+}
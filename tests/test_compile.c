@@ -0,0 +1,119 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "ippc.h"
+#include "ippc_params.h"
+#include "config_bundle.h"
+#include "config_codec.h"
+#include "pipeline_config.pb-c.h"
+#include "module_config.pb-c.h"
+#include "test.h"
+
+static char dir[] = "/tmp/ippc_compile_XXXXXX";
+
+static const char *write_file(const char *name, const char *content)
+{
+	static char path[4][64];
+	static int next = 0;
+	char *p = path[next++ % 4];
+	snprintf(p, sizeof(path[0]), "%s/%s", dir, name);
+	FILE *file = fopen(p, "w");
+	fputs(content, file);
+	fclose(file);
+	return p;
+}
+
+/* Decode the buffer of an artifact entry back into packed protobuf */
+static size_t decode_entry(const config_bundle_entry_t *entry, uint8_t *packed, size_t size)
+{
+	uint8_t buffer[DATA_PARAM_SIZE] = {0};
+	memcpy(buffer, entry->data, entry->length);
+	if (config_buffer_size(buffer, sizeof(buffer)) != entry->length)
+		return 0;
+	if (config_decode(buffer, sizeof(buffer), packed, &size) < 0)
+		return 0;
+	return size;
+}
+
+static int check_pipeline(const config_bundle_entry_t *entry, int param_id)
+{
+	uint8_t packed[1024];
+	size_t size = decode_entry(entry, packed, sizeof(packed));
+	PipelineDefinition *pipeline = pipeline_definition__unpack(NULL, size, packed);
+	int ok = entry->param_id == param_id && pipeline != NULL && pipeline->n_modules == 2 &&
+			 strcmp(pipeline->modules[0]->name, "demosaic") == 0 && pipeline->modules[1]->order == 2 &&
+			 pipeline->modules[1]->param_id == 2;
+	if (pipeline != NULL)
+		pipeline_definition__free_unpacked(pipeline, NULL);
+	return ok;
+}
+
+static int check_module(const config_bundle_entry_t *entry, int param_id)
+{
+	uint8_t packed[1024];
+	size_t size = decode_entry(entry, packed, sizeof(packed));
+	ModuleConfig *module = module_config__unpack(NULL, size, packed);
+	int ok = entry->param_id == param_id && module != NULL && module->n_parameters == 2 &&
+			 strcmp(module->parameters[0]->key, "distance") == 0 &&
+			 module->parameters[0]->value_case == CONFIG_PARAMETER__VALUE_FLOAT_VALUE &&
+			 module->parameters[0]->float_value == 0.5f &&
+			 module->parameters[1]->value_case == CONFIG_PARAMETER__VALUE_INT_VALUE &&
+			 module->parameters[1]->int_value == 7;
+	if (module != NULL)
+		module_config__free_unpacked(module, NULL);
+	return ok;
+}
+
+int main(void)
+{
+	if (mkdtemp(dir) == NULL)
+		return 1;
+	setenv("IPPC_CACHE_MAX", "0", 1);
+
+	const char *pipeline = write_file("pipeline.yaml",
+									  "- order: 1\n  param_id: 1\n  name: demosaic\n"
+									  "- order: 2\n  param_id: 2\n  name: encode\n");
+	const char *module = write_file("module.yaml",
+									"- key: distance\n  value: 0.5\n"
+									"- key: effort\n  value: 7\n");
+	const char *manifest = write_file("manifest.yaml",
+									  "- pipeline: 3\n  file: pipeline.yaml\n"
+									  "- module: 2\n  file: module.yaml\n  schema: encode\n");
+	const char *artifact = write_file("artifact.ippb", "");
+	ippc_compile_opts_t compile = {.schema = "encode"};
+	config_bundle_entry_t entries[CONFIG_BUNDLE_MAX_ENTRIES];
+
+	/* A single pipeline */
+	CHECK(ippc_compile(pipeline, artifact, 1, 0, &compile) == IPPC_OK);
+	CHECK(config_bundle_read(artifact, entries, CONFIG_BUNDLE_MAX_ENTRIES) == 1);
+	CHECK(check_pipeline(&entries[0], PIPELINE_PARAMID_OFFSET));
+
+	/* A single module, typed by its schema, tagged */
+	compile.tagged = 1;
+	CHECK(ippc_compile(module, artifact, 0, 4, &compile) == IPPC_OK);
+	CHECK(config_bundle_read(artifact, entries, CONFIG_BUNDLE_MAX_ENTRIES) == 1);
+	CHECK(check_module(&entries[0], MODULE_PARAMID_OFFSET + 3));
+
+	/* A manifest, in manifest order */
+	compile.schema = NULL;
+	CHECK(ippc_compile(manifest, artifact, 0, 0, &compile) == IPPC_OK);
+	CHECK(config_bundle_read(artifact, entries, CONFIG_BUNDLE_MAX_ENTRIES) == 2);
+	CHECK(check_pipeline(&entries[0], PIPELINE_PARAMID_OFFSET + 2));
+	CHECK(check_module(&entries[1], MODULE_PARAMID_OFFSET + 1));
+
+	/* Invalid indexes and schemas write nothing */
+	unlink(artifact);
+	CHECK(ippc_compile(pipeline, artifact, 1, 1, &compile) == IPPC_EINVAL);
+	CHECK(ippc_compile(pipeline, artifact, MAX_PIPELINES + 1, 0, &compile) == IPPC_EINVAL);
+	compile.schema = "missing";
+	CHECK(ippc_compile(module, artifact, 0, 1, &compile) == IPPC_EINVAL);
+	CHECK(access(artifact, F_OK) != 0);
+
+	unlink(pipeline);
+	unlink(module);
+	unlink(manifest);
+	rmdir(dir);
+	return TEST_RESULT();
+}
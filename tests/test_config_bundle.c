@@ -0,0 +1,89 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "config_bundle.h"
+#include "test.h"
+
+static char path[] = "/tmp/ippc_bundle_XXXXXX";
+
+static void write_entries(config_bundle_entry_t *entries, int count)
+{
+	for (int i = 0; i < count; i++)
+	{
+		entries[i].param_id = 10 + i;
+		entries[i].length = 5 + i;
+		for (int j = 0; j < entries[i].length; j++)
+			entries[i].data[j] = (uint8_t)(i * 31 + j);
+	}
+}
+
+/* Flip one bit of the byte at offset, or cut the file at offset */
+static void damage(long offset, int truncate_file)
+{
+	if (truncate_file)
+	{
+		CHECK(truncate(path, offset) == 0);
+		return;
+	}
+	FILE *file = fopen(path, "r+b");
+	fseek(file, offset, SEEK_SET);
+	int c = fgetc(file);
+	fseek(file, offset, SEEK_SET);
+	fputc(c ^ 0x01, file);
+	fclose(file);
+}
+
+int main(void)
+{
+	int fd = mkstemp(path);
+	if (fd < 0)
+		return 1;
+	close(fd);
+
+	config_bundle_entry_t entries[3];
+	config_bundle_entry_t read[CONFIG_BUNDLE_MAX_ENTRIES];
+	write_entries(entries, 3);
+
+	/* Round trip */
+	CHECK(config_bundle_write(path, entries, 3) == 0);
+	CHECK(config_bundle_read(path, read, CONFIG_BUNDLE_MAX_ENTRIES) == 3);
+	for (int i = 0; i < 3; i++)
+	{
+		CHECK(read[i].param_id == entries[i].param_id);
+		CHECK(read[i].length == entries[i].length);
+		CHECK(memcmp(read[i].data, entries[i].data, entries[i].length) == 0);
+	}
+
+	/* An empty bundle is valid */
+	CHECK(config_bundle_write(path, entries, 0) == 0);
+	CHECK(config_bundle_read(path, read, CONFIG_BUNDLE_MAX_ENTRIES) == 0);
+
+	/* More entries than the caller can hold */
+	CHECK(config_bundle_write(path, entries, 3) == 0);
+	CHECK(config_bundle_read(path, read, 2) == -1);
+
+	/* Corrupted data fails the checksum, header (6 bytes) + entry header (7 bytes) */
+	damage(6 + 7 + 2, 0);
+	CHECK(config_bundle_read(path, read, CONFIG_BUNDLE_MAX_ENTRIES) == -1);
+
+	/* Truncated inside the last entry */
+	CHECK(config_bundle_write(path, entries, 3) == 0);
+	damage(6 + 7 + 5 + 7 + 6 + 7 + 3, 1);
+	CHECK(config_bundle_read(path, read, CONFIG_BUNDLE_MAX_ENTRIES) == -1);
+
+	/* Bad magic and unsupported version */
+	CHECK(config_bundle_write(path, entries, 3) == 0);
+	damage(0, 0);
+	CHECK(config_bundle_read(path, read, CONFIG_BUNDLE_MAX_ENTRIES) == -1);
+	CHECK(config_bundle_write(path, entries, 3) == 0);
+	damage(4, 0);
+	CHECK(config_bundle_read(path, read, CONFIG_BUNDLE_MAX_ENTRIES) == -1);
+
+	/* Missing file */
+	unlink(path);
+	CHECK(config_bundle_read(path, read, CONFIG_BUNDLE_MAX_ENTRIES) == -1);
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,140 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "config_cache.h"
+#include "test.h"
+
+static char dir[] = "/tmp/ippc_cache_XXXXXX";
+
+/* Entries used within one filesystem clock tick would tie */
+static void tick(void)
+{
+	usleep(20000);
+}
+
+/* Legacy configuration buffer holding text as its brotli stream */
+static size_t entry(const char *text, uint8_t *buffer)
+{
+	buffer[0] = strlen(text);
+	memcpy(buffer + 1, text, buffer[0]);
+	return buffer[0] + 1;
+}
+
+static int put(uint64_t key, const char *text, const char *report)
+{
+	uint8_t buffer[64];
+	return config_cache_put(key, buffer, entry(text, buffer), report);
+}
+
+static int cached(uint64_t key, const char *expected)
+{
+	uint8_t buffer[64], stored[64];
+	int length = config_cache_get(key, buffer, sizeof(buffer), NULL, 0);
+	if (expected == NULL)
+		return length == -1;
+	return length == (int)entry(expected, stored) && memcmp(buffer, stored, length) == 0;
+}
+
+/* Overwrite the entry of key, as a corrupt or foreign file would */
+static void corrupt(uint64_t key, const void *data, size_t length)
+{
+	char path[sizeof(dir) + 32];
+	snprintf(path, sizeof(path), "%s/%016llx.ippc", dir, (unsigned long long)key);
+	FILE *fh = fopen(path, "wb");
+	fwrite(data, 1, length, fh);
+	fclose(fh);
+}
+
+static int exists(uint64_t key)
+{
+	char path[sizeof(dir) + 32];
+	snprintf(path, sizeof(path), "%s/%016llx.ippc", dir, (unsigned long long)key);
+	return access(path, F_OK) == 0;
+}
+
+int main(void)
+{
+	if (mkdtemp(dir) == NULL)
+		return 1;
+	setenv("IPPC_CACHE_DIR", dir, 1);
+	setenv("IPPC_CACHE_MAX", "2", 1);
+
+	/* Keys follow content and settings */
+	char config[sizeof(dir) + 16];
+	snprintf(config, sizeof(config), "%s/config.yaml", dir);
+	FILE *file = fopen(config, "w");
+	fputs("- key: effort\n  value: 7\n", file);
+	fclose(file);
+	uint64_t a, b, c, again;
+	CHECK(config_cache_key(config, "module tagged=0", &a) == 0);
+	CHECK(config_cache_key(config, "module tagged=0", &again) == 0 && again == a);
+	CHECK(config_cache_key(config, "module tagged=1", &b) == 0 && b != a);
+	CHECK(config_cache_key("/nonexistent/config.yaml", "module tagged=0", &again) == -1);
+	file = fopen(config, "a");
+	fputs("- key: distance\n  value: 1.0\n", file);
+	fclose(file);
+	CHECK(config_cache_key(config, "module tagged=0", &c) == 0 && c != a && c != b);
+	unlink(config);
+
+	/* Hits return the stored bytes */
+	CHECK(cached(a, NULL));
+	CHECK(put(a, "first", NULL) == 0);
+	tick();
+	CHECK(put(b, "second", NULL) == 0);
+	tick();
+	CHECK(cached(a, "first"));
+	CHECK(cached(b, "second"));
+
+	/* The least recently used entry is evicted, reading a marks it used */
+	tick();
+	CHECK(cached(a, "first"));
+	tick();
+	CHECK(put(c, "third", NULL) == 0);
+	CHECK(cached(a, "first"));
+	CHECK(cached(b, NULL));
+	CHECK(cached(c, "third"));
+
+	unsigned int hits, misses;
+	config_cache_stats(&hits, &misses);
+	CHECK(hits == 5 && misses == 2);
+
+	/* Reports are returned with the buffer */
+	char report[64];
+	uint8_t buffer[64];
+	CHECK(put(c, "third", "Compacted 2 keys") == 0);
+	CHECK(config_cache_get(c, buffer, sizeof(buffer), report, sizeof(report)) == 6 && strcmp(report, "Compacted 2 keys") == 0);
+	CHECK(put(c, "third", "two\nlines") == -1);
+	CHECK(put(c, "third", "") == 0);
+	CHECK(config_cache_get(c, buffer, sizeof(buffer), report, sizeof(report)) == 6 && report[0] == '\0');
+
+	/* Entries that are not a single well formed buffer miss and are removed */
+	corrupt(c, "\nthird", 6);
+	CHECK(cached(c, NULL) && !exists(c));
+	corrupt(c, "\n\x09" "third", 7);
+	CHECK(cached(c, NULL) && !exists(c));
+	corrupt(c, "\n\x04" "third", 7);
+	CHECK(cached(c, NULL) && !exists(c));
+	corrupt(c, "\n\xff\x02" "ab", 5);
+	CHECK(cached(c, NULL) && !exists(c));
+	corrupt(c, "\x05" "third", 6);
+	CHECK(cached(c, NULL) && !exists(c));
+	corrupt(c, "\n\xf1\x02" "ab", 5);
+	CHECK(config_cache_get(c, buffer, sizeof(buffer), NULL, 0) == 4 && exists(c));
+	CHECK(put(c, "third", NULL) == 0);
+	CHECK(cached(c, "third"));
+	config_cache_stats(&hits, &misses);
+	CHECK(hits == 9 && misses == 7);
+
+	/* A zero size disables the cache */
+	setenv("IPPC_CACHE_MAX", "0", 1);
+	CHECK(put(b, "second", NULL) == -1);
+	CHECK(cached(a, NULL));
+	setenv("IPPC_CACHE_MAX", "2", 1);
+
+	CHECK(config_cache_clear() == 2);
+	CHECK(cached(a, NULL));
+	rmdir(dir);
+	return TEST_RESULT();
+}
@@ -0,0 +1,91 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "config_codec.h"
+#include "ippc_params.h"
+#include "test.h"
+
+/* Encode into a data parameter sized buffer, decode it again and compare */
+static int round_trip(const uint8_t *packed, size_t packed_size, int tagged)
+{
+	uint8_t buffer[DATA_PARAM_SIZE] = {0};
+	size_t encoded_size = sizeof(buffer);
+	int encoding = config_encode(packed, packed_size, tagged, buffer, &encoded_size);
+	if (encoding < 0)
+		return -1;
+	if (config_buffer_size(buffer, sizeof(buffer)) != encoded_size)
+		return -1;
+
+	uint8_t decoded[1024];
+	size_t decoded_size = sizeof(decoded);
+	if (config_decode(buffer, sizeof(buffer), decoded, &decoded_size) != encoding)
+		return -1;
+	if (decoded_size != packed_size || memcmp(decoded, packed, packed_size) != 0)
+		return -1;
+	return encoding;
+}
+
+int main(void)
+{
+	/* Repetitive like packed configurations, so brotli pays off */
+	uint8_t packed[300];
+	for (size_t i = 0; i < sizeof(packed); i++)
+		packed[i] = "\x0a\x08" "distance" "\x25\x00\x00\x00\x3f"[i % 15];
+
+	/* Legacy buffers are always brotli */
+	CHECK(round_trip(packed, sizeof(packed), 0) == CONFIG_ENCODING_BROTLI);
+
+	/* Tagged buffers hold the smallest encoding, raw for tiny inputs */
+	int encoding = round_trip(packed, sizeof(packed), 1);
+	CHECK(encoding == CONFIG_ENCODING_BROTLI || encoding == CONFIG_ENCODING_BROTLI_DICT);
+	CHECK(round_trip((const uint8_t *)"\x08\x01", 2, 1) == CONFIG_ENCODING_RAW);
+
+	/* The best payload is never larger than plain brotli */
+	uint8_t best[512], plain[512];
+	size_t best_size = sizeof(best), plain_size = sizeof(plain);
+	CHECK(config_encode_payload(packed, sizeof(packed), 1, best, &best_size) >= 0);
+	CHECK(config_encode_payload(packed, sizeof(packed), 0, plain, &plain_size) == CONFIG_ENCODING_BROTLI);
+	CHECK(best_size <= plain_size);
+
+	/* Configurations that do not fit a parameter are rejected */
+	uint8_t noise[400];
+	uint32_t state = 1;
+	for (size_t i = 0; i < sizeof(noise); i++)
+	{
+		state = state * 1103515245 + 12345;
+		noise[i] = state >> 16;
+	}
+	uint8_t small[DATA_PARAM_SIZE];
+	size_t small_size = sizeof(small);
+	CHECK(config_encode(noise, sizeof(noise), 1, small, &small_size) < 0);
+
+	/* Malformed and empty buffers */
+	uint8_t empty[DATA_PARAM_SIZE] = {0};
+	uint8_t out[64];
+	size_t out_size = sizeof(out);
+	CHECK(config_buffer_size(empty, sizeof(empty)) == 0);
+	uint8_t truncated[4] = {CONFIG_HEADER_TAGGED | CONFIG_ENCODING_RAW, 10, 1, 2};
+	CHECK(config_decode(truncated, sizeof(truncated), out, &out_size) < 0);
+	CHECK(config_buffer_size(truncated, sizeof(truncated)) == 0);
+
+	/* Descriptors of vmem uploads cannot be decoded from the buffer alone */
+	uint8_t descriptor[DATA_PARAM_SIZE] = {0};
+	config_encode_vmem_descriptor(CONFIG_ENCODING_BROTLI, 0x1000, 512, 0xDEADBEEF, descriptor);
+	CHECK(config_buffer_size(descriptor, sizeof(descriptor)) == CONFIG_VMEM_DESCRIPTOR_SIZE);
+	out_size = sizeof(out);
+	CHECK(config_decode(descriptor, sizeof(descriptor), out, &out_size) < 0);
+
+	/* Descriptor fields round trip */
+	config_vmem_descriptor_t decoded;
+	CHECK(config_decode_vmem_descriptor(descriptor, sizeof(descriptor), &decoded) == 0);
+	CHECK(decoded.encoding == CONFIG_ENCODING_BROTLI);
+	CHECK(decoded.address == 0x1000);
+	CHECK(decoded.length == 512);
+	CHECK(decoded.crc == 0xDEADBEEF);
+	CHECK(config_decode_vmem_descriptor(empty, sizeof(empty), &decoded) < 0);
+
+	/* CRC32 check value */
+	CHECK(config_crc32((const uint8_t *)"123456789", 9) == 0xCBF43926);
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,89 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "config_loader.h"
+#include "test.h"
+
+static int load_pipeline(const char *yaml, PipelineDefinition *pipeline, config_arena_t *arena)
+{
+	return config_load_pipeline_string(yaml, strlen(yaml), arena, pipeline);
+}
+
+static int load_module(const char *yaml, ModuleConfig *module_config, const char *schema, config_arena_t *arena)
+{
+	return config_load_module_string(yaml, strlen(yaml), arena, module_config, schema);
+}
+
+/* Load a module configuration of a single key, returns its value case or -1 */
+static int module_type(const char *yaml, const char *schema)
+{
+	config_arena_t *arena = config_arena_create();
+	ModuleConfig module_config = MODULE_CONFIG__INIT;
+	int ret = load_module(yaml, &module_config, schema, arena);
+	if (ret == 0)
+		ret = module_config.n_parameters == 1 ? (int)module_config.parameters[0]->value_case : -1;
+	config_arena_destroy(arena);
+	return ret;
+}
+
+int main(void)
+{
+	config_arena_t *arena = config_arena_create();
+	CHECK(arena != NULL);
+
+	/* Pipelines */
+	PipelineDefinition pipeline = PIPELINE_DEFINITION__INIT;
+	CHECK(load_pipeline("- order: 1\n  param_id: 1\n  name: demosaic\n"
+						"- order: 2\n  param_id: 2\n  name: \"encode\"\n",
+						&pipeline, arena) == 0);
+	CHECK(pipeline.n_modules == 2);
+	CHECK(pipeline.modules[0]->order == 1 && pipeline.modules[0]->param_id == 1);
+	CHECK(strcmp(pipeline.modules[0]->name, "demosaic") == 0);
+	CHECK(strcmp(pipeline.modules[1]->name, "encode") == 0);
+
+	/* Orders must be sequential and param ids in range */
+	PipelineDefinition invalid = PIPELINE_DEFINITION__INIT;
+	CHECK(load_pipeline("- order: 2\n  param_id: 1\n  name: demosaic\n", &invalid, arena) == -1);
+	CHECK(load_pipeline("- order: 1\n  param_id: 21\n  name: demosaic\n", &invalid, arena) == -1);
+	CHECK(load_pipeline("- order: one\n  param_id: 1\n  name: demosaic\n", &invalid, arena) == -1);
+	CHECK(load_pipeline("order: 1\n", &invalid, arena) == -1);
+	CHECK(load_pipeline("- order: [1, 2]\n", &invalid, arena) == -1);
+	CHECK(load_pipeline("- order: 1\n  name: \"demosaic\n", &invalid, arena) == -1);
+
+	/* Modules with explicit types */
+	ModuleConfig module_config = MODULE_CONFIG__INIT;
+	CHECK(load_module("- key: distance\n  type: 4\n  value: 0.5\n"
+					  "- key: effort\n  type: 3\n  value: 7\n"
+					  "- key: lossless\n  type: 2\n  value: true\n"
+					  "- key: mode\n  type: 5\n  value: fast\n",
+					  &module_config, NULL, arena) == 0);
+	CHECK(module_config.n_parameters == 4);
+	CHECK(strcmp(module_config.parameters[0]->key, "distance") == 0);
+	CHECK(module_config.parameters[0]->float_value == 0.5f);
+	CHECK(module_config.parameters[1]->int_value == 7);
+	CHECK(module_config.parameters[2]->bool_value == 1);
+	CHECK(strcmp(module_config.parameters[3]->string_value, "fast") == 0);
+
+	/* Schemas give the types, explicit types must agree */
+	CHECK(module_type("- key: distance\n  value: 1\n", "encode") == CONFIG_PARAMETER__VALUE_FLOAT_VALUE);
+	CHECK(module_type("- key: effort\n  value: 7\n", "encode") == CONFIG_PARAMETER__VALUE_INT_VALUE);
+	CHECK(module_type("- key: effort\n  type: 4\n  value: 7\n", "encode") == -1);
+	CHECK(module_type("- key: effort\n  value: 7\n", NULL) == -1);
+
+	/* Values must parse as their type */
+	CHECK(module_type("- key: effort\n  type: 3\n  value: 7.5\n", NULL) == -1);
+	CHECK(module_type("- key: effort\n  type: 3\n  value: 99999999999\n", NULL) == -1);
+	CHECK(module_type("- key: lossless\n  type: 2\n  value: yes\n", NULL) == -1);
+	CHECK(module_type("- key: effort\n  type: 3\n", NULL) == -1);
+
+	/* Missing files */
+	CHECK(config_load_pipeline("/nonexistent/pipeline.yaml", arena, &invalid) == -1);
+
+	/* Everything is released at once, also after errors */
+	for (int i = 0; i < 1000; i++)
+		CHECK(config_arena_alloc(arena, 1000) != NULL);
+	CHECK(strcmp(config_arena_strdup(arena, "demosaic"), "demosaic") == 0);
+	config_arena_destroy(arena);
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,66 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "config_loader.h"
+#include "test.h"
+
+static config_manifest_entry_t *entries;
+static size_t count;
+
+static int load(const char *yaml, config_arena_t *arena)
+{
+	entries = NULL;
+	count = 0;
+	return config_load_manifest_string(yaml, strlen(yaml), arena, &entries, &count);
+}
+
+int main(void)
+{
+	config_arena_t *arena = config_arena_create();
+
+	/* A sequence of file entries */
+	CHECK(load("- pipeline: 1\n  file: pipeline.yaml\n"
+			   "- module: 2\n  file: /etc/ippc/module.yaml\n  schema: encode\n",
+			   arena) == 0);
+	CHECK(count == 2);
+	CHECK(entries[0].pipeline_id == 1 && entries[0].module_id == 0);
+	CHECK(strcmp(entries[0].file, "pipeline.yaml") == 0 && entries[0].pipeline == NULL);
+	CHECK(entries[1].module_id == 2 && strcmp(entries[1].schema, "encode") == 0);
+	CHECK(strcmp(entries[1].file, "/etc/ippc/module.yaml") == 0);
+
+	/* One document per entry with inline configurations, the schema may follow the parameters */
+	CHECK(load("---\npipeline: 1\nmodules:\n"
+			   "  - order: 1\n    name: demosaic\n    param_id: 1\n"
+			   "  - order: 2\n    name: encode\n    param_id: 2\n"
+			   "---\nmodule: 2\nparameters:\n"
+			   "  - key: distance\n    value: 1\n"
+			   "  - key: effort\n    value: 7\n"
+			   "schema: encode\n",
+			   arena) == 0);
+	CHECK(count == 2);
+	CHECK(entries[0].file == NULL && entries[0].pipeline != NULL);
+	CHECK(entries[0].pipeline->n_modules == 2 && strcmp(entries[0].pipeline->modules[1]->name, "encode") == 0);
+	CHECK(entries[1].module_config != NULL && entries[1].module_config->n_parameters == 2);
+	CHECK(entries[1].module_config->parameters[0]->value_case == CONFIG_PARAMETER__VALUE_FLOAT_VALUE);
+	CHECK(entries[1].module_config->parameters[0]->float_value == 1.0f);
+	CHECK(entries[1].module_config->parameters[1]->int_value == 7);
+
+	/* Documents holding sequences and single entries mix */
+	CHECK(load("---\n- pipeline: 1\n  file: a.yaml\n- pipeline: 2\n  file: b.yaml\n"
+			   "---\nmodule: 3\nfile: c.yaml\n",
+			   arena) == 0);
+	CHECK(count == 3 && entries[2].module_id == 3 && strcmp(entries[1].file, "b.yaml") == 0);
+
+	/* Entries need one id and one source */
+	CHECK(load("- pipeline: 1\n", arena) == -1);
+	CHECK(load("- pipeline: 1\n  module: 2\n  file: a.yaml\n", arena) == -1);
+	CHECK(load("- module: 2\n  file: a.yaml\n  parameters:\n    - key: effort\n      type: 3\n      value: 7\n", arena) == -1);
+	CHECK(load("- module: 2\n  modules:\n    - order: 1\n      name: demosaic\n      param_id: 1\n", arena) == -1);
+	CHECK(load("- pipeline: 7\n  file: a.yaml\n", arena) == -1);
+	CHECK(load("- module: 2\n  file: a.yaml\n  schema: unknown\n", arena) == -1);
+	CHECK(load("- module: 2\n  parameters:\n    - key: effort\n      value: 7\n", arena) == -1);
+	CHECK(load("- pipeline: 1\n  path: a.yaml\n", arena) == -1);
+
+	config_arena_destroy(arena);
+	return TEST_RESULT();
+}
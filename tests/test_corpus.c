@@ -0,0 +1,146 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <jxl/decode.h>
+
+#include "corpus.h"
+#include "metadata.pb-c.h"
+#include "test.h"
+
+/* Split a ring entry into its metadata and payload, as ippb does */
+static Metadata *read_entry(const uint8_t *entry, size_t size, const uint8_t **payload)
+{
+	uint32_t metadata_size;
+	if (size < sizeof(uint32_t))
+		return NULL;
+	memcpy(&metadata_size, entry, sizeof(uint32_t));
+	if (metadata_size > size - sizeof(uint32_t))
+		return NULL;
+	Metadata *meta = metadata__unpack(NULL, metadata_size, entry + sizeof(uint32_t));
+	if (meta != NULL && (size_t)meta->size != size - sizeof(uint32_t) - metadata_size)
+	{
+		metadata__free_unpacked(meta, NULL);
+		return NULL;
+	}
+	*payload = entry + sizeof(uint32_t) + metadata_size;
+	return meta;
+}
+
+static const char *item_string(const Metadata *meta, const char *key)
+{
+	for (size_t i = 0; i < meta->n_items; i++)
+	{
+		if (strcmp(meta->items[i]->key, key) == 0 && meta->items[i]->value_case == METADATA_ITEM__VALUE_STRING_VALUE)
+			return meta->items[i]->string_value;
+	}
+	return NULL;
+}
+
+/* Decode a JXL payload to 8 bit pixels */
+static uint8_t *decode_jxl(const uint8_t *data, size_t size, int channels, size_t *pixels_size)
+{
+	JxlDecoder *decoder = JxlDecoderCreate(NULL);
+	JxlPixelFormat format = {channels, JXL_TYPE_UINT8, JXL_NATIVE_ENDIAN, 0};
+	uint8_t *pixels = NULL;
+	int done = 0;
+	if (decoder == NULL || JxlDecoderSubscribeEvents(decoder, JXL_DEC_FULL_IMAGE) != JXL_DEC_SUCCESS ||
+		JxlDecoderSetInput(decoder, data, size) != JXL_DEC_SUCCESS)
+	{
+		JxlDecoderDestroy(decoder);
+		return NULL;
+	}
+	JxlDecoderCloseInput(decoder);
+	while (!done)
+	{
+		JxlDecoderStatus status = JxlDecoderProcessInput(decoder);
+		if (status == JXL_DEC_NEED_IMAGE_OUT_BUFFER && pixels == NULL &&
+			JxlDecoderImageOutBufferSize(decoder, &format, pixels_size) == JXL_DEC_SUCCESS)
+		{
+			pixels = malloc(*pixels_size);
+			if (pixels == NULL || JxlDecoderSetImageOutBuffer(decoder, &format, pixels, *pixels_size) != JXL_DEC_SUCCESS)
+				break;
+		}
+		else if (status == JXL_DEC_FULL_IMAGE || status == JXL_DEC_SUCCESS)
+			done = 1;
+		else
+			break;
+	}
+	JxlDecoderDestroy(decoder);
+	if (!done)
+	{
+		free(pixels);
+		return NULL;
+	}
+	return pixels;
+}
+
+int main(void)
+{
+	corpus_spec_t spec = {.width = 64, .height = 48, .channels = 3, .bits_pixel = 8, .camera = "vis", .timestamp = 1700000000};
+
+	/* The same seed gives the same frame, another seed another one */
+	size_t size, again_size, other_size;
+	uint8_t *pixels = corpus_pixels(&spec, 7, &size);
+	uint8_t *again = corpus_pixels(&spec, 7, &again_size);
+	uint8_t *other = corpus_pixels(&spec, 8, &other_size);
+	CHECK(size == 64 * 48 * 3 && again_size == size && other_size == size);
+	CHECK(memcmp(pixels, again, size) == 0);
+	CHECK(memcmp(pixels, other, size) != 0);
+	free(again);
+	free(other);
+
+	/* Frames are smooth, neighbouring pixels are close */
+	int steps = 0;
+	for (size_t i = 3; i < size; i += 3)
+		steps += abs(pixels[i] - pixels[i - 3]) > 32;
+	CHECK(steps < 64 * 48 / 10);
+
+	/* 16 bit samples stay within their bits */
+	corpus_spec_t deep = spec;
+	deep.bits_pixel = 12;
+	deep.channels = 1;
+	uint8_t *deep_pixels = corpus_pixels(&deep, 7, &other_size);
+	CHECK(other_size == 64 * 48 * 2);
+	int in_range = 1;
+	for (size_t i = 0; i < other_size / 2; i++)
+		in_range &= ((uint16_t *)deep_pixels)[i] < 4096;
+	CHECK(in_range);
+	free(deep_pixels);
+
+	/* Raw entries hold the pixels after the metadata */
+	const uint8_t *payload;
+	uint8_t *entry = corpus_entry(&spec, 7, &size);
+	Metadata *meta = entry != NULL ? read_entry(entry, size, &payload) : NULL;
+	CHECK(meta != NULL);
+	if (meta != NULL)
+	{
+		CHECK(meta->width == 64 && meta->height == 48 && meta->channels == 3 && meta->bits_pixel == 8);
+		CHECK(meta->timestamp == 1700000000 && strcmp(meta->camera, "vis") == 0);
+		CHECK(meta->size == 64 * 48 * 3 && memcmp(payload, pixels, meta->size) == 0);
+		CHECK(item_string(meta, "enc") == NULL);
+		metadata__free_unpacked(meta, NULL);
+	}
+	free(entry);
+
+	/* Lossless JXL entries decode back to the generated pixels */
+	spec.jxl = 1;
+	spec.camera = NULL;
+	entry = corpus_entry(&spec, 7, &size);
+	meta = entry != NULL ? read_entry(entry, size, &payload) : NULL;
+	CHECK(meta != NULL);
+	if (meta != NULL)
+	{
+		CHECK(strcmp(meta->camera, "synthetic") == 0);
+		CHECK(item_string(meta, "enc") != NULL && strcmp(item_string(meta, "enc"), "jxl") == 0);
+		CHECK(meta->size < 64 * 48 * 3);
+		size_t decoded_size = 0;
+		uint8_t *decoded = decode_jxl(payload, meta->size, 3, &decoded_size);
+		CHECK(decoded != NULL && decoded_size == 64 * 48 * 3 && memcmp(decoded, pixels, decoded_size) == 0);
+		free(decoded);
+		metadata__free_unpacked(meta, NULL);
+	}
+	free(entry);
+	free(pixels);
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,90 @@
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "ippc.h"
+#include "fleet.h"
+#include "test.h"
+
+/* Nodes fail their first (node % 10) attempts */
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static int calls[FLEET_MAX_NODES];
+
+static int flaky_task(unsigned int node, void *arg)
+{
+	const unsigned int *nodes = arg;
+	int index = 0;
+	while (nodes[index] != node)
+		index++;
+	pthread_mutex_lock(&lock);
+	int call = calls[index]++;
+	pthread_mutex_unlock(&lock);
+	return call < (int)(node % 10) ? -1 : node % 2 == 0 ? FLEET_PUSHED : FLEET_UNCHANGED;
+}
+
+/* Nodes wait until every node is in flight, which only happens if their transfers overlap */
+static pthread_cond_t arrived = PTHREAD_COND_INITIALIZER;
+static int in_flight = 0;
+static int overlap_count = 0;
+
+static int overlap_task(unsigned int node, void *arg)
+{
+	struct timespec deadline;
+	clock_gettime(CLOCK_REALTIME, &deadline);
+	deadline.tv_sec += 5;
+
+	pthread_mutex_lock(&lock);
+	in_flight++;
+	pthread_cond_broadcast(&arrived);
+	int ret = FLEET_PUSHED;
+	while (in_flight < overlap_count && ret == FLEET_PUSHED)
+		ret = pthread_cond_timedwait(&arrived, &lock, &deadline) == 0 ? FLEET_PUSHED : -1;
+	pthread_mutex_unlock(&lock);
+	return ret;
+}
+
+int main(void)
+{
+	unsigned int nodes[FLEET_MAX_NODES];
+
+	/* Node lists */
+	CHECK(fleet_parse_nodes("162", nodes) == 1 && nodes[0] == 162);
+	CHECK(fleet_parse_nodes("162,163,0x10", nodes) == 3 && nodes[1] == 163 && nodes[2] == 16);
+	CHECK(fleet_parse_nodes("", nodes) == -1);
+	CHECK(fleet_parse_nodes("162,,163", nodes) == -1);
+	CHECK(fleet_parse_nodes("162;163", nodes) == -1);
+	CHECK(fleet_parse_nodes("16384", nodes) == -1);
+	CHECK(fleet_parse_nodes("-1", nodes) == -1);
+	char list[4 * (FLEET_MAX_NODES + 1)] = "";
+	for (int i = 0; i <= FLEET_MAX_NODES; i++)
+		snprintf(list + strlen(list), sizeof(list) - strlen(list), "%s%d", i > 0 ? "," : "", 100 + i);
+	CHECK(fleet_parse_nodes(list, nodes) == -1);
+
+	/* -n and -N are exclusive */
+	CHECK(ippc_resolve_nodes(NULL, 162, 0, nodes) == 1 && nodes[0] == 162);
+	CHECK(ippc_resolve_nodes(NULL, 162, 1, nodes) == 1 && nodes[0] == 162);
+	CHECK(ippc_resolve_nodes("163,164", 162, 0, nodes) == 2 && nodes[0] == 163);
+	CHECK(ippc_resolve_nodes("163,164", 162, 1, nodes) == -1);
+
+	/* Every node is retried until it succeeds or runs out of retries */
+	int count = fleet_parse_nodes("10,21,32,43", nodes);
+	fleet_result_t results[FLEET_MAX_NODES];
+	CHECK(fleet_run(nodes, count, 2, flaky_task, nodes, results) == 1);
+	CHECK(results[0].node == 10 && results[0].result == FLEET_PUSHED && results[0].attempts == 1);
+	CHECK(results[1].result == FLEET_UNCHANGED && results[1].attempts == 2);
+	CHECK(results[2].result == FLEET_PUSHED && results[2].attempts == 3);
+	CHECK(results[3].result < 0 && results[3].attempts == 3);
+
+	/* Nodes do not take turns, all of them are in flight at once */
+	unsigned int fleet[FLEET_MAX_NODES];
+	overlap_count = fleet_parse_nodes("162,163,164,165,166,167,168,169", fleet);
+	CHECK(fleet_run(fleet, overlap_count, 0, overlap_task, NULL, results) == 0);
+	CHECK(in_flight == overlap_count);
+
+	/* A single node runs on the calling thread */
+	memset(calls, 0, sizeof(calls));
+	CHECK(fleet_run(nodes, 1, 0, flaky_task, nodes, results) == 0 && results[0].attempts == 1);
+
+	return TEST_RESULT();
+}
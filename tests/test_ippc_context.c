@@ -0,0 +1,39 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "ippc.h"
+#include "ippc_context.h"
+#include "test.h"
+
+int main(void)
+{
+	ippc_t *ippc = ippc_init();
+	CHECK(ippc != NULL);
+	if (ippc == NULL)
+		return TEST_RESULT();
+
+	/* Buffers given back stay in the context for the next command */
+	uint8_t *buffer = ring_buffer_take(&ippc->buffers);
+	CHECK(buffer != NULL);
+	ring_buffer_give(&ippc->buffers, buffer, 1);
+	CHECK(ippc->buffers.count == 1);
+	CHECK(ring_buffer_take(&ippc->buffers) == buffer);
+	ring_buffer_give(&ippc->buffers, buffer, 1);
+
+	/* Invalid downloads fail before touching a node, with or without a context */
+	unsigned int node = 162;
+	ippc_download_opts_t opts = {.timeout = 100, .per_node = 1, .per_link = 1};
+	CHECK(ippc_buffer_get(ippc, 0, 0, 0, &node, 1, &opts) == IPPC_EINVAL);
+	CHECK(ippc_buffer_get(NULL, 0, 0, 0, &node, 1, &opts) == IPPC_EINVAL);
+	opts.where = "width ==";
+	CHECK(ippc_buffer_get(ippc, 0, 0, 1, &node, 1, &opts) == IPPC_EINVAL);
+	CHECK(ippc_buffer_get_async(ippc, "get", 0, 0, 1, &node, 1, &opts) == -1);
+	opts.where = NULL;
+	opts.rings = "a,b,c,d,e,f,g,h,i";
+	CHECK(ippc_buffer_sync(ippc, "/nonexistent/cursor", 1, &node, 1, &opts) == IPPC_EINVAL);
+	CHECK(ippc->buffers.count == 1);
+
+	ippc_cleanup(ippc);
+	ippc_cleanup(NULL);
+	return TEST_RESULT();
+}
@@ -0,0 +1,145 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "ippc.h"
+#include "profile.h"
+#include "link_stats.h"
+#include "test.h"
+
+#define FAKE_ENTRIES 4
+
+/* Fake downloads, which block until released and record the order they ran in */
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t changed = PTHREAD_COND_INITIALIZER;
+static int open_gate = 0;
+static int started[IPPC_JOB_MAX + 8];
+static int start_count = 0;
+static int released = 0;
+
+typedef struct
+{
+	int number;
+	int result;
+} fake_job_t;
+
+static int fake_download(ippc_progress_t *progress, void *arg)
+{
+	fake_job_t *job = arg;
+	pthread_mutex_lock(&lock);
+	started[start_count++] = job->number;
+	pthread_cond_broadcast(&changed);
+	while (!open_gate && !progress->cancel)
+		pthread_cond_wait(&changed, &lock);
+	pthread_mutex_unlock(&lock);
+
+	/* Jobs never show up in the profile of the foreground command */
+	profile_end(PROFILE_DOWNLOAD, profile_start(), 1000);
+	link_stats_record(LINK_DOWNLOAD, 162, 1000000, 1000, 0);
+
+	ippc_progress_begin(progress, FAKE_ENTRIES);
+	for (int i = 1; i <= FAKE_ENTRIES && !progress->cancel; i++)
+		ippc_progress_update(progress, i, i * 1000);
+	return job->result;
+}
+
+static void fake_release(void *arg)
+{
+	free(arg);
+	pthread_mutex_lock(&lock);
+	released++;
+	pthread_cond_broadcast(&changed);
+	pthread_mutex_unlock(&lock);
+}
+
+static int submit(int number, int result)
+{
+	fake_job_t *job = malloc(sizeof(fake_job_t));
+	job->number = number;
+	job->result = result;
+	int id = ippc_job_submit("fake", fake_download, job, fake_release);
+	if (id < 0)
+		free(job);
+	return id;
+}
+
+static void wait_for(int *counter, int value)
+{
+	pthread_mutex_lock(&lock);
+	while (*counter < value)
+		pthread_cond_wait(&changed, &lock);
+	pthread_mutex_unlock(&lock);
+}
+
+int main(void)
+{
+	char stats[] = "/tmp/ippc_jobs_XXXXXX";
+	int fd = mkstemp(stats);
+	close(fd);
+	setenv("IPPC_STATS", stats, 1);
+
+	/* A foreground command profiled through the environment */
+	setenv("IPPC_PROFILE", "1", 1);
+	profile_reset();
+	CHECK(profile_enabled());
+
+	/* Workers take the oldest jobs, the others wait in order */
+	int first = submit(1, IPPC_OK);
+	int second = submit(2, IPPC_EIO);
+	int third = submit(3, IPPC_OK);
+	int fourth = submit(4, IPPC_OK);
+	CHECK(first > 0 && second == first + 1 && third == first + 2 && fourth == first + 3);
+	wait_for(&start_count, IPPC_JOB_WORKERS);
+	CHECK(start_count == IPPC_JOB_WORKERS && started[0] + started[1] == 3);
+
+	/* Queued jobs are cancelled at once, running ones stop early */
+	CHECK(ippc_job_cancel(fourth) == IPPC_OK);
+	wait_for(&released, 1);
+	CHECK(ippc_job_cancel(fourth) == IPPC_EINVAL);
+	CHECK(ippc_job_cancel(9999) == IPPC_EINVAL);
+	CHECK(ippc_job_cancel(first) == IPPC_OK);
+	wait_for(&start_count, 3);
+	CHECK(started[2] == 3);
+
+	/* The queue is bounded by the finished jobs it keeps */
+	int ids[IPPC_JOB_MAX];
+	int queued = 0;
+	while (queued < IPPC_JOB_MAX && (ids[queued] = submit(10 + queued, IPPC_OK)) > 0)
+		queued++;
+	CHECK(queued > 0 && queued < IPPC_JOB_MAX);
+	CHECK(submit(99, IPPC_OK) == -1);
+
+	pthread_mutex_lock(&lock);
+	open_gate = 1;
+	pthread_cond_broadcast(&changed);
+	pthread_mutex_unlock(&lock);
+	wait_for(&released, 4 + queued);
+	CHECK(start_count == 3 + queued);
+	int in_order = 1;
+	for (int i = 1; i < queued; i++)
+		in_order &= started[3 + i] > started[2 + i];
+	CHECK(in_order);
+	ippc_jobs_print();
+
+	/* The environment did not reach the jobs, while the foreground still profiles */
+	unsigned int calls;
+	uint64_t ns, bytes;
+	profile_totals(PROFILE_DOWNLOAD, &calls, &ns, &bytes);
+	CHECK(calls == 0);
+	profile_end(PROFILE_DOWNLOAD, profile_start(), 10);
+	profile_totals(PROFILE_DOWNLOAD, &calls, &ns, &bytes);
+	CHECK(calls == 1);
+
+	/* Jobs persist their transfers before they are released */
+	link_stats_set_t *set = malloc(sizeof(link_stats_set_t));
+	CHECK(link_stats_load(stats, set) == 0);
+	CHECK(set->count == 1 && set->nodes[0].kinds[LINK_DOWNLOAD].count == 2 + 1 + queued);
+	free(set);
+
+	remove(stats);
+	char lock_path[sizeof(stats) + 8];
+	snprintf(lock_path, sizeof(lock_path), "%s.lock", stats);
+	remove(lock_path);
+	return TEST_RESULT();
+}
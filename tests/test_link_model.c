@@ -0,0 +1,37 @@
+#include <stdio.h>
+
+#include "link_model.h"
+#include "test.h"
+
+#define MS 1000000ULL
+
+int main(void)
+{
+	/* Latency alone delays every packet by the same time */
+	link_model_t latency = {.latency_ns = 50 * MS};
+	CHECK(link_model_send(&latency, 1000 * MS, 200) == 1050 * MS);
+	CHECK(link_model_send(&latency, 1000 * MS, 200) == 1050 * MS);
+	CHECK(link_model_send(&latency, 1001 * MS, 0) == 1051 * MS);
+
+	/* Packets sent together queue behind each other */
+	link_model_t radio = {.latency_ns = 10 * MS, .bandwidth = 100000};
+	CHECK(link_model_send(&radio, 1000 * MS, 200) == 1012 * MS);
+	CHECK(link_model_send(&radio, 1000 * MS, 200) == 1014 * MS);
+	CHECK(link_model_send(&radio, 1001 * MS, 100) == 1015 * MS);
+
+	/* An idle line does not bank time for later packets */
+	CHECK(link_model_send(&radio, 2000 * MS, 100) == 2011 * MS);
+
+	/* Throughput over many packets follows the bandwidth */
+	link_model_t line = {.bandwidth = 1000000};
+	uint64_t arrival = 0;
+	for (int i = 0; i < 1000; i++)
+		arrival = link_model_send(&line, 0, 256);
+	CHECK(arrival == 256 * MS);
+
+	/* Unlimited and undelayed packets arrive when sent */
+	link_model_t loopback = {0};
+	CHECK(link_model_send(&loopback, 5 * MS, 4096) == 5 * MS);
+
+	return TEST_RESULT();
+}
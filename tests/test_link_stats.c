@@ -0,0 +1,120 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "fleet.h"
+#include "link_stats.h"
+#include "test.h"
+
+#define PROCESSES 8
+#define TRANSFERS 50
+
+/* Fails the first attempt with a vmem upload and the second with a push */
+static int upload_then_push(unsigned int node, void *arg)
+{
+	int *attempt = arg;
+	switch ((*attempt)++)
+	{
+	case 0:
+		link_stats_record(LINK_UPLOAD, node, 1000000, 0, 1);
+		return -1;
+	case 1:
+		link_stats_record(LINK_UPLOAD, node, 1000000, 4096, 0);
+		link_stats_record(LINK_PUSH, node, 1000000, 0, 1);
+		return -1;
+	default:
+		link_stats_record(LINK_PUSH, node, 1000000, 188, 0);
+		return FLEET_PUSHED;
+	}
+}
+
+/* A failure outside of a transfer is not a link retry */
+static int local_failure(unsigned int node, void *arg)
+{
+	int *attempt = arg;
+	return (*attempt)++ == 0 ? -1 : FLEET_UNCHANGED;
+}
+
+int main(void)
+{
+	char dir[] = "/tmp/ippc_stats_XXXXXX";
+	CHECK(mkdtemp(dir) != NULL);
+	char path[64];
+	snprintf(path, sizeof(path), "%s/stats.txt", dir);
+	setenv("IPPC_STATS", path, 1);
+	link_stats_set_t *set = malloc(sizeof(link_stats_set_t));
+
+	/* Flushing adds the session, histogram buckets are upper bounds in ms */
+	CHECK(link_stats_flush() == 0);
+	CHECK(access(path, F_OK) != 0);
+	link_stats_record(LINK_DOWNLOAD, 162, 1000000, 100, 0);
+	link_stats_record(LINK_DOWNLOAD, 162, 3000000, 300, 0);
+	link_stats_record(LINK_DOWNLOAD, 162, 0, 0, 1);
+	CHECK(link_stats_flush() == 0);
+	CHECK(link_stats_load(path, set) == 0 && set->count == 1);
+	const link_counter_t *download = &link_stats_get(set, 162)->kinds[LINK_DOWNLOAD];
+	CHECK(download->count == 2 && download->failures == 1 && download->bytes == 400);
+	CHECK(download->hist[0] == 1 && download->hist[2] == 1);
+	CHECK(link_stats_percentile(download, 0.5) == 1 && link_stats_percentile(download, 0.9) == 5);
+	CHECK(download->rate == 100000 && download->last > 0);
+
+	/* Retries count against the transfer that failed the attempt */
+	unsigned int node = 163;
+	int attempt = 0;
+	fleet_result_t result;
+	CHECK(fleet_run(&node, 1, 2, upload_then_push, &attempt, &result) == 0);
+	CHECK(result.attempts == 3 && result.result == FLEET_PUSHED);
+	attempt = 0;
+	CHECK(fleet_run(&node, 1, 1, local_failure, &attempt, &result) == 0 && result.attempts == 2);
+	CHECK(link_stats_flush() == 0);
+	CHECK(link_stats_load(path, set) == 0 && set->count == 2);
+	const link_stats_t *stats = link_stats_get(set, 163);
+	CHECK(stats->kinds[LINK_UPLOAD].retries == 1 && stats->kinds[LINK_UPLOAD].failures == 1);
+	CHECK(stats->kinds[LINK_UPLOAD].count == 1 && stats->kinds[LINK_UPLOAD].bytes == 4096);
+	CHECK(stats->kinds[LINK_PUSH].retries == 1 && stats->kinds[LINK_PUSH].count == 1);
+	CHECK(stats->kinds[LINK_DOWNLOAD].retries == 0);
+
+	/* Commands flushing at the same time keep all of their transfers */
+	for (int i = 0; i < PROCESSES; i++)
+	{
+		if (fork() == 0)
+		{
+			for (int j = 0; j < TRANSFERS; j++)
+			{
+				link_stats_record(LINK_PUSH, 170 + i % 2, 1000000, 10, 0);
+				if (link_stats_flush() < 0)
+					_exit(1);
+			}
+			_exit(0);
+		}
+	}
+	int status;
+	int failed = 0;
+	while (wait(&status) > 0)
+		failed += !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+	CHECK(failed == 0);
+	CHECK(link_stats_load(path, set) == 0 && set->count == 4);
+	CHECK(link_stats_get(set, 170)->kinds[LINK_PUSH].count == PROCESSES / 2 * TRANSFERS);
+	CHECK(link_stats_get(set, 171)->kinds[LINK_PUSH].bytes == PROCESSES / 2 * TRANSFERS * 10);
+
+	/* Malformed files are refused rather than overwritten */
+	FILE *fh = fopen(path, "a");
+	fprintf(fh, "172 teleport 1 2 3\n");
+	fclose(fh);
+	CHECK(link_stats_load(path, set) == -1);
+	link_stats_record(LINK_PUSH, 172, 1000000, 10, 0);
+	CHECK(link_stats_flush() == -1);
+
+	CHECK(link_stats_clear(path) == 0);
+	CHECK(access(path, F_OK) != 0);
+	CHECK(link_stats_clear(path) == 0);
+	CHECK(link_stats_load(path, set) == 0 && set->count == 0);
+
+	free(set);
+	char lock[80];
+	snprintf(lock, sizeof(lock), "%s.lock", path);
+	remove(lock);
+	rmdir(dir);
+	return TEST_RESULT();
+}
@@ -0,0 +1,94 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "metadata_filter.h"
+#include "test.h"
+
+/* Metadata of a jxl encoded visual observation */
+static MetadataItem enc = METADATA_ITEM__INIT;
+static MetadataItem gain = METADATA_ITEM__INIT;
+static MetadataItem flagged = METADATA_ITEM__INIT;
+static MetadataItem *items[] = {&enc, &gain, &flagged};
+
+static Metadata observation(void)
+{
+	enc.key = "enc";
+	enc.value_case = METADATA_ITEM__VALUE_STRING_VALUE;
+	enc.string_value = "jxl";
+	gain.key = "gain";
+	gain.value_case = METADATA_ITEM__VALUE_FLOAT_VALUE;
+	gain.float_value = 1.5f;
+	flagged.key = "flagged";
+	flagged.value_case = METADATA_ITEM__VALUE_BOOL_VALUE;
+	flagged.bool_value = 0;
+
+	Metadata meta = METADATA__INIT;
+	meta.size = 4096;
+	meta.width = 64;
+	meta.height = 32;
+	meta.channels = 3;
+	meta.timestamp = 1700000100;
+	meta.bits_pixel = 8;
+	meta.camera = "vis";
+	meta.n_items = sizeof(items) / sizeof(items[0]);
+	meta.items = items;
+	return meta;
+}
+
+static int matches(const char *expr, const Metadata *meta)
+{
+	metadata_filter_t *filter = metadata_filter_compile(expr);
+	if (filter == NULL)
+		return -1;
+	int ret = metadata_filter_match(filter, meta);
+	metadata_filter_free(filter);
+	return ret;
+}
+
+int main(void)
+{
+	Metadata meta = observation();
+
+	/* Fields and custom items */
+	CHECK(matches("camera == \"vis\"", &meta) == 1);
+	CHECK(matches("camera == 'nir'", &meta) == 0);
+	CHECK(matches("camera != \"nir\"", &meta) == 1);
+	CHECK(matches("width == 64 && height == 32", &meta) == 1);
+	CHECK(matches("timestamp > 1700000000", &meta) == 1);
+	CHECK(matches("timestamp >= 1700000100", &meta) == 1);
+	CHECK(matches("timestamp < 1700000100", &meta) == 0);
+	CHECK(matches("size <= 4096 && bits_pixel == 8", &meta) == 1);
+	CHECK(matches("enc == \"jxl\"", &meta) == 1);
+	CHECK(matches("gain > 1.25 && gain < 1.75", &meta) == 1);
+	CHECK(matches("flagged == false", &meta) == 1);
+
+	/* Precedence, negation and grouping */
+	CHECK(matches("camera == \"nir\" || width == 64 && height == 32", &meta) == 1);
+	CHECK(matches("(camera == \"nir\" || width == 64) && height == 1", &meta) == 0);
+	CHECK(matches("!(camera == \"nir\")", &meta) == 1);
+	CHECK(matches("!!channels", &meta) == 1);
+
+	/* Bare identifiers test for presence and non-zero values */
+	CHECK(matches("enc", &meta) == 1);
+	CHECK(matches("flagged", &meta) == 0);
+	CHECK(matches("missing", &meta) == 0);
+
+	/* Missing items and mismatched types never compare true */
+	CHECK(matches("missing == 0", &meta) == 0);
+	CHECK(matches("missing != 0", &meta) == 0);
+	CHECK(matches("camera == 1", &meta) == 0);
+	CHECK(matches("enc > 0", &meta) == 0);
+
+	/* Syntax errors */
+	CHECK(matches("", &meta) == -1);
+	CHECK(matches("camera ==", &meta) == -1);
+	CHECK(matches("camera == \"vis", &meta) == -1);
+	CHECK(matches("(width == 64", &meta) == -1);
+	CHECK(matches("width == 64 height", &meta) == -1);
+	CHECK(matches("width == 64 &&", &meta) == -1);
+
+	/* No filter matches everything */
+	CHECK(metadata_filter_match(NULL, &meta) == 1);
+
+	return TEST_RESULT();
+}
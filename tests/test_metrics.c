@@ -0,0 +1,148 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "metrics.h"
+#include "profile.h"
+#include "link_stats.h"
+#include "config_cache.h"
+#include "test.h"
+
+#define PROCESSES 8
+#define EXPORTS 20
+
+static char dir[] = "/tmp/ippc_metrics_XXXXXX";
+
+/* Value of the sample with the given name and labels, -1 when missing */
+static double sample(const char *path, const char *series)
+{
+	FILE *fh = fopen(path, "r");
+	if (fh == NULL)
+		return -1;
+	char line[256];
+	double value = -1;
+	size_t length = strlen(series);
+	while (fgets(line, sizeof(line), fh) != NULL)
+	{
+		if (strncmp(line, series, length) == 0 && line[length] == ' ')
+			value = strtod(line + length + 1, NULL);
+	}
+	fclose(fh);
+	return value;
+}
+
+static void cache_miss(void)
+{
+	uint8_t buffer[16];
+	config_cache_get(0x1234, buffer, sizeof(buffer), NULL, 0);
+}
+
+int main(void)
+{
+	if (mkdtemp(dir) == NULL)
+		return 1;
+	char path[64], stats[64];
+	snprintf(path, sizeof(path), "%s/ippc.prom", dir);
+	snprintf(stats, sizeof(stats), "%s/stats.txt", dir);
+	setenv("IPPC_STATS", stats, 1);
+	setenv("IPPC_CACHE_DIR", dir, 1);
+	unsetenv("IPPC_PROFILE");
+	unsetenv("IPPC_TRACE");
+
+	unsetenv("IPPC_METRICS");
+	CHECK(metrics_file() == NULL);
+	setenv("IPPC_METRICS", path, 1);
+	CHECK(strcmp(metrics_file(), path) == 0);
+
+	/* First export of a command */
+	profile_reset();
+	profile_collect();
+	profile_end(PROFILE_PNG_ENCODE, profile_start(), 1000);
+	link_stats_record(LINK_DOWNLOAD, 162, 3000000, 4096, 0);
+	link_stats_record(LINK_PUSH, 162, 0, 0, 1);
+	link_stats_retry(LINK_PUSH, 162);
+	CHECK(link_stats_flush() == 0);
+	cache_miss();
+	CHECK(metrics_write(path) == 0);
+
+	CHECK(sample(path, "ippc_phase_calls_total{phase=\"png_encode\"}") == 1);
+	CHECK(sample(path, "ippc_phase_bytes_total{phase=\"png_encode\"}") == 1000);
+	CHECK(sample(path, "ippc_phase_calls_total{phase=\"jxl_decode\"}") == 0);
+	CHECK(sample(path, "ippc_transfers_total{node=\"162\",kind=\"download\"}") == 1);
+	CHECK(sample(path, "ippc_transfer_bytes_total{node=\"162\",kind=\"download\"}") == 4096);
+	CHECK(sample(path, "ippc_transfer_failures_total{node=\"162\",kind=\"push\"}") == 1);
+	CHECK(sample(path, "ippc_transfer_retries_total{node=\"162\",kind=\"push\"}") == 1);
+	CHECK(sample(path, "ippc_transfers_total{node=\"162\",kind=\"upload\"}") == 0);
+	CHECK(sample(path, "ippc_config_cache_misses_total") == 1);
+	CHECK(sample(path, "ippc_config_cache_hits_total") == 0);
+
+	/* Histogram buckets are cumulative and end in +Inf */
+	CHECK(sample(path, "ippc_transfer_latency_seconds_bucket{node=\"162\",kind=\"download\",le=\"0.002\"}") == 0);
+	CHECK(sample(path, "ippc_transfer_latency_seconds_bucket{node=\"162\",kind=\"download\",le=\"0.005\"}") == 1);
+	CHECK(sample(path, "ippc_transfer_latency_seconds_bucket{node=\"162\",kind=\"download\",le=\"+Inf\"}") == 1);
+	CHECK(sample(path, "ippc_transfer_latency_seconds_count{node=\"162\",kind=\"download\"}") == 1);
+	CHECK(sample(path, "ippc_transfer_latency_seconds_sum{node=\"162\",kind=\"download\"}") == 0.003);
+
+	/* A later command adds to the phase and cache totals of the file */
+	profile_reset();
+	profile_collect();
+	profile_end(PROFILE_PNG_ENCODE, profile_start(), 500);
+	cache_miss();
+	CHECK(metrics_write(path) == 0);
+	CHECK(sample(path, "ippc_phase_calls_total{phase=\"png_encode\"}") == 2);
+	CHECK(sample(path, "ippc_phase_bytes_total{phase=\"png_encode\"}") == 1500);
+	CHECK(sample(path, "ippc_config_cache_misses_total") == 2);
+
+	/* Transfers come from the statistics file, not the metrics file */
+	CHECK(sample(path, "ippc_transfers_total{node=\"162\",kind=\"download\"}") == 1);
+
+	/* Exporting again without new work keeps the totals */
+	profile_reset();
+	CHECK(metrics_write(path) == 0);
+	CHECK(sample(path, "ippc_phase_calls_total{phase=\"png_encode\"}") == 2);
+	CHECK(sample(path, "ippc_config_cache_misses_total") == 2);
+
+	/* Commands exporting at the same time keep all of their counts */
+	for (int i = 0; i < PROCESSES; i++)
+	{
+		if (fork() == 0)
+		{
+			for (int j = 0; j < EXPORTS; j++)
+			{
+				profile_reset();
+				profile_collect();
+				profile_end(PROFILE_PNG_ENCODE, profile_start(), 1);
+				if (metrics_write(path) < 0)
+					_exit(1);
+			}
+			_exit(0);
+		}
+	}
+	int status;
+	int failed = 0;
+	while (wait(&status) > 0)
+		failed += !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+	CHECK(failed == 0);
+	CHECK(sample(path, "ippc_phase_calls_total{phase=\"png_encode\"}") == 2 + PROCESSES * EXPORTS);
+	CHECK(sample(path, "ippc_phase_bytes_total{phase=\"png_encode\"}") == 1500 + PROCESSES * EXPORTS);
+
+	/* An unreadable statistics file fails the export */
+	FILE *fh = fopen(stats, "a");
+	fputs("162 teleport 1\n", fh);
+	fclose(fh);
+	CHECK(metrics_write(path) == -1);
+	remove(stats);
+
+	CHECK(metrics_write("/nonexistent/ippc.prom") == -1);
+
+	remove(path);
+	char lock[80];
+	snprintf(lock, sizeof(lock), "%s.lock", stats);
+	remove(lock);
+	snprintf(lock, sizeof(lock), "%s.lock", path);
+	remove(lock);
+	rmdir(dir);
+	return TEST_RESULT();
+}
@@ -0,0 +1,41 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "module_schema.h"
+#include "test.h"
+
+int main(void)
+{
+	CHECK(module_schema_exists("encode"));
+	CHECK(!module_schema_exists("demosaic"));
+
+	/* Lookups by key and by id agree */
+	const module_schema_key_t *effort = module_schema_lookup("encode", "effort");
+	CHECK(effort != NULL);
+	if (effort != NULL)
+	{
+		CHECK(effort->id == 2);
+		CHECK(effort->type == CONFIG_PARAMETER__VALUE_INT_VALUE);
+		CHECK(strcmp(effort->compact_key, "2") == 0);
+		CHECK(module_schema_lookup_id("encode", 2) == effort);
+	}
+	CHECK(module_schema_lookup("encode", "unknown") == NULL);
+	CHECK(module_schema_lookup("demosaic", "effort") == NULL);
+	CHECK(module_schema_lookup_id("encode", 999) == NULL);
+
+	/* Known keys are compacted to their id, unknown keys are kept */
+	ConfigParameter distance = CONFIG_PARAMETER__INIT;
+	ConfigParameter custom = CONFIG_PARAMETER__INIT;
+	distance.key = "distance";
+	custom.key = "custom";
+	ConfigParameter *parameters[] = {&distance, &custom};
+	ModuleConfig module_config = MODULE_CONFIG__INIT;
+	module_config.n_parameters = 2;
+	module_config.parameters = parameters;
+
+	CHECK(module_schema_compact("encode", &module_config) == 1);
+	CHECK(strcmp(distance.key, "1") == 0);
+	CHECK(strcmp(custom.key, "custom") == 0);
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,45 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "png_encode.h"
+#include "test.h"
+
+static uint32_t be32(const uint8_t *data)
+{
+	return (uint32_t)data[0] << 24 | (uint32_t)data[1] << 16 | (uint32_t)data[2] << 8 | data[3];
+}
+
+/* Check the signature and the IHDR chunk of an encoded image */
+static int png_header(const uint8_t *png, int size, uint32_t width, uint32_t height, int color_type)
+{
+	static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+	return size > 33 && memcmp(png, signature, 8) == 0 && be32(png + 8) == 13 && memcmp(png + 12, "IHDR", 4) == 0 &&
+		   be32(png + 16) == width && be32(png + 20) == height && png[24] == 8 && png[25] == color_type;
+}
+
+int main(void)
+{
+	uint8_t pixels[64 * 32 * 3];
+	for (size_t i = 0; i < sizeof(pixels); i++)
+		pixels[i] = i % 251;
+
+	int size = 0;
+	uint8_t *png = png_encode(pixels, 64, 32, 3, &size);
+	CHECK(png != NULL && png_header(png, size, 64, 32, 2));
+	CHECK(png != NULL && memcmp(png + size - 8, "IEND", 4) == 0);
+	free(png);
+
+	/* Single channel frames are grayscale */
+	png = png_encode(pixels, 32, 16, 1, &size);
+	CHECK(png != NULL && png_header(png, size, 32, 16, 0));
+	free(png);
+
+	/* Smooth frames compress */
+	memset(pixels, 128, sizeof(pixels));
+	png = png_encode(pixels, 64, 32, 3, &size);
+	CHECK(png != NULL && size < (int)sizeof(pixels) / 10);
+	free(png);
+
+	return TEST_RESULT();
+}
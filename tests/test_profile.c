@@ -0,0 +1,71 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "profile.h"
+#include "test.h"
+
+#define THREADS 4
+#define CALLS 1000
+
+static void *record(void *arg)
+{
+	for (int i = 0; i < CALLS; i++)
+		profile_end(PROFILE_DOWNLOAD, profile_start(), 10);
+	return NULL;
+}
+
+int main(void)
+{
+	unsigned int calls;
+	uint64_t ns, bytes;
+	unsetenv("IPPC_PROFILE");
+	unsetenv("IPPC_TRACE");
+
+	/* Disabled phases record nothing */
+	profile_reset();
+	CHECK(!profile_enabled());
+	CHECK(profile_start() == 0);
+	profile_end(PROFILE_PARSE, 0, 100);
+	profile_totals(PROFILE_PARSE, &calls, &ns, &bytes);
+	CHECK(calls == 0 && bytes == 0);
+
+	/* Phases add up across threads */
+	profile_enable();
+	CHECK(profile_enabled());
+	pthread_t threads[THREADS];
+	for (int i = 0; i < THREADS; i++)
+		pthread_create(&threads[i], NULL, record, NULL);
+	for (int i = 0; i < THREADS; i++)
+		pthread_join(threads[i], NULL);
+	profile_totals(PROFILE_DOWNLOAD, &calls, &ns, &bytes);
+	CHECK(calls == THREADS * CALLS && bytes == THREADS * CALLS * 10);
+	CHECK(ns > 0);
+	profile_totals(PROFILE_PARSE, &calls, &ns, &bytes);
+	CHECK(calls == 0);
+
+	/* Reset clears the phases and turns profiling off again */
+	profile_reset();
+	profile_totals(PROFILE_DOWNLOAD, &calls, &ns, &bytes);
+	CHECK(calls == 0 && ns == 0 && bytes == 0);
+	CHECK(!profile_enabled() && profile_start() == 0);
+
+	/* Collecting records phases without enabling the report */
+	profile_collect();
+	CHECK(!profile_enabled());
+	profile_end(PROFILE_PUSH, profile_start(), 188);
+	profile_totals(PROFILE_PUSH, &calls, &ns, &bytes);
+	CHECK(calls == 1 && bytes == 188);
+
+	/* IPPC_PROFILE enables every command */
+	setenv("IPPC_PROFILE", "1", 1);
+	profile_reset();
+	CHECK(profile_enabled());
+	setenv("IPPC_PROFILE", "0", 1);
+	profile_reset();
+	CHECK(!profile_enabled());
+
+	for (int i = 0; i < PROFILE_PHASE_COUNT; i++)
+		CHECK(profile_phase_name(i) != NULL);
+	return TEST_RESULT();
+}
@@ -0,0 +1,128 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "profile.h"
+#include "test.h"
+
+#define NODE 5
+#define CALLS 3
+
+static void *download(void *arg)
+{
+	profile_set_node(NODE);
+	for (int i = 0; i < CALLS; i++)
+		profile_end(PROFILE_DOWNLOAD, profile_start(), 100);
+	return NULL;
+}
+
+static char *read_file(const char *filename)
+{
+	FILE *fh = fopen(filename, "r");
+	if (fh == NULL)
+		return NULL;
+	char *data = calloc(1, 65536);
+	if (data != NULL)
+		fread(data, 1, 65535, fh);
+	fclose(fh);
+	return data;
+}
+
+static int count(const char *data, const char *needle)
+{
+	int found = 0;
+	for (const char *at = strstr(data, needle); at != NULL; at = strstr(at + 1, needle))
+		found++;
+	return found;
+}
+
+/* Objects and arrays close in order, outside of strings */
+static int balanced(const char *data)
+{
+	char stack[16];
+	int depth = 0;
+	int string = 0;
+	for (const char *c = data; *c != '\0'; c++)
+	{
+		if (string)
+		{
+			if (*c == '\\' && c[1] != '\0')
+				c++;
+			else if (*c == '"')
+				string = 0;
+		}
+		else if (*c == '"')
+			string = 1;
+		else if (*c == '{' || *c == '[')
+		{
+			if (depth == sizeof(stack))
+				return 0;
+			stack[depth++] = *c == '{' ? '}' : ']';
+		}
+		else if (*c == '}' || *c == ']')
+		{
+			if (depth == 0 || stack[--depth] != *c)
+				return 0;
+		}
+	}
+	return depth == 0 && !string;
+}
+
+int main(void)
+{
+	char filename[] = "/tmp/ippc_trace_XXXXXX";
+	int fd = mkstemp(filename);
+	CHECK(fd >= 0);
+	close(fd);
+	unsetenv("IPPC_PROFILE");
+
+	/* IPPC_TRACE enables tracing on reset */
+	setenv("IPPC_TRACE", filename, 1);
+	profile_reset();
+	unsetenv("IPPC_TRACE");
+	CHECK(profile_start() != 0);
+
+	/* Local work on this thread, node work on two workers */
+	profile_end(PROFILE_PARSE, profile_start(), 10);
+	pthread_t workers[2];
+	for (int i = 0; i < 2; i++)
+		pthread_create(&workers[i], NULL, download, NULL);
+	for (int i = 0; i < 2; i++)
+		pthread_join(workers[i], NULL);
+
+	CHECK(profile_trace_write() == 0);
+	char *data = read_file(filename);
+	CHECK(data != NULL);
+	if (data != NULL)
+	{
+		CHECK(strncmp(data, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", 39) == 0);
+		CHECK(balanced(data));
+		CHECK(count(data, "\"ph\":\"X\"") == 1 + 2 * CALLS);
+		CHECK(count(data, "\"name\":\"yaml parse\"") == 1);
+		CHECK(count(data, "\"name\":\"ring download\"") == 2 * CALLS);
+		CHECK(count(data, "\"bytes\":100}") == 2 * CALLS);
+
+		/* Each process and worker is named once */
+		CHECK(count(data, "\"name\":\"process_name\"") == 2);
+		CHECK(count(data, "{\"name\":\"local\"}") == 1);
+		CHECK(count(data, "{\"name\":\"node 5\"}") == 1);
+		CHECK(count(data, "\"name\":\"thread_name\"") == 3);
+		CHECK(count(data, "\"pid\":5,") == 1 + 2 + 2 * CALLS);
+		free(data);
+	}
+
+	/* Writing frees the events, later writes are skipped */
+	remove(filename);
+	CHECK(profile_trace_write() == 0);
+	CHECK(access(filename, F_OK) != 0);
+
+	/* An unwritable trace file fails */
+	profile_trace("/nonexistent/trace.json");
+	profile_end(PROFILE_PARSE, profile_start(), 10);
+	CHECK(profile_trace_write() == -1);
+
+	profile_reset();
+	return TEST_RESULT();
+}
@@ -0,0 +1,99 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "ring_cursor.h"
+#include "test.h"
+
+static char path[] = "/tmp/ippc_cursors_XXXXXX";
+
+static void write_cursors(const char *content)
+{
+	FILE *file = fopen(path, "w");
+	fputs(content, file);
+	fclose(file);
+}
+
+int main(void)
+{
+	int fd = mkstemp(path);
+	if (fd < 0)
+		return 1;
+	close(fd);
+	unlink(path);
+
+	/* A missing file is an empty set */
+	ring_cursor_set_t *set = malloc(sizeof(ring_cursor_set_t));
+	CHECK(ring_cursor_load(path, set) == 0 && set->count == 0);
+
+	/* Cursors start at 0 and are found again by node and ring */
+	ring_cursor_t *images = ring_cursor_get(set, 162, "images");
+	CHECK(images != NULL && images->mark.timestamp == 0);
+	images->mark.timestamp = 1700000100;
+	ring_cursor_t *thumbs = ring_cursor_get(set, 162, "thumbs");
+	thumbs->mark.timestamp = 1700000050;
+	CHECK(ring_cursor_get(set, 163, "images") != images);
+	CHECK(ring_cursor_get(set, 162, "images") == images);
+	CHECK(set->count == 3);
+	CHECK(ring_cursor_get(set, 162, "a_ring_name_longer_than_the_limit") == NULL);
+
+	/* Entries of the same second are told apart by their hash */
+	uint8_t first[] = {1, 2, 3}, second[] = {1, 2, 4};
+	uint32_t a = ring_entry_hash(first, sizeof(first)), b = ring_entry_hash(second, sizeof(second));
+	CHECK(a != b && a == ring_entry_hash(first, sizeof(first)));
+	ring_mark_add(&images->mark, 1700000100, a);
+	CHECK(images->mark.timestamp == 1700000100 && images->mark.tie_count == 1);
+	CHECK(ring_mark_has(&images->mark, 1700000100, a) && !ring_mark_has(&images->mark, 1700000100, b));
+	CHECK(!ring_mark_has(&images->mark, 1700000101, a));
+	ring_mark_add(&images->mark, 1700000100, b);
+	ring_mark_add(&images->mark, 1700000100, a);
+	CHECK(images->mark.tie_count == 2);
+
+	/* A newer second restarts the mark, and marks hold a bounded number of entries */
+	ring_mark_t mark = {0};
+	ring_mark_add(&mark, 1700000050, a);
+	ring_mark_add(&mark, 1700000051, b);
+	CHECK(mark.timestamp == 1700000051 && mark.tie_count == 1 && !ring_mark_has(&mark, 1700000050, a));
+	for (uint32_t i = 0; i < 2 * RING_MARK_TIES; i++)
+		ring_mark_add(&mark, 1700000051, i);
+	CHECK(mark.tie_count == RING_MARK_TIES);
+
+	/* Round trip */
+	CHECK(ring_cursor_save(path, set) == 0);
+	CHECK(access(path, F_OK) == 0);
+	ring_cursor_set_t *loaded = malloc(sizeof(ring_cursor_set_t));
+	CHECK(ring_cursor_load(path, loaded) == 0 && loaded->count == 3);
+	CHECK(ring_cursor_get(loaded, 162, "images")->mark.timestamp == 1700000100);
+	CHECK(ring_cursor_get(loaded, 162, "thumbs")->mark.timestamp == 1700000050);
+	CHECK(ring_cursor_get(loaded, 163, "images")->mark.timestamp == 0);
+	ring_cursor_t *hashed = ring_cursor_get(loaded, 162, "images");
+	CHECK(hashed->mark.tie_count == 2 && ring_mark_has(&hashed->mark, 1700000100, a) && ring_mark_has(&hashed->mark, 1700000100, b));
+
+	/* Hashes follow the timestamp, malformed ones are rejected */
+	write_cursors("170 images 42 0000002a,ffffffff\n");
+	CHECK(ring_cursor_load(path, loaded) == 0 && loaded->cursors[0].mark.tie_count == 2);
+	CHECK(ring_mark_has(&loaded->cursors[0].mark, 42, 0xffffffff));
+	write_cursors("170 images 42 2a,zz\n");
+	CHECK(ring_cursor_load(path, loaded) == -1);
+	write_cursors("170 images 42 1ffffffff\n");
+	CHECK(ring_cursor_load(path, loaded) == -1);
+
+	/* Comments and blank lines are skipped, malformed lines rejected */
+	write_cursors("# node ring timestamp\n\n170 images 42\n");
+	CHECK(ring_cursor_load(path, loaded) == 0 && loaded->count == 1);
+	CHECK(loaded->cursors[0].node == 170 && loaded->cursors[0].mark.timestamp == 42 && loaded->cursors[0].mark.tie_count == 0);
+	write_cursors("170 images\n");
+	CHECK(ring_cursor_load(path, loaded) == -1);
+
+	/* The set is bounded */
+	for (int i = 0; i < RING_CURSOR_MAX; i++)
+		ring_cursor_get(set, 1000 + i, "images");
+	CHECK(set->count == RING_CURSOR_MAX);
+	CHECK(ring_cursor_get(set, 2000, "images") == NULL);
+
+	unlink(path);
+	free(set);
+	free(loaded);
+	return TEST_RESULT();
+}
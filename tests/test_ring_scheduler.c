@@ -0,0 +1,141 @@
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "ring_scheduler.h"
+#include "test.h"
+
+/* Entries of node n are n * 100 bytes plus the offset, offsets of 99 fail */
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static int active[4];
+static int most_active[4];
+static int total_active;
+static int most_total;
+static char order[64][16];
+static int order_count;
+
+static int fake_download(const ring_job_t *job, unsigned int timeout, uint8_t *buffer)
+{
+	pthread_mutex_lock(&lock);
+	active[job->node]++;
+	total_active++;
+	if (active[job->node] > most_active[job->node])
+		most_active[job->node] = active[job->node];
+	if (total_active > most_total)
+		most_total = total_active;
+	snprintf(order[order_count++ % 64], sizeof(order[0]), "%u/%s/%d", job->node, job->ring, job->offset);
+	pthread_mutex_unlock(&lock);
+
+	usleep(2000);
+	int size = job->offset == 99 ? -1 : (int)job->node * 100 + job->offset;
+	if (size > 0)
+		memset(buffer, job->offset, size);
+
+	pthread_mutex_lock(&lock);
+	active[job->node]--;
+	total_active--;
+	pthread_mutex_unlock(&lock);
+	return size;
+}
+
+/* Check the data of every entry, and reject entries of the ring "bad" */
+static int handler(const ring_job_t *job, uint8_t *data, int size, void *arg)
+{
+	int *handled = arg;
+	pthread_mutex_lock(&lock);
+	(*handled)++;
+	pthread_mutex_unlock(&lock);
+	if (size != (int)job->node * 100 + job->offset || data[size - 1] != (uint8_t)job->offset)
+		return -1;
+	return strcmp(job->ring, "bad") == 0 ? -1 : 0;
+}
+
+static int progress_calls;
+static void progress(int finished, uint64_t bytes, void *arg)
+{
+	progress_calls++;
+}
+
+static void add_jobs(ring_job_t *jobs, int *count, unsigned int node, const char *ring, int n)
+{
+	for (int i = 0; i < n; i++)
+		jobs[(*count)++] = (ring_job_t){.node = node, .ring = ring, .offset = i};
+}
+
+int main(void)
+{
+	ring_buffer_pool_t pool = RING_BUFFER_POOL_INIT;
+	ring_job_t jobs[64];
+	int count = 0;
+	add_jobs(jobs, &count, 1, "images", 8);
+	add_jobs(jobs, &count, 2, "images", 6);
+	add_jobs(jobs, &count, 2, "thumbs", 6);
+	add_jobs(jobs, &count, 3, "bad", 2);
+	jobs[count++] = (ring_job_t){.node = 3, .ring = "images", .offset = 99};
+
+	/* Concurrency stays within the limits and every job runs once */
+	int handled = 0;
+	ring_scheduler_config_t config = {
+		.per_node = 2,
+		.per_link = 4,
+		.handler = handler,
+		.progress = progress,
+		.arg = &handled,
+		.buffers = &pool,
+		.download = fake_download,
+	};
+	ring_scheduler_stats_t stats;
+	CHECK(ring_schedule(jobs, count, &config, &stats) == 3);
+	CHECK(stats.downloaded == count - 1 && stats.failed == 3);
+	CHECK(handled == count - 1 && progress_calls == count);
+	CHECK(order_count == count);
+	for (int n = 1; n <= 3; n++)
+		CHECK(most_active[n] <= 2);
+	CHECK(most_total <= 4 && most_total >= 2);
+	CHECK(jobs[0].size == 100 && jobs[count - 1].size == -1);
+
+	/* Buffers are kept for the next schedule */
+	CHECK(pool.count > 0 && pool.count <= 4);
+	int kept = pool.count;
+	uint8_t *buffer = ring_buffer_take(&pool);
+	CHECK(buffer == pool.free[kept - 1] && pool.count == kept - 1);
+	ring_buffer_give(&pool, buffer, 4);
+	CHECK(pool.count == kept);
+
+	/* Pools keep no more buffers than the workers of a schedule use */
+	buffer = ring_buffer_take(&pool);
+	ring_buffer_give(&pool, buffer, 1);
+	CHECK(pool.count == 1);
+	buffer = ring_buffer_take(&pool);
+	ring_buffer_give(&pool, buffer, 0);
+	CHECK(pool.count == 0);
+
+	/* One worker starts with the node with the most entries, each node in job order */
+	count = 0;
+	order_count = 0;
+	add_jobs(jobs, &count, 1, "images", 1);
+	add_jobs(jobs, &count, 2, "images", 3);
+	config.per_link = 1;
+	CHECK(ring_schedule(jobs, count, &config, NULL) == 0);
+	CHECK(strcmp(order[0], "2/images/0") == 0);
+	CHECK(strcmp(order[1], "2/images/1") == 0);
+	int last = strcmp(order[2], "1/images/0") == 0 ? 3 : 2;
+	CHECK(strcmp(order[last], "2/images/2") == 0);
+	CHECK(pool.count == 1);
+
+	/* Nothing starts once cancelled, and unstarted jobs count as failed */
+	volatile int cancel = 1;
+	config.cancel = &cancel;
+	order_count = 0;
+	CHECK(ring_schedule(jobs, count, &config, &stats) == count);
+	CHECK(order_count == 0 && stats.downloaded == 0);
+
+	/* No jobs */
+	config.cancel = NULL;
+	CHECK(ring_schedule(jobs, 0, &config, &stats) == 0);
+
+	ring_buffer_pool_clear(&pool);
+	CHECK(pool.count == 0);
+	return TEST_RESULT();
+}
@@ -0,0 +1,65 @@
+#include "cli_parse.h"
+
+static int is_blank(char c)
+{
+	return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+int cli_split_line(char *line, char **argv, int max)
+{
+	int argc = 0;
+	char *in = line;
+	while (1)
+	{
+		while (is_blank(*in))
+			in++;
+		if (*in == '\0' || *in == '#')
+			return argc;
+		if (argc == max - 1)
+			return -1;
+
+		/* Unquote in place */
+		char *out = in;
+		argv[argc++] = out;
+		char quote = '\0';
+		while (*in != '\0' && (quote != '\0' || !is_blank(*in)))
+		{
+			if (quote == '\0' && (*in == '"' || *in == '\''))
+				quote = *in++;
+			else if (*in == quote)
+			{
+				quote = '\0';
+				in++;
+			}
+			else
+				*out++ = *in++;
+		}
+		if (quote != '\0')
+			return -1;
+		int end = *in == '\0';
+		*out = '\0';
+		if (end)
+			return argc;
+		in++;
+	}
+}
+
+void cli_json_string(FILE *out, const char *str, size_t len)
+{
+	fputc('"', out);
+	for (size_t i = 0; i < len; i++)
+	{
+		unsigned char c = str[i];
+		if (c == '"' || c == '\\')
+			fprintf(out, "\\%c", c);
+		else if (c == '\n')
+			fputs("\\n", out);
+		else if (c == '\t')
+			fputs("\\t", out);
+		else if (c < 0x20)
+			fprintf(out, "\\u%04x", c);
+		else
+			fputc(c, out);
+	}
+	fputc('"', out);
+}
@@ -0,0 +1,21 @@
+#ifndef CLI_PARSE_H
+#define CLI_PARSE_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+/*
+ * Line splitting and JSON output of the standalone ippc executable.
+ */
+
+/*
+ * Split a line into at most max - 1 arguments at blanks, in place. Single or
+ * double quotes group words and # starts a comment. Returns the count or -1
+ * on an open quote or too many arguments.
+ */
+int cli_split_line(char *line, char **argv, int max);
+
+/* Write len bytes of str as a JSON string */
+void cli_json_string(FILE *out, const char *str, size_t len);
+
+#endif
@@ -0,0 +1,181 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <jxl/encode.h>
+
+#include "corpus.h"
+#include "metadata.pb-c.h"
+
+static uint64_t xorshift64(uint64_t *state)
+{
+	uint64_t x = *state;
+	x ^= x << 13;
+	x ^= x >> 7;
+	x ^= x << 17;
+	return *state = x;
+}
+
+uint8_t *corpus_pixels(const corpus_spec_t *spec, uint64_t seed, size_t *size)
+{
+	int bytes = spec->bits_pixel > 8 ? 2 : 1;
+	int max = (1 << spec->bits_pixel) - 1;
+	*size = (size_t)spec->width * spec->height * spec->channels * bytes;
+	uint8_t *pixels = malloc(*size);
+	if (pixels == NULL)
+		return NULL;
+
+	/* Zero is a fixed point of xorshift */
+	uint64_t state = seed * 0x9E3779B97F4A7C15ULL + 1;
+	int cx = xorshift64(&state) % spec->width;
+	int cy = xorshift64(&state) % spec->height;
+	int radius = spec->width / 8 + xorshift64(&state) % (spec->width / 4 + 1);
+	int phase = xorshift64(&state) % (max + 1);
+
+	for (int y = 0; y < spec->height; y++)
+	{
+		for (int x = 0; x < spec->width; x++)
+		{
+			int dx = x - cx;
+			int dy = y - cy;
+			int inside = dx * dx + dy * dy < radius * radius;
+			uint64_t noise = xorshift64(&state);
+			for (int c = 0; c < spec->channels; c++)
+			{
+				/* Gradient, a bright disc and a few levels of noise per channel */
+				long value = phase + (long)x * max / (2 * spec->width) + (long)y * max / (3 * spec->height) + c * max / 7;
+				if (inside)
+					value += max / 3;
+				value += (long)((noise >> (c * 8)) & 0xFF) * max / 4096;
+				value %= max + 1;
+
+				size_t i = ((size_t)y * spec->width + x) * spec->channels + c;
+				if (bytes == 2)
+					((uint16_t *)pixels)[i] = value;
+				else
+					pixels[i] = value;
+			}
+		}
+	}
+	return pixels;
+}
+
+uint8_t *corpus_encode_jxl(const uint8_t *pixels, const corpus_spec_t *spec, size_t *size)
+{
+	JxlEncoder *encoder = JxlEncoderCreate(NULL);
+	if (encoder == NULL)
+		return NULL;
+
+	int lossless = spec->distance <= 0;
+	JxlBasicInfo info;
+	JxlEncoderInitBasicInfo(&info);
+	info.xsize = spec->width;
+	info.ysize = spec->height;
+	info.bits_per_sample = spec->bits_pixel;
+	info.num_color_channels = spec->channels;
+	info.uses_original_profile = lossless;
+	JxlColorEncoding color;
+	JxlColorEncodingSetToSRGB(&color, spec->channels == 1);
+	JxlPixelFormat format = {spec->channels, spec->bits_pixel > 8 ? JXL_TYPE_UINT16 : JXL_TYPE_UINT8, JXL_NATIVE_ENDIAN, 0};
+	size_t pixels_size = (size_t)spec->width * spec->height * spec->channels * (spec->bits_pixel > 8 ? 2 : 1);
+
+	JxlEncoderFrameSettings *settings = NULL;
+	if (JxlEncoderSetBasicInfo(encoder, &info) == JXL_ENC_SUCCESS && JxlEncoderSetColorEncoding(encoder, &color) == JXL_ENC_SUCCESS)
+		settings = JxlEncoderFrameSettingsCreate(encoder, NULL);
+	int configured = settings != NULL;
+	if (configured && lossless)
+		configured = JxlEncoderSetFrameLossless(settings, 1) == JXL_ENC_SUCCESS;
+	else if (configured)
+		configured = JxlEncoderSetFrameDistance(settings, spec->distance) == JXL_ENC_SUCCESS;
+	if (configured && spec->effort > 0)
+		configured = JxlEncoderFrameSettingsSetOption(settings, JXL_ENC_FRAME_SETTING_EFFORT, spec->effort) == JXL_ENC_SUCCESS;
+	if (!configured || JxlEncoderAddImageFrame(settings, &format, pixels, pixels_size) != JXL_ENC_SUCCESS)
+	{
+		fprintf(stderr, "Error: Could not set up JXL encoding of %dx%dx%d frame\n", spec->width, spec->height, spec->channels);
+		JxlEncoderDestroy(encoder);
+		return NULL;
+	}
+	JxlEncoderCloseInput(encoder);
+
+	size_t cap = 65536;
+	uint8_t *out = malloc(cap);
+	uint8_t *next = out;
+	size_t avail = cap;
+	JxlEncoderStatus status = out != NULL ? JxlEncoderProcessOutput(encoder, &next, &avail) : JXL_ENC_ERROR;
+	while (status == JXL_ENC_NEED_MORE_OUTPUT)
+	{
+		size_t used = next - out;
+		uint8_t *grown = realloc(out, cap * 2);
+		if (grown == NULL)
+		{
+			status = JXL_ENC_ERROR;
+			break;
+		}
+		out = grown;
+		cap *= 2;
+		next = out + used;
+		avail = cap - used;
+		status = JxlEncoderProcessOutput(encoder, &next, &avail);
+	}
+	JxlEncoderDestroy(encoder);
+
+	if (status != JXL_ENC_SUCCESS)
+	{
+		fprintf(stderr, "Error: JXL encoding failed\n");
+		free(out);
+		return NULL;
+	}
+	*size = next - out;
+	return out;
+}
+
+uint8_t *corpus_entry(const corpus_spec_t *spec, uint64_t seed, size_t *size)
+{
+	size_t pixels_size;
+	uint8_t *pixels = corpus_pixels(spec, seed, &pixels_size);
+	if (pixels == NULL)
+		return NULL;
+
+	uint8_t *payload = pixels;
+	size_t payload_size = pixels_size;
+	if (spec->jxl)
+	{
+		payload = corpus_encode_jxl(pixels, spec, &payload_size);
+		free(pixels);
+		if (payload == NULL)
+			return NULL;
+	}
+
+	MetadataItem enc = METADATA_ITEM__INIT;
+	enc.key = "enc";
+	enc.value_case = METADATA_ITEM__VALUE_STRING_VALUE;
+	enc.string_value = "jxl";
+	MetadataItem seed_item = METADATA_ITEM__INIT;
+	seed_item.key = "seed";
+	seed_item.value_case = METADATA_ITEM__VALUE_INT_VALUE;
+	seed_item.int_value = (int32_t)seed;
+	MetadataItem *items[] = {&seed_item, &enc};
+
+	Metadata meta = METADATA__INIT;
+	meta.size = payload_size;
+	meta.width = spec->width;
+	meta.height = spec->height;
+	meta.channels = spec->channels;
+	meta.bits_pixel = spec->bits_pixel;
+	meta.timestamp = spec->timestamp;
+	meta.camera = (char *)(spec->camera != NULL ? spec->camera : "synthetic");
+	meta.items = items;
+	meta.n_items = spec->jxl ? 2 : 1;
+
+	uint32_t metadata_size = metadata__get_packed_size(&meta);
+	*size = sizeof(uint32_t) + metadata_size + payload_size;
+	uint8_t *entry = malloc(*size);
+	if (entry != NULL)
+	{
+		memcpy(entry, &metadata_size, sizeof(uint32_t));
+		metadata__pack(&meta, entry + sizeof(uint32_t));
+		memcpy(entry + sizeof(uint32_t) + metadata_size, payload, payload_size);
+	}
+	free(payload);
+	return entry;
+}
@@ -0,0 +1,41 @@
+#ifndef CORPUS_H
+#define CORPUS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Synthetic observations for benchmarks and the stand-in node.
+ *
+ * Frames are smooth gradients with a few shapes and sensor-like noise, so
+ * they compress like camera frames rather than like random data. The same
+ * spec and seed always give the same bytes.
+ *
+ * A ring entry has the layout ippb reads from the ring buffer:
+ *   [0..3]  length of the packed Metadata, native endian
+ *   [4..]   packed Metadata
+ *   [..]    payload, JXL or raw pixels
+ */
+typedef struct
+{
+	int width;
+	int height;
+	int channels;	// 1 or 3
+	int bits_pixel; // 8 or 16
+	int jxl;		// encode the payload with JXL, otherwise raw pixels
+	float distance; // JXL butteraugli distance, 0 for lossless
+	int effort;		// JXL effort 1-9, 0 for the encoder default
+	const char *camera;
+	int32_t timestamp;
+} corpus_spec_t;
+
+/* Raw pixels of a frame, interleaved, 16 bit samples in native endian */
+uint8_t *corpus_pixels(const corpus_spec_t *spec, uint64_t seed, size_t *size);
+
+/* JXL encode raw pixels of the given spec */
+uint8_t *corpus_encode_jxl(const uint8_t *pixels, const corpus_spec_t *spec, size_t *size);
+
+/* A complete ring entry of a generated frame */
+uint8_t *corpus_entry(const corpus_spec_t *spec, uint64_t seed, size_t *size);
+
+#endif
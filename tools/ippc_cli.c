@@ -0,0 +1,679 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <time.h>
+
+#include <csp/csp.h>
+#include <csp/interfaces/csp_if_zmqhub.h>
+#include <vmem/vmem_client.h>
+
+#include "ippc.h"
+#include "module_schema.h"
+#include "config_cache.h"
+#include "fleet.h"
+#include "profile.h"
+#include "cli_parse.h"
+
+/*
+ * Standalone ippc and ippb commands, for scripts.
+ *
+ * Joins a ZMQ hub once and runs the command given on the command line, or
+ * with -b every command read from stdin, one per line, in the same CSP
+ * session, which keeps the download buffers from one command to the next.
+ * Subcommands and options are those of the CSH commands. With -j every
+ * command prints one JSON object on stdout, holding its result, its output
+ * and its errors.
+ */
+#define CLI_LINE_MAX 4096
+#define CLI_ARGS_MAX 64
+#define CLI_OPTIONS_MAX 24
+
+typedef struct
+{
+	ippc_t *ippc;
+	unsigned int node;
+	int node_given; // -n of the command, which cannot be combined with -N
+	unsigned int timeout;
+	unsigned int paramver;
+	int ack_with_pull;
+	int profile;
+	char *trace;
+	char *node_list;
+	unsigned int retries;
+	int tagged;
+	int diff;
+	char *upload;
+	char *schema;
+	int compact;
+	unsigned int pipeline_id;
+	unsigned int module_id;
+	int save_png;
+	int front;
+	unsigned int count;
+	char *where;
+	char *ring_list;
+	char *cursor_file;
+	unsigned int per_node;
+	unsigned int per_link;
+	unsigned int stats_node;
+	int json;
+	int clear;
+} cli_args_t;
+
+typedef enum
+{
+	OPT_SET,
+	OPT_CLEAR,
+	OPT_UNSIGNED,
+	OPT_STRING,
+} cli_option_kind_t;
+
+typedef struct
+{
+	char flag;
+	const char *name;
+	cli_option_kind_t kind;
+	size_t offset;
+	const char *help;
+} cli_option_t;
+
+#define OPT(flag, name, kind, field, help) {flag, name, kind, offsetof(cli_args_t, field), help}
+
+#define OPTS_PROFILE                                                                 \
+	OPT('P', "profile", OPT_SET, profile, "print time and throughput of every phase"), \
+		OPT('T', "trace", OPT_STRING, trace, "write every phase to FILE as a Chrome trace")
+#define OPTS_NODE                                                                       \
+	OPT('n', "node", OPT_UNSIGNED, node, "node (default = -n of ippc)"),                \
+		OPT('t', "timeout", OPT_UNSIGNED, timeout, "timeout (default = -t of ippc)"), \
+		OPT('v', "paramver", OPT_UNSIGNED, paramver, "parameter system version (default = 2)")
+#define OPTS_PUSH                                                                                      \
+	OPT('a', "no_ack_push", OPT_CLEAR, ack_with_pull, "disable ack with param push queue"),            \
+		OPT('d', "diff", OPT_SET, diff, "pull the current configuration and only push if it differs"), \
+		OPT('N', "nodes", OPT_STRING, node_list, "comma separated nodes to configure concurrently"),   \
+		OPT('r', "retries", OPT_UNSIGNED, retries, "retries per node (default = 0)")
+#define OPTS_DOWNLOAD                                                                                      \
+	OPT('s', "save_png", OPT_SET, save_png, "save downloaded data as png"),                                \
+		OPT('w', "where", OPT_STRING, where, "only decode and save entries whose metadata matches EXPR"), \
+		OPT('N', "nodes", OPT_STRING, node_list, "comma separated nodes to download from"),              \
+		OPT('R', "rings", OPT_STRING, ring_list, "comma separated ring buffers (default = images)"),     \
+		OPT('p', "per_node", OPT_UNSIGNED, per_node, "concurrent transfers per node (default = 1)"),     \
+		OPT('l', "per_link", OPT_UNSIGNED, per_link, "concurrent transfers in total (default = 4)")
+
+typedef struct
+{
+	const char *name;
+	int (*run)(cli_args_t *args, char **pos);
+	int positional;
+	const char *usage;
+	const char *help;
+	cli_option_t options[CLI_OPTIONS_MAX];
+} cli_command_t;
+
+static ippc_push_opts_t push_opts(const cli_args_t *args)
+{
+	ippc_push_opts_t push = {.timeout = args->timeout, .paramver = args->paramver, .ack_with_pull = args->ack_with_pull, .diff = args->diff, .retries = args->retries};
+	return push;
+}
+
+static ippc_compile_opts_t compile_opts(const cli_args_t *args)
+{
+	ippc_compile_opts_t compile = {.schema = args->schema, .compact = args->compact, .tagged = args->tagged, .upload = args->upload};
+	return compile;
+}
+
+static ippc_download_opts_t download_opts(const cli_args_t *args)
+{
+	ippc_download_opts_t opts = {
+		.timeout = args->timeout,
+		.rings = args->ring_list,
+		.where = args->where,
+		.save_png = args->save_png,
+		.per_node = args->per_node,
+		.per_link = args->per_link,
+	};
+	return opts;
+}
+
+static int run_pipeline(cli_args_t *args, char **pos)
+{
+	unsigned int nodes[FLEET_MAX_NODES];
+	int node_count = ippc_resolve_nodes(args->node_list, args->node, args->node_given, nodes);
+	if (node_count < 0)
+		return IPPC_EINVAL;
+	ippc_compile_opts_t compile = compile_opts(args);
+	ippc_push_opts_t push = push_opts(args);
+	return ippc_configure_pipeline(atoi(pos[0]), pos[1], &compile, &push, nodes, node_count);
+}
+
+static int run_module(cli_args_t *args, char **pos)
+{
+	unsigned int nodes[FLEET_MAX_NODES];
+	int node_count = ippc_resolve_nodes(args->node_list, args->node, args->node_given, nodes);
+	if (node_count < 0)
+		return IPPC_EINVAL;
+	ippc_compile_opts_t compile = compile_opts(args);
+	ippc_push_opts_t push = push_opts(args);
+	return ippc_configure_module(atoi(pos[0]), pos[1], &compile, &push, nodes, node_count);
+}
+
+static int run_apply(cli_args_t *args, char **pos)
+{
+	unsigned int nodes[FLEET_MAX_NODES];
+	int node_count = ippc_resolve_nodes(args->node_list, args->node, args->node_given, nodes);
+	if (node_count < 0)
+		return IPPC_EINVAL;
+	ippc_compile_opts_t compile = compile_opts(args);
+	ippc_push_opts_t push = push_opts(args);
+	return ippc_apply(pos[0], &compile, &push, nodes, node_count);
+}
+
+static int run_status(cli_args_t *args, char **pos)
+{
+	return ippc_status(args->node, args->timeout, args->paramver);
+}
+
+static int run_save(cli_args_t *args, char **pos)
+{
+	return ippc_save(pos[0], args->node, args->timeout, args->paramver);
+}
+
+static int run_restore(cli_args_t *args, char **pos)
+{
+	ippc_push_opts_t push = push_opts(args);
+	return ippc_restore(pos[0], args->node, &push);
+}
+
+static int run_push_bin(cli_args_t *args, char **pos)
+{
+	ippc_push_opts_t push = push_opts(args);
+	return ippc_push_bin(pos[0], args->node, &push);
+}
+
+static int run_compile(cli_args_t *args, char **pos)
+{
+	ippc_compile_opts_t compile = compile_opts(args);
+	return ippc_compile(pos[0], pos[1], args->pipeline_id, args->module_id, &compile);
+}
+
+static int run_schema(cli_args_t *args, char **pos)
+{
+	module_schema_print();
+	return IPPC_OK;
+}
+
+static int run_cache(cli_args_t *args, char **pos)
+{
+	if (!args->clear)
+	{
+		config_cache_list();
+		return IPPC_OK;
+	}
+	int removed = config_cache_clear();
+	if (removed < 0)
+	{
+		printf("Could not clear cache\n");
+		return IPPC_EIO;
+	}
+	printf("Removed %d cached compilations\n", removed);
+	return IPPC_OK;
+}
+
+static int run_stats(cli_args_t *args, char **pos)
+{
+	return ippc_link_stats(args->stats_node, args->json, args->clear);
+}
+
+static int run_get(cli_args_t *args, char **pos)
+{
+	unsigned int nodes[FLEET_MAX_NODES];
+	int node_count = ippc_resolve_nodes(args->node_list, args->node, args->node_given, nodes);
+	if (node_count < 0)
+		return IPPC_EINVAL;
+	ippc_download_opts_t opts = download_opts(args);
+	return ippc_buffer_get(args->ippc, atoi(pos[0]), args->front, args->count, nodes, node_count, &opts);
+}
+
+static int run_rings(cli_args_t *args, char **pos)
+{
+	/* Ring buffers are vmem areas of the node */
+	vmem_client_list(args->node, args->timeout, 2);
+	return IPPC_OK;
+}
+
+static int run_sync(cli_args_t *args, char **pos)
+{
+	unsigned int nodes[FLEET_MAX_NODES];
+	int node_count = ippc_resolve_nodes(args->node_list, args->node, args->node_given, nodes);
+	if (node_count < 0)
+		return IPPC_EINVAL;
+	ippc_download_opts_t opts = download_opts(args);
+	return ippc_buffer_sync(args->ippc, args->cursor_file, args->count, nodes, node_count, &opts);
+}
+
+static const cli_command_t commands[] = {
+	{"pipeline", run_pipeline, 2, "<pipeline-idx> <config-file>", "Configure a specific pipeline", {
+		OPTS_PROFILE, OPTS_NODE, OPTS_PUSH,
+		OPT('b', "best", OPT_SET, tagged, "send the smallest of all encodings, tagged"),
+		OPT('u', "upload", OPT_STRING, upload, "upload configurations too large for a parameter to this vmem address"),
+	}},
+	{"module", run_module, 2, "<module-idx> <config-file>", "Configure a specific module", {
+		OPTS_PROFILE, OPTS_NODE, OPTS_PUSH,
+		OPT('s', "schema", OPT_STRING, schema, "module schema used to infer types and compact keys"),
+		OPT('k', "compact", OPT_SET, compact, "replace keys known by the schema with their id"),
+		OPT('b', "best", OPT_SET, tagged, "send the smallest of all encodings, tagged"),
+		OPT('u', "upload", OPT_STRING, upload, "upload configurations too large for a parameter to this vmem address"),
+	}},
+	{"apply", run_apply, 1, "<manifest-file>", "Configure pipelines and modules listed in a manifest", {
+		OPTS_PROFILE, OPTS_NODE, OPTS_PUSH,
+		OPT('k', "compact", OPT_SET, compact, "replace keys known by the module schemas with their id"),
+		OPT('b', "best", OPT_SET, tagged, "send the smallest of all encodings, tagged"),
+	}},
+	{"status", run_status, 0, "", "Show pipeline and module configurations on a node", {
+		OPTS_PROFILE, OPTS_NODE,
+	}},
+	{"save", run_save, 1, "<bundle-file>", "Save pipeline and module configurations of a node to a bundle", {
+		OPTS_PROFILE, OPTS_NODE,
+	}},
+	{"restore", run_restore, 1, "<bundle-file>", "Push the configurations of a bundle to a node, clearing those it does not hold", {
+		OPTS_PROFILE, OPTS_NODE,
+		OPT('a', "no_ack_push", OPT_CLEAR, ack_with_pull, "disable ack with param push queue"),
+	}},
+	{"compile", run_compile, 2, "<config-file> <artifact-file>", "Compile configurations into a binary artifact without contacting a node", {
+		OPTS_PROFILE,
+		OPT('p', "pipeline", OPT_UNSIGNED, pipeline_id, "compile a pipeline configuration for this pipeline index"),
+		OPT('m', "module", OPT_UNSIGNED, module_id, "compile a module configuration for this module index"),
+		OPT('s', "schema", OPT_STRING, schema, "module schema used to infer types and compact keys"),
+		OPT('k', "compact", OPT_SET, compact, "replace keys known by the module schemas with their id"),
+		OPT('b', "best", OPT_SET, tagged, "use the smallest of all encodings, tagged"),
+	}},
+	{"push_bin", run_push_bin, 1, "<artifact-file>", "Push a compiled configuration artifact to a node", {
+		OPTS_PROFILE, OPTS_NODE,
+		OPT('a', "no_ack_push", OPT_CLEAR, ack_with_pull, "disable ack with param push queue"),
+	}},
+	{"schema", run_schema, 0, "", "List module key schemas", {{0}}},
+	{"cache", run_cache, 0, "", "List or clear cached configuration compilations", {
+		OPT('c', "clear", OPT_SET, clear, "remove all cached compilations"),
+	}},
+	{"stats", run_stats, 0, "", "Show download and push statistics per node, kept across sessions", {
+		OPT('n', "node", OPT_UNSIGNED, stats_node, "only show this node (default = all)"),
+		OPT('j', "json", OPT_SET, json, "print the statistics as JSON"),
+		OPT('c', "clear", OPT_SET, clear, "delete the statistics"),
+	}},
+	{"get", run_get, 1, "<offset>", "Fetch entries at <offset> from the ring buffer (0 = oldest, -1 = newest)", {
+		OPTS_PROFILE, OPTS_NODE, OPTS_DOWNLOAD,
+		OPT('f', "front", OPT_SET, front, "index from front/newest image"),
+		OPT('c', "count", OPT_UNSIGNED, count, "number of consecutive entries to fetch (default = 1)"),
+	}},
+	{"rings", run_rings, 0, "", "List the vmem areas of a node, including its ring buffers", {
+		OPT('n', "node", OPT_UNSIGNED, node, "node (default = -n of ippc)"),
+		OPT('t', "timeout", OPT_UNSIGNED, timeout, "timeout (default = -t of ippc)"),
+	}},
+	{"sync", run_sync, 0, "", "Download the entries added to the ring buffers since the last sync", {
+		OPTS_PROFILE, OPTS_NODE, OPTS_DOWNLOAD,
+		OPT('c', "count", OPT_UNSIGNED, count, "newest entries to check per node and ring (default = 10)"),
+		OPT('C', "cursors", OPT_STRING, cursor_file, "cursor file (default = ippb_cursors.txt)"),
+	}},
+};
+
+#define CLI_COMMAND_COUNT (int)(sizeof(commands) / sizeof(commands[0]))
+
+static void usage(const char *name)
+{
+	printf("Usage: %s [options] <command> [command options...] [arguments...]\n", name);
+	printf("       %s [options] -b < commands.txt\n", name);
+	printf("  -a ADDR     CSP address of this client (default = 10)\n");
+	printf("  -z HOST     ZMQ hub host (default = localhost)\n");
+	printf("  -n NODE     default node of commands (default = 0)\n");
+	printf("  -t MS       default timeout of commands (default = 1000)\n");
+	printf("  -j          print the result and output of every command as a JSON line\n");
+	printf("  -b          read commands from stdin, one per line\n");
+	printf("\nCommands, see <command> -h for options:\n");
+	for (int i = 0; i < CLI_COMMAND_COUNT; i++)
+		printf("  %-10s %s\n", commands[i].name, commands[i].help);
+}
+
+static void command_usage(const cli_command_t *command)
+{
+	printf("Usage: %s [options] %s\n%s\n", command->name, command->usage, command->help);
+	for (const cli_option_t *opt = command->options; opt->name != NULL; opt++)
+	{
+		char arg[32] = "";
+		if (opt->kind == OPT_UNSIGNED || opt->kind == OPT_STRING)
+			snprintf(arg, sizeof(arg), " %s", opt->kind == OPT_UNSIGNED ? "NUM" : "ARG");
+		char name[48];
+		snprintf(name, sizeof(name), "--%s%s", opt->name, arg);
+		printf("  -%c, %-22s %s\n", opt->flag, name, opt->help);
+	}
+}
+
+/* Parse the options of a command into args, returns the index of the first argument or -1 */
+static int parse_options(const cli_command_t *command, int argc, char **argv, cli_args_t *args)
+{
+	char optstring[3 * CLI_OPTIONS_MAX + 2] = "h";
+	struct option longopts[CLI_OPTIONS_MAX + 2] = {{"help", no_argument, NULL, 'h'}};
+	int count = 1;
+	for (const cli_option_t *opt = command->options; opt->name != NULL; opt++)
+	{
+		int has_arg = opt->kind == OPT_UNSIGNED || opt->kind == OPT_STRING;
+		size_t len = strlen(optstring);
+		optstring[len] = opt->flag;
+		optstring[len + 1] = has_arg ? ':' : '\0';
+		optstring[len + 2] = '\0';
+		longopts[count++] = (struct option){opt->name, has_arg ? required_argument : no_argument, NULL, opt->flag};
+	}
+	longopts[count] = (struct option){0};
+
+	/* Reinitialize getopt for every command of a batch */
+	optind = 0;
+	int c;
+	while ((c = getopt_long(argc, argv, optstring, longopts, NULL)) != -1)
+	{
+		const cli_option_t *opt = command->options;
+		while (opt->name != NULL && opt->flag != c)
+			opt++;
+		if (opt->name == NULL)
+		{
+			command_usage(command);
+			return -1;
+		}
+
+		void *field = (char *)args + opt->offset;
+		switch (opt->kind)
+		{
+			case OPT_SET:
+				*(int *)field = 1;
+				break;
+			case OPT_CLEAR:
+				*(int *)field = 0;
+				break;
+			case OPT_UNSIGNED:
+				*(unsigned int *)field = strtoul(optarg, NULL, 0);
+				if (opt->offset == offsetof(cli_args_t, node))
+					args->node_given = 1;
+				break;
+			case OPT_STRING:
+				*(char **)field = optarg;
+				break;
+		}
+	}
+
+	if (argc - optind < command->positional)
+	{
+		command_usage(command);
+		return -1;
+	}
+	return optind;
+}
+
+static const char *error_name(int ret)
+{
+	switch (ret)
+	{
+		case IPPC_OK:
+			return "ok";
+		case IPPC_EIO:
+			return "io";
+		case IPPC_ENOMEM:
+			return "nomem";
+		default:
+			return "invalid";
+	}
+}
+
+static double now_ms(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+typedef struct
+{
+	ippc_t *ippc;
+	unsigned int node;
+	unsigned int timeout;
+	FILE *json; // result lines, NULL for plain output
+} cli_session_t;
+
+/* Output of a file descriptor redirected into a temporary file */
+typedef struct
+{
+	int fd;
+	int saved;
+	FILE *file;
+} cli_capture_t;
+
+static int capture_start(cli_capture_t *capture, int fd)
+{
+	capture->fd = fd;
+	capture->file = tmpfile();
+	capture->saved = capture->file != NULL ? dup(fd) : -1;
+	if (capture->saved < 0 || dup2(fileno(capture->file), fd) < 0)
+	{
+		if (capture->saved >= 0)
+			close(capture->saved);
+		if (capture->file != NULL)
+			fclose(capture->file);
+		return -1;
+	}
+	return 0;
+}
+
+/* Restore the file descriptor and return what was written to it, to free */
+static char *capture_end(cli_capture_t *capture, size_t *size)
+{
+	dup2(capture->saved, capture->fd);
+	close(capture->saved);
+
+	long length = ftell(capture->file);
+	char *data = length > 0 ? malloc(length) : NULL;
+	rewind(capture->file);
+	*size = data != NULL ? fread(data, 1, length, capture->file) : 0;
+	fclose(capture->file);
+	return data;
+}
+
+/* Run one command, argv[0] is its name */
+static int run_command(const cli_session_t *session, int argc, char **argv, int line)
+{
+	const cli_command_t *command = NULL;
+	for (int i = 0; i < CLI_COMMAND_COUNT && command == NULL; i++)
+	{
+		if (strcmp(commands[i].name, argv[0]) == 0)
+			command = &commands[i];
+	}
+
+	/* Capture the output and errors of the command, including those of its worker threads */
+	cli_capture_t out;
+	cli_capture_t err;
+	if (session->json != NULL)
+	{
+		fflush(stdout);
+		fflush(stderr);
+		if (capture_start(&out, STDOUT_FILENO) < 0)
+		{
+			fprintf(stderr, "Error: Could not capture command output\n");
+			return IPPC_EIO;
+		}
+		if (capture_start(&err, STDERR_FILENO) < 0)
+		{
+			size_t size;
+			free(capture_end(&out, &size));
+			fprintf(stderr, "Error: Could not capture command errors\n");
+			return IPPC_EIO;
+		}
+	}
+
+	double start = now_ms();
+	int ret = IPPC_EINVAL;
+	if (command == NULL)
+	{
+		printf("Unknown command %s\n", argv[0]);
+	}
+	else
+	{
+		cli_args_t args = {
+			.ippc = session->ippc,
+			.node = session->node,
+			.timeout = session->timeout,
+			.paramver = 2,
+			.ack_with_pull = 1,
+			.count = strcmp(command->name, "sync") == 0 ? 10 : 1,
+			.cursor_file = "ippb_cursors.txt",
+			.per_node = 1,
+			.per_link = 4,
+		};
+		ippc_begin();
+		int argi = parse_options(command, argc, argv, &args);
+		if (argi >= 0)
+		{
+			if (args.profile)
+				profile_enable();
+			if (args.trace)
+				profile_trace(args.trace);
+			ret = command->run(&args, argv + argi);
+		}
+		ippc_end();
+	}
+	double elapsed = now_ms() - start;
+
+	if (session->json == NULL)
+		return ret;
+
+	fflush(stdout);
+	fflush(stderr);
+	size_t output_size;
+	size_t error_size;
+	char *output = capture_end(&out, &output_size);
+	char *error = capture_end(&err, &error_size);
+
+	fprintf(session->json, "{\"command\":");
+	cli_json_string(session->json, argv[0], strlen(argv[0]));
+	if (line > 0)
+		fprintf(session->json, ",\"line\":%d", line);
+	fprintf(session->json, ",\"status\":\"%s\",\"ms\":%.3f,\"output\":", error_name(ret), elapsed);
+	cli_json_string(session->json, output != NULL ? output : "", output_size);
+	fprintf(session->json, ",\"error\":");
+	cli_json_string(session->json, error != NULL ? error : "", error_size);
+	fprintf(session->json, "}\n");
+	fflush(session->json);
+	free(output);
+	free(error);
+	return ret;
+}
+
+/* Run every command of stdin, returns the number of failed commands */
+static int run_batch(const cli_session_t *session)
+{
+	char line[CLI_LINE_MAX];
+	int failed = 0;
+	for (int number = 1; fgets(line, sizeof(line), stdin) != NULL; number++)
+	{
+		char *argv[CLI_ARGS_MAX];
+		int argc = cli_split_line(line, argv, CLI_ARGS_MAX);
+		if (argc < 0)
+		{
+			fprintf(stderr, "Error: Line %d has an open quote or too many arguments\n", number);
+			failed++;
+			continue;
+		}
+		if (argc == 0)
+			continue;
+		argv[argc] = NULL;
+		if (run_command(session, argc, argv, number) != IPPC_OK)
+			failed++;
+	}
+	return failed;
+}
+
+static void *router_task(void *arg)
+{
+	while (1)
+		csp_route_work();
+	return NULL;
+}
+
+int main(int argc, char **argv)
+{
+	unsigned int addr = 10;
+	const char *host = "localhost";
+	int json = 0;
+	int batch = 0;
+	cli_session_t session = {.node = 0, .timeout = 1000};
+
+	/* Options up to the command belong to ippc */
+	int opt;
+	while ((opt = getopt(argc, argv, "+a:z:n:t:jbh")) != -1)
+	{
+		switch (opt)
+		{
+			case 'a':
+				addr = atoi(optarg);
+				break;
+			case 'z':
+				host = optarg;
+				break;
+			case 'n':
+				session.node = atoi(optarg);
+				break;
+			case 't':
+				session.timeout = atoi(optarg);
+				break;
+			case 'j':
+				json = 1;
+				break;
+			case 'b':
+				batch = 1;
+				break;
+			default:
+				usage(argv[0]);
+				return 1;
+		}
+	}
+	if (batch == (optind < argc))
+	{
+		usage(argv[0]);
+		return 1;
+	}
+
+	csp_conf.hostname = "ippc";
+	csp_conf.model = "ippc";
+	csp_init();
+
+	csp_iface_t *iface = NULL;
+	if (csp_zmqhub_init(addr, host, 0, &iface) != CSP_ERR_NONE)
+	{
+		fprintf(stderr, "Error: Could not connect to the ZMQ hub at %s\n", host);
+		return 1;
+	}
+	csp_rtable_set(0, 0, iface, CSP_NO_VIA_ADDRESS);
+	csp_bind_callback(csp_service_handler, CSP_ANY);
+
+	pthread_t thread;
+	pthread_create(&thread, NULL, router_task, NULL);
+
+	if (json)
+	{
+		/* Results go to the original stdout, commands print into a capture */
+		session.json = fdopen(dup(STDOUT_FILENO), "w");
+		if (session.json == NULL)
+		{
+			fprintf(stderr, "Error: Could not open JSON output\n");
+			return 1;
+		}
+	}
+
+	/* Without a context downloads still work, with buffers allocated per command */
+	session.ippc = ippc_init();
+	int ret;
+	if (batch)
+		ret = run_batch(&session) > 0 ? 1 : 0;
+	else
+		ret = run_command(&session, argc - optind, argv + optind, 0) == IPPC_OK ? 0 : 1;
+	ippc_cleanup(session.ippc);
+	return ret;
+}
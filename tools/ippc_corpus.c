@@ -0,0 +1,164 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <time.h>
+
+#include "corpus.h"
+
+/*
+ * Generates ring entries of synthetic observations, one file per entry, in
+ * the layout ippb reads from the ring buffer. The files feed ippc_bench
+ * --corpus and ippc_standin.
+ */
+
+#define CORPUS_SIZES_MAX 16
+
+typedef struct
+{
+	int width;
+	int height;
+} corpus_size_t;
+
+/* Parse "WxH[,WxH...]", returns the number of sizes or -1 */
+static int parse_sizes(char *list, corpus_size_t *sizes)
+{
+	int count = 0;
+	for (char *item = strtok(list, ","); item != NULL; item = strtok(NULL, ","))
+	{
+		if (count == CORPUS_SIZES_MAX || sscanf(item, "%dx%d", &sizes[count].width, &sizes[count].height) != 2 ||
+			sizes[count].width <= 0 || sizes[count].height <= 0)
+			return -1;
+		count++;
+	}
+	return count;
+}
+
+/* Parse "C[,C...]" of 1 or 3 channels, returns the number of entries or -1 */
+static int parse_channels(char *list, int *channels)
+{
+	int count = 0;
+	for (char *item = strtok(list, ","); item != NULL; item = strtok(NULL, ","))
+	{
+		if (count == CORPUS_SIZES_MAX)
+			return -1;
+		channels[count] = atoi(item);
+		if (channels[count] != 1 && channels[count] != 3)
+			return -1;
+		count++;
+	}
+	return count;
+}
+
+static void usage(const char *name)
+{
+	printf("Usage: %s [options] <output-dir>\n", name);
+	printf("  -n NUM      number of entries (default = 16)\n");
+	printf("  -s SEED     seed, entry i uses SEED + i (default = 1)\n");
+	printf("  -r LIST     comma separated frame sizes WxH, used in turn (default = 1024x768)\n");
+	printf("  -C LIST     comma separated channel counts, 1 or 3, used in turn (default = 3)\n");
+	printf("  -b BITS     bits per sample, 8 or 16 (default = 8)\n");
+	printf("  -e ENC      payload encoding, jxl or raw (default = jxl)\n");
+	printf("  -d DIST     JXL distance, 0 for lossless (default = 1.0)\n");
+	printf("  -E EFFORT   JXL effort 1-9 (default = encoder default)\n");
+	printf("  -c NAME     camera name (default = synthetic)\n");
+	printf("  -t TIME     timestamp of the first entry, increasing by one (default = 1700000000)\n");
+}
+
+int main(int argc, char **argv)
+{
+	int count = 16;
+	unsigned long long seed = 1;
+	corpus_size_t sizes[CORPUS_SIZES_MAX] = {{1024, 768}};
+	int size_count = 1;
+	int channels[CORPUS_SIZES_MAX] = {3};
+	int channel_count = 1;
+	corpus_spec_t spec = {.bits_pixel = 8, .jxl = 1, .distance = 1.0f, .camera = "synthetic", .timestamp = 1700000000};
+
+	int opt;
+	while ((opt = getopt(argc, argv, "n:s:r:C:b:e:d:E:c:t:h")) != -1)
+	{
+		switch (opt)
+		{
+			case 'n':
+				count = atoi(optarg);
+				break;
+			case 's':
+				seed = strtoull(optarg, NULL, 0);
+				break;
+			case 'r':
+				size_count = parse_sizes(optarg, sizes);
+				break;
+			case 'C':
+				channel_count = parse_channels(optarg, channels);
+				break;
+			case 'b':
+				spec.bits_pixel = atoi(optarg);
+				break;
+			case 'e':
+				spec.jxl = strcmp(optarg, "jxl") == 0;
+				if (!spec.jxl && strcmp(optarg, "raw") != 0)
+					count = -1;
+				break;
+			case 'd':
+				spec.distance = atof(optarg);
+				break;
+			case 'E':
+				spec.effort = atoi(optarg);
+				break;
+			case 'c':
+				spec.camera = optarg;
+				break;
+			case 't':
+				spec.timestamp = atoi(optarg);
+				break;
+			default:
+				usage(argv[0]);
+				return 1;
+		}
+	}
+	if (optind != argc - 1 || count <= 0 || size_count <= 0 || channel_count <= 0 ||
+		(spec.bits_pixel != 8 && spec.bits_pixel != 16))
+	{
+		usage(argv[0]);
+		return 1;
+	}
+
+	const char *dir = argv[optind];
+	size_t total = 0;
+	struct timespec start;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (int i = 0; i < count; i++)
+	{
+		corpus_spec_t entry_spec = spec;
+		entry_spec.width = sizes[i % size_count].width;
+		entry_spec.height = sizes[i % size_count].height;
+		entry_spec.channels = channels[i % channel_count];
+		entry_spec.timestamp = spec.timestamp + i;
+
+		size_t size;
+		uint8_t *entry = corpus_entry(&entry_spec, seed + i, &size);
+		if (entry == NULL)
+			return 1;
+
+		char path[strlen(dir) + 32];
+		snprintf(path, sizeof(path), "%s/entry_%04d.entry", dir, i);
+		FILE *fh = fopen(path, "wb");
+		int written = fh != NULL && fwrite(entry, 1, size, fh) == size;
+		if (fh != NULL && fclose(fh) != 0)
+			written = 0;
+		free(entry);
+		if (!written)
+		{
+			fprintf(stderr, "Error: Could not write %s\n", path);
+			return 1;
+		}
+		total += size;
+	}
+
+	struct timespec end;
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	double elapsed = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+	printf("Wrote %d entries, %zu bytes, to %s in %.2f s\n", count, total, dir, elapsed);
+	return 0;
+}
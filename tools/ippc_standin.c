@@ -0,0 +1,470 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <time.h>
+
+#include <csp/csp.h>
+#include <csp/interfaces/csp_if_zmqhub.h>
+#include <param/param.h>
+#include <param/param_server.h>
+#include <vmem/vmem.h>
+#include <vmem/vmem_ring.h>
+#include <vmem/vmem_server.h>
+#include <jxl/decode.h>
+
+#include "ippc_params.h"
+#include "metadata.pb-c.h"
+#include "link_model.h"
+
+/*
+ * Stand-in for a DIPP node, for exercising ippc and ippb without hardware.
+ *
+ * Joins a local ZMQ hub (start zmqproxy first) and serves the
+ * pipeline_config_N and module_param_N data parameters and an "images"
+ * ring buffer, filled with the frames of a directory: .jxl files, .raw
+ * files of a given size, or ring entries written by ippc_corpus. Every packet the
+ * stand-in sends can be delayed and limited in bandwidth, to model a link.
+ */
+
+#define STANDIN_RING_SIZE (64 * 1024 * 1024)
+#define STANDIN_RING_ENTRIES 256
+#define STANDIN_FRAMES_MAX 1024
+#define SHAPER_QUEUE 256
+
+#define STANDIN_PARAM(_id, _name) \
+	static uint8_t _name##_data[DATA_PARAM_SIZE]; \
+	PARAM_DEFINE_STATIC_RAM(_id, _name, PARAM_TYPE_DATA, DATA_PARAM_SIZE, 1, PM_CONF, NULL, NULL, _name##_data, "Stand-in configuration");
+
+STANDIN_PARAM(PIPELINE_PARAMID_OFFSET + 0, pipeline_config_1)
+STANDIN_PARAM(PIPELINE_PARAMID_OFFSET + 1, pipeline_config_2)
+STANDIN_PARAM(PIPELINE_PARAMID_OFFSET + 2, pipeline_config_3)
+STANDIN_PARAM(PIPELINE_PARAMID_OFFSET + 3, pipeline_config_4)
+STANDIN_PARAM(PIPELINE_PARAMID_OFFSET + 4, pipeline_config_5)
+STANDIN_PARAM(PIPELINE_PARAMID_OFFSET + 5, pipeline_config_6)
+STANDIN_PARAM(MODULE_PARAMID_OFFSET + 0, module_param_1)
+STANDIN_PARAM(MODULE_PARAMID_OFFSET + 1, module_param_2)
+STANDIN_PARAM(MODULE_PARAMID_OFFSET + 2, module_param_3)
+STANDIN_PARAM(MODULE_PARAMID_OFFSET + 3, module_param_4)
+STANDIN_PARAM(MODULE_PARAMID_OFFSET + 4, module_param_5)
+STANDIN_PARAM(MODULE_PARAMID_OFFSET + 5, module_param_6)
+STANDIN_PARAM(MODULE_PARAMID_OFFSET + 6, module_param_7)
+STANDIN_PARAM(MODULE_PARAMID_OFFSET + 7, module_param_8)
+STANDIN_PARAM(MODULE_PARAMID_OFFSET + 8, module_param_9)
+STANDIN_PARAM(MODULE_PARAMID_OFFSET + 9, module_param_10)
+STANDIN_PARAM(MODULE_PARAMID_OFFSET + 10, module_param_11)
+STANDIN_PARAM(MODULE_PARAMID_OFFSET + 11, module_param_12)
+STANDIN_PARAM(MODULE_PARAMID_OFFSET + 12, module_param_13)
+STANDIN_PARAM(MODULE_PARAMID_OFFSET + 13, module_param_14)
+STANDIN_PARAM(MODULE_PARAMID_OFFSET + 14, module_param_15)
+STANDIN_PARAM(MODULE_PARAMID_OFFSET + 15, module_param_16)
+STANDIN_PARAM(MODULE_PARAMID_OFFSET + 16, module_param_17)
+STANDIN_PARAM(MODULE_PARAMID_OFFSET + 17, module_param_18)
+STANDIN_PARAM(MODULE_PARAMID_OFFSET + 18, module_param_19)
+STANDIN_PARAM(MODULE_PARAMID_OFFSET + 19, module_param_20)
+
+VMEM_DEFINE_RING(images, "images", "", STANDIN_RING_SIZE, STANDIN_RING_ENTRIES);
+
+typedef struct
+{
+	unsigned int width;
+	unsigned int height;
+	unsigned int channels;
+	unsigned int bits_pixel;
+	const char *camera;
+} frame_format_t;
+
+typedef struct
+{
+	uint8_t *data;
+	size_t size;
+	int jxl;
+	frame_format_t format;
+	/* Metadata of ring entry files, data then holds the whole entry */
+	Metadata *meta;
+	uint32_t payload_offset;
+} frame_t;
+
+typedef struct
+{
+	csp_packet_t *packet;
+	uint16_t via;
+	int from_me;
+	uint64_t release;
+} shaped_packet_t;
+
+/* Delays the packets an interface sends, by a fixed latency and the time they take at the given bandwidth */
+typedef struct
+{
+	int (*nexthop)(csp_iface_t *iface, uint16_t via, csp_packet_t *packet, int from_me);
+	link_model_t link;
+	shaped_packet_t queue[SHAPER_QUEUE];
+	int head;
+	int count;
+	pthread_mutex_t lock;
+	pthread_cond_t changed;
+} shaper_t;
+
+static shaper_t shaper = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+	.changed = PTHREAD_COND_INITIALIZER,
+};
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void sleep_until(uint64_t when)
+{
+	struct timespec ts = {.tv_sec = when / 1000000000ULL, .tv_nsec = when % 1000000000ULL};
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) != 0)
+		;
+}
+
+static int shaper_nexthop(csp_iface_t *iface, uint16_t via, csp_packet_t *packet, int from_me)
+{
+	pthread_mutex_lock(&shaper.lock);
+	while (shaper.count == SHAPER_QUEUE)
+		pthread_cond_wait(&shaper.changed, &shaper.lock);
+
+	shaped_packet_t *shaped = &shaper.queue[(shaper.head + shaper.count) % SHAPER_QUEUE];
+	shaped->packet = packet;
+	shaped->via = via;
+	shaped->from_me = from_me;
+	shaped->release = link_model_send(&shaper.link, now_ns(), packet->length);
+	shaper.count++;
+	pthread_cond_broadcast(&shaper.changed);
+	pthread_mutex_unlock(&shaper.lock);
+	return CSP_ERR_NONE;
+}
+
+static void *shaper_task(void *arg)
+{
+	csp_iface_t *iface = arg;
+	pthread_mutex_lock(&shaper.lock);
+	while (1)
+	{
+		while (shaper.count == 0)
+			pthread_cond_wait(&shaper.changed, &shaper.lock);
+		shaped_packet_t shaped = shaper.queue[shaper.head];
+		shaper.head = (shaper.head + 1) % SHAPER_QUEUE;
+		shaper.count--;
+		pthread_cond_broadcast(&shaper.changed);
+		pthread_mutex_unlock(&shaper.lock);
+
+		sleep_until(shaped.release);
+		shaper.nexthop(iface, shaped.via, shaped.packet, shaped.from_me);
+
+		pthread_mutex_lock(&shaper.lock);
+	}
+	return NULL;
+}
+
+static void *router_task(void *arg)
+{
+	while (1)
+		csp_route_work();
+	return NULL;
+}
+
+static void *vmem_server_task(void *arg)
+{
+	vmem_server_loop(arg);
+	return NULL;
+}
+
+static int has_suffix(const char *name, const char *suffix)
+{
+	size_t len = strlen(name);
+	size_t suffix_len = strlen(suffix);
+	return len >= suffix_len && strcmp(name + len - suffix_len, suffix) == 0;
+}
+
+/* Read the dimensions of a JXL frame from its header */
+static int jxl_format(const uint8_t *data, size_t size, frame_format_t *format)
+{
+	JxlDecoder *decoder = JxlDecoderCreate(NULL);
+	JxlBasicInfo info;
+	int ret = -1;
+	if (decoder != NULL && JxlDecoderSubscribeEvents(decoder, JXL_DEC_BASIC_INFO) == JXL_DEC_SUCCESS &&
+		JxlDecoderSetInput(decoder, data, size) == JXL_DEC_SUCCESS && JxlDecoderProcessInput(decoder) == JXL_DEC_BASIC_INFO &&
+		JxlDecoderGetBasicInfo(decoder, &info) == JXL_DEC_SUCCESS)
+	{
+		format->width = info.xsize;
+		format->height = info.ysize;
+		format->channels = info.num_color_channels + (info.alpha_bits > 0);
+		format->bits_pixel = info.bits_per_sample;
+		ret = 0;
+	}
+	JxlDecoderDestroy(decoder);
+	return ret;
+}
+
+/* Check the layout of a ring entry file and keep its metadata */
+static int parse_entry(frame_t *frame)
+{
+	uint32_t metadata_size;
+	if (frame->size < sizeof(uint32_t))
+		return -1;
+	memcpy(&metadata_size, frame->data, sizeof(uint32_t));
+	if (metadata_size > frame->size - sizeof(uint32_t))
+		return -1;
+	frame->meta = metadata__unpack(NULL, metadata_size, frame->data + sizeof(uint32_t));
+	frame->payload_offset = sizeof(uint32_t) + metadata_size;
+	if (frame->meta == NULL || (size_t)frame->meta->size != frame->size - frame->payload_offset)
+		return -1;
+	return 0;
+}
+
+static int compare_names(const void *a, const void *b)
+{
+	return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+/* Load the .jxl frames of a directory, and the .raw frames when their format is given */
+static int load_frames(const char *dir, const frame_format_t *raw, frame_t *frames)
+{
+	DIR *dh = opendir(dir);
+	if (dh == NULL)
+	{
+		fprintf(stderr, "Error: Could not open frame directory %s\n", dir);
+		return -1;
+	}
+
+	char *names[STANDIN_FRAMES_MAX];
+	int name_count = 0;
+	struct dirent *entry;
+	while ((entry = readdir(dh)) != NULL && name_count < STANDIN_FRAMES_MAX)
+	{
+		if (has_suffix(entry->d_name, ".jxl") || has_suffix(entry->d_name, ".entry") || (has_suffix(entry->d_name, ".raw") && raw->width > 0))
+			names[name_count++] = strdup(entry->d_name);
+	}
+	closedir(dh);
+	/* Ring order follows the file names */
+	qsort(names, name_count, sizeof(char *), compare_names);
+
+	int count = 0;
+	for (int i = 0; i < name_count; i++)
+	{
+		char path[strlen(dir) + strlen(names[i]) + 2];
+		sprintf(path, "%s/%s", dir, names[i]);
+		FILE *fh = fopen(path, "rb");
+		if (fh == NULL)
+		{
+			fprintf(stderr, "Error: Could not read %s\n", path);
+			continue;
+		}
+		fseek(fh, 0, SEEK_END);
+		long size = ftell(fh);
+		fseek(fh, 0, SEEK_SET);
+
+		frame_t *frame = &frames[count];
+		frame->data = size > 0 ? malloc(size) : NULL;
+		frame->size = size;
+		frame->jxl = has_suffix(names[i], ".jxl");
+		frame->format = *raw;
+		int ok = frame->data != NULL && fread(frame->data, 1, size, fh) == (size_t)size;
+		fclose(fh);
+
+		if (ok && has_suffix(names[i], ".entry"))
+			ok = parse_entry(frame) == 0;
+		else if (ok && frame->jxl)
+			ok = jxl_format(frame->data, frame->size, &frame->format) == 0;
+		else if (ok)
+			ok = (size_t)raw->width * raw->height * raw->channels * ((raw->bits_pixel + 7) / 8) == frame->size;
+		if (!ok)
+		{
+			fprintf(stderr, "Error: Skipping %s, it is not a valid frame\n", path);
+			free(frame->data);
+			if (frame->meta != NULL)
+				metadata__free_unpacked(frame->meta, NULL);
+			frame->meta = NULL;
+			continue;
+		}
+		count++;
+	}
+
+	for (int i = 0; i < name_count; i++)
+		free(names[i]);
+	return count;
+}
+
+/* Append a frame to the ring as <metadata size><Metadata><payload>, like the camera pipeline does */
+static int append_frame(const frame_t *frame, int32_t timestamp)
+{
+	MetadataItem enc = METADATA_ITEM__INIT;
+	MetadataItem *items[] = {&enc};
+	Metadata meta = METADATA__INIT;
+	meta.size = frame->size;
+	meta.width = frame->format.width;
+	meta.height = frame->format.height;
+	meta.channels = frame->format.channels;
+	meta.bits_pixel = frame->format.bits_pixel;
+	meta.timestamp = timestamp;
+	meta.camera = (char *)frame->format.camera;
+	if (frame->jxl)
+	{
+		enc.key = "enc";
+		enc.value_case = METADATA_ITEM__VALUE_STRING_VALUE;
+		enc.string_value = "jxl";
+		meta.n_items = 1;
+		meta.items = items;
+	}
+
+	const uint8_t *payload = frame->data;
+	size_t payload_size = frame->size;
+	if (frame->meta != NULL)
+	{
+		/* Ring entry files keep their metadata, only the timestamp is renewed */
+		meta = *frame->meta;
+		meta.timestamp = timestamp;
+		payload += frame->payload_offset;
+		payload_size -= frame->payload_offset;
+	}
+
+	uint32_t metadata_size = metadata__get_packed_size(&meta);
+	size_t entry_size = sizeof(uint32_t) + metadata_size + payload_size;
+	uint8_t *entry = malloc(entry_size);
+	if (entry == NULL)
+	{
+		fprintf(stderr, "Error: Failed to allocate memory for ring entry\n");
+		return -1;
+	}
+	memcpy(entry, &metadata_size, sizeof(uint32_t));
+	metadata__pack(&meta, entry + sizeof(uint32_t));
+	memcpy(entry + sizeof(uint32_t) + metadata_size, payload, payload_size);
+
+	/* Writes to a ring vmem add a new entry, evicting the oldest when full */
+	vmem_images.write(&vmem_images, 0, entry, entry_size);
+	free(entry);
+	return 0;
+}
+
+static void usage(const char *name)
+{
+	printf("Usage: %s [options] <frame-dir>\n", name);
+	printf("  -a ADDR     CSP address of the stand-in (default = 162)\n");
+	printf("  -z HOST     ZMQ hub host (default = localhost)\n");
+	printf("  -l MS       latency added to every packet sent (default = 0)\n");
+	printf("  -b BYTES    bandwidth of sent packets in bytes per second (default = unlimited)\n");
+	printf("  -i MS       append the next frame again every MS, with a new timestamp (default = off)\n");
+	printf("  -c NAME     camera name in the metadata (default = standin)\n");
+	printf("  -r WxHxC    size of .raw frames, which are skipped unless given\n");
+	printf("  -p BITS     bits per sample of .raw frames (default = 8)\n");
+}
+
+int main(int argc, char **argv)
+{
+	unsigned int addr = 162;
+	const char *host = "localhost";
+	unsigned int latency_ms = 0;
+	unsigned long bandwidth = 0;
+	unsigned int interval_ms = 0;
+	frame_format_t raw = {.bits_pixel = 8, .camera = "standin"};
+
+	int opt;
+	while ((opt = getopt(argc, argv, "a:z:l:b:i:c:r:p:h")) != -1)
+	{
+		switch (opt)
+		{
+			case 'a':
+				addr = atoi(optarg);
+				break;
+			case 'z':
+				host = optarg;
+				break;
+			case 'l':
+				latency_ms = atoi(optarg);
+				break;
+			case 'b':
+				bandwidth = strtoul(optarg, NULL, 10);
+				break;
+			case 'i':
+				interval_ms = atoi(optarg);
+				break;
+			case 'c':
+				raw.camera = optarg;
+				break;
+			case 'r':
+				if (sscanf(optarg, "%ux%ux%u", &raw.width, &raw.height, &raw.channels) != 3)
+				{
+					fprintf(stderr, "Error: Raw frame size must be WxHxC\n");
+					return 1;
+				}
+				break;
+			case 'p':
+				raw.bits_pixel = atoi(optarg);
+				break;
+			default:
+				usage(argv[0]);
+				return 1;
+		}
+	}
+	if (optind != argc - 1)
+	{
+		usage(argv[0]);
+		return 1;
+	}
+
+	frame_t *frames = calloc(STANDIN_FRAMES_MAX, sizeof(frame_t));
+	int frame_count = frames != NULL ? load_frames(argv[optind], &raw, frames) : -1;
+	if (frame_count <= 0)
+	{
+		fprintf(stderr, "Error: No frames found in %s\n", argv[optind]);
+		return 1;
+	}
+
+	csp_conf.hostname = "ippc-standin";
+	csp_conf.model = "DIPP stand-in";
+	csp_init();
+
+	csp_iface_t *iface = NULL;
+	if (csp_zmqhub_init(addr, host, 0, &iface) != CSP_ERR_NONE)
+	{
+		fprintf(stderr, "Error: Could not connect to the ZMQ hub at %s\n", host);
+		return 1;
+	}
+	csp_rtable_set(0, 0, iface, CSP_NO_VIA_ADDRESS);
+
+	pthread_t thread;
+	if (latency_ms > 0 || bandwidth > 0)
+	{
+		shaper.nexthop = iface->nexthop;
+		shaper.link.latency_ns = latency_ms * 1000000ULL;
+		shaper.link.bandwidth = bandwidth;
+		iface->nexthop = shaper_nexthop;
+		pthread_create(&thread, NULL, shaper_task, iface);
+	}
+
+	csp_bind_callback(csp_service_handler, CSP_ANY);
+	csp_bind_callback(param_serve, PARAM_PORT_SERVER);
+	pthread_create(&thread, NULL, router_task, NULL);
+	pthread_create(&thread, NULL, vmem_server_task, NULL);
+
+	int32_t timestamp = time(NULL);
+	for (int i = 0; i < frame_count; i++)
+		append_frame(&frames[i], timestamp);
+	printf("Stand-in node %u serving %d frames in ring 'images'", addr, frame_count);
+	if (latency_ms > 0 || bandwidth > 0)
+		printf(", %u ms latency, %lu bytes/s", latency_ms, bandwidth);
+	printf("\n");
+
+	for (int i = 0;; i = (i + 1) % frame_count)
+	{
+		if (interval_ms == 0)
+		{
+			pause();
+			continue;
+		}
+		usleep(interval_ms * 1000);
+		append_frame(&frames[i], time(NULL));
+	}
+	return 0;
+}
@@ -0,0 +1,11 @@
+#include "link_model.h"
+
+uint64_t link_model_send(link_model_t *link, uint64_t now, size_t bytes)
+{
+	/* Packets leave one after the other, so each waits for the line to be free */
+	if (link->line_free < now)
+		link->line_free = now;
+	if (link->bandwidth > 0)
+		link->line_free += bytes * 1000000000ULL / link->bandwidth;
+	return link->line_free + link->latency_ns;
+}
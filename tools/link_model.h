@@ -0,0 +1,21 @@
+#ifndef LINK_MODEL_H
+#define LINK_MODEL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Link of the stand-in node: packets leave one after the other at the
+ * given bandwidth and arrive a fixed latency after they left.
+ */
+typedef struct
+{
+	uint64_t latency_ns;
+	uint64_t bandwidth; // bytes per second, 0 for unlimited
+	uint64_t line_free; // time the last packet sent has left
+} link_model_t;
+
+/* Time in ns at which a packet of the given size, sent at now, arrives */
+uint64_t link_model_send(link_model_t *link, uint64_t now, size_t bytes);
+
+#endif